@@ -85,6 +85,8 @@ class CodeGenerator:
                 "};  // namespace Cube\n")
 
     def beginBlock(self, f, addr):
+        self.blockAddr = addr
+        self.blockCode = []
         f.write("\nstatic int FASTCALL sbt_block_%04x(em8051 *aCPU)\n"
                 "{\n"
                 "\tunsigned clk = 0;\n"
@@ -92,12 +94,28 @@ class CodeGenerator:
                 % (addr, addr))
 
     def endBlock(self, f):
-        f.write("\taCPU->mPC = pc & PC_MASK;\n"
-                "\treturn clk;\n"
+        f.write("\taCPU->mPC = pc & PC_MASK;\n")
+
+        # Short blocks which may branch back to their own start could be
+        # idle polling loops. Let the emulator look at their code, since
+        # it isn't otherwise available in SBT mode.
+
+        if len(self.blockCode) <= 5 and 'j' in self.opTable[self.lastOpcode]:
+            f.write("\tif (aCPU->mPC == 0x%04x) {\n"
+                    "\t\tstatic const uint8_t code[] = { %s };\n"
+                    "\t\tidle_loop_detect(aCPU, 0x%04x, clk, code, sizeof code);\n"
+                    "\t}\n" % (
+                    self.blockAddr,
+                    ", ".join(["0x%02x" % b for b in self.blockCode]),
+                    self.blockAddr))
+
+        f.write("\treturn clk;\n"
                 "}\n")
         
     def writeInstruction(self, f, bytes):
-        bytes += (0, 0)
+        self.blockCode.extend(bytes)
+        self.lastOpcode = bytes[0]
+        bytes = bytes + [0, 0]
         f.write("\tclk += Opcodes::%-20s(aCPU, pc, 0x%02x,0x%02x,0x%02x);\n" % (
                 self.opTable[bytes[0]], bytes[0], bytes[1], bytes[2]))
 
@@ -0,0 +1,81 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "audio_digest.h"
+
+
+AudioDigest::AudioDigest()
+    : enabled(false), resetPending(false), windowSamples(0),
+      hash(FNV_BASIS), position(0), currentWindowSamples(0) {}
+
+void AudioDigest::start(unsigned windowSamples)
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    // The MC thread picks up the new window length at its next sample
+    this->windowSamples = windowSamples ? windowSamples : 1;
+    windows.clear();
+    resetPending = true;
+    enabled = true;
+}
+
+void AudioDigest::stop()
+{
+    enabled = false;
+}
+
+void AudioDigest::getWindows(std::vector<uint64_t> &out)
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+    out = windows;
+}
+
+void AudioDigest::update(const int16_t *samples, unsigned count)
+{
+    if (resetPending) {
+        tthread::lock_guard<tthread::mutex> guard(lock);
+        currentWindowSamples = windowSamples;
+        hash = FNV_BASIS;
+        position = 0;
+        resetPending = false;
+    }
+
+    while (count--) {
+        uint16_t sample = *(samples++);
+        hash ^= sample & 0xFF;
+        hash *= FNV_PRIME;
+        hash ^= sample >> 8;
+        hash *= FNV_PRIME;
+
+        if (++position == currentWindowSamples) {
+            tthread::lock_guard<tthread::mutex> guard(lock);
+            if (!resetPending)
+                windows.push_back(hash);
+            hash = FNV_BASIS;
+            position = 0;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * A compact fingerprint of the mixed audio output, for regression tests.
+ *
+ * Every sample that the AudioMixer produces is run through a 64-bit
+ * FNV-1a hash, one little-endian byte at a time, restarted at the
+ * beginning of each fixed-length window.
+ * Comparing lists of window hashes is much cheaper than comparing WAV
+ * files, and the first window that differs tells you roughly where in
+ * the audio stream two runs diverged.
+ *
+ * Samples arrive on the MC thread. Completed windows are published
+ * under a lock, so they can be read from the scripting thread at any time.
+ */
+
+#ifndef _AUDIO_DIGEST_H
+#define _AUDIO_DIGEST_H
+
+#include <stdint.h>
+#include <vector>
+#include "macros.h"
+#include "tinythread.h"
+
+
+class AudioDigest
+{
+public:
+    AudioDigest();
+
+    /// Discard any windows so far, and start hashing with a new window length
+    void start(unsigned windowSamples);
+    void stop();
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    unsigned getWindowSamples() const {
+        return windowSamples;
+    }
+
+    /// Copy out the hashes of all windows completed so far
+    void getWindows(std::vector<uint64_t> &out);
+
+    /// Hash some 16-bit mono samples. Only call from the MC thread.
+    ALWAYS_INLINE void write(const int16_t *samples, unsigned count) {
+        if (UNLIKELY(enabled))
+            update(samples, count);
+    }
+
+private:
+    static const uint64_t FNV_BASIS = 0xcbf29ce484222325ULL;
+    static const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+    volatile bool enabled;
+    volatile bool resetPending;
+    unsigned windowSamples;
+
+    // Owned by the MC thread
+    uint64_t hash;
+    unsigned position;
+    unsigned currentWindowSamples;
+
+    tthread::mutex lock;
+    std::vector<uint64_t> windows;
+
+    void update(const int16_t *samples, unsigned count);
+};
+
+
+#endif
@@ -99,9 +99,16 @@ struct em8051
     uint8_t wdsvHigh;           // High half of start value for WDT
     uint8_t wdsvState;          // WDT register state machine
 
+    uint8_t idleCycles;         // Nonzero while parked in a known idle loop
+    uint8_t idleMask;           // Bits of *idleInput that the idle loop depends on
+    uint8_t idleValue;          // Value of those bits when the loop last ran
+
     uint16_t rtc2;              // 16-bit RTC2 counter
     unsigned wdtCounter;        // 24-bit watchdog counter
 
+    unsigned idlePC;            // Head of the current idle loop
+    const uint8_t *idleInput;   // The only byte the idle loop reads
+
     void *callbackData;
 
     em8051operation op[256]; // function pointers to opcode handlers
@@ -147,6 +154,11 @@ int em8051_load(struct em8051 *aCPU, const char *aFilename);
 // Switch to static binary translation mode
 void em8051_init_sbt(struct em8051 *aCPU);
 
+// Called after a basic block or instruction which branched back to itself.
+// Recognizes side-effect-free polling loops; see cube_cpu_core.h.
+void idle_loop_detect(em8051 *aCPU, unsigned pc, unsigned cycles,
+                      const uint8_t *code, unsigned len);
+
 // Internal: Pushes a value into stack
 void em8051_push(struct em8051 *aCPU, int aValue);
 
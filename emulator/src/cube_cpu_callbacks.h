@@ -219,7 +219,37 @@ struct SFR {
 
         }
         
-        return cpu->mSFR[reg];    
+        return cpu->mSFR[reg];
+    }
+
+    static bool isReadPure(int reg)
+    {
+        /*
+         * Is reading this SFR the same as looking at mSFR[reg]? Must list
+         * every register with a special case in readInline(), including the
+         * polling hints, since loops on those are waiting for the hardware.
+         */
+
+        switch (reg) {
+        case REG_SPIRSTAT:
+        case REG_SPIRDAT:
+        case REG_W2DAT:
+        case REG_W2CON1:
+        case REG_MD0:
+        case REG_MD1:
+        case REG_MD2:
+        case REG_MD3:
+        case REG_MD4:
+        case REG_MD5:
+        case REG_ARCON:
+        case REG_CCPDATO:
+        case REG_RNGCTL:
+        case REG_RNGDAT:
+        case BUS_PORT:
+        case REG_WDSV:
+            return false;
+        }
+        return true;
     }
 
     static ALWAYS_INLINE void write(CPU::em8051 *cpu, int reg)
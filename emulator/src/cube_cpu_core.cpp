@@ -35,6 +35,7 @@
 #include "tracer.h"
 #include "cube_debug.h"
 #include "cube_cpu.h"
+#include "cube_cpu_callbacks.h"
 
 namespace Cube {
 namespace CPU {
@@ -84,6 +85,118 @@ NEVER_INLINE void wake_from_sleep(em8051 *aCPU, uint8_t reason)
     aCPU->mSFR[REG_PWRDWN] = reason;
 }
 
+static const uint8_t *idle_loop_direct(em8051 *aCPU, uint8_t addr)
+{
+    /*
+     * Locate a directly-addressed byte that an idle loop may poll, or NULL
+     * if reading it isn't free of side-effects. Internal RAM is only written
+     * by the CPU itself. SFRs are fine as long as reading them doesn't go
+     * through one of the hardware callbacks.
+     */
+
+    if (addr < 0x80)
+        return &aCPU->mData[addr];
+
+    if (!SFR::isReadPure(addr - 0x80))
+        return NULL;
+
+    return &aCPU->mSFR[addr - 0x80];
+}
+
+static const uint8_t *idle_loop_bit(em8051 *aCPU, uint8_t bit)
+{
+    // Byte holding a bit-addressable location, or NULL (as above)
+
+    if (bit < 0x80)
+        return &aCPU->mData[0x20 + (bit >> 3)];
+
+    return idle_loop_direct(aCPU, bit & 0xF8);
+}
+
+NEVER_INLINE void idle_loop_detect(em8051 *aCPU, unsigned pc, unsigned cycles,
+                                   const uint8_t *code, unsigned len)
+{
+    /*
+     * We just ran a basic block (or single instruction) starting at 'pc'
+     * which branched right back to 'pc'. Is it one of the polling loops we
+     * know how to skip? These are the shapes SDCC produces for busy-waiting
+     * on a flag, register bit, or byte:
+     *
+     *    sjmp  $
+     *    jz    $                 jnz   $
+     *    jb    bit, $            jnb   bit, $
+     *    mov   a, direct  /  jz or jnz back to the mov
+     *    mov   a, direct  /  jb or jnb acc.n back to the mov
+     *
+     * Each has no side-effects except recomputing ACC and PC, and its
+     * outcome is a function of exactly one input byte. The loop has been
+     * taken once already, so as long as that byte holds its value and no
+     * interrupt intervenes, every following iteration is identical.
+     *
+     * On a match, record enough to re-validate later in idle_loop_valid().
+     * Otherwise leave idleCycles at zero.
+     */
+
+    const uint8_t *input;
+    uint8_t mask;
+
+    if (len < 2 || !cycles || cycles > 0xFF)
+        return;
+
+    switch (code[0]) {
+
+    case 0x80:  // sjmp $
+        if (code[1] != 0xFE)
+            return;
+        input = &aCPU->mSFR[REG_ACC];
+        mask = 0;
+        break;
+
+    case 0x60:  // jz $
+    case 0x70:  // jnz $
+        if (code[1] != 0xFE)
+            return;
+        input = &aCPU->mSFR[REG_ACC];
+        mask = 0xFF;
+        break;
+
+    case 0x20:  // jb bit, $
+    case 0x30:  // jnb bit, $
+        if (len < 3 || code[2] != 0xFD)
+            return;
+        input = idle_loop_bit(aCPU, code[1]);
+        mask = 1 << (code[1] & 7);
+        break;
+
+    case 0xE5:  // mov a, direct
+        if (len < 4 || code[1] == 0xE0)
+            return;
+        if ((code[2] == 0x60 || code[2] == 0x70) && code[3] == 0xFC) {
+            // jz / jnz
+        } else if ((code[2] == 0x20 || code[2] == 0x30) && len >= 5
+                   && (code[3] & 0xF8) == 0xE0 && code[4] == 0xFB) {
+            // jb / jnb acc.n
+        } else {
+            return;
+        }
+        input = idle_loop_direct(aCPU, code[1]);
+        mask = 0xFF;
+        break;
+
+    default:
+        return;
+    }
+
+    if (!input)
+        return;
+
+    aCPU->idlePC = pc;
+    aCPU->idleInput = input;
+    aCPU->idleMask = mask;
+    aCPU->idleValue = *input & mask;
+    aCPU->idleCycles = cycles;
+}
+
 int em8051_decode(em8051 *aCPU, int aPosition, char *aBuffer)
 {
     return aCPU->dec[aCPU->mCodeMem[aPosition & PC_MASK]](aCPU, aPosition, aBuffer);
@@ -136,6 +249,7 @@ void em8051_reset(em8051 *aCPU, int aWipe)
     // Clean internal variables
     aCPU->irq_count = 0;
     aCPU->needInterruptDispatch = false;
+    aCPU->idleCycles = 0;
 }
 
 static int readbyte(FILE * f)
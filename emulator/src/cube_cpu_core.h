@@ -63,6 +63,28 @@ static ALWAYS_INLINE void timer_tick(em8051 *aCPU, unsigned numTicks)
 }
 
 
+static ALWAYS_INLINE bool idle_loop_valid(em8051 *aCPU)
+{
+    /*
+     * Is the CPU parked in an idle loop which will keep spinning, with no
+     * side-effects, for as long as nothing else changes?
+     *
+     * idle_loop_detect() only accepts loops whose outcome depends on a single
+     * input byte, and which have no effect on CPU state besides recomputing
+     * the same ACC value. So if the PC is still at the loop head and the
+     * input is unchanged, running another iteration is indistinguishable from
+     * not running it. Anything pending which could change state behind the
+     * loop's back (interrupts, hardware ticks, timer edges) disqualifies it.
+     */
+
+    return aCPU->idleCycles
+        && !(aCPU->needInterruptDispatch | aCPU->needHardwareTick |
+             aCPU->needTimerEdgeCheck | aCPU->powerDown)
+        && aCPU->mPC == aCPU->idlePC
+        && (*aCPU->idleInput & aCPU->idleMask) == aCPU->idleValue;
+}
+
+
 static ALWAYS_INLINE void em8051_tick(em8051 *aCPU, unsigned numTicks,
                                       bool sbt, bool isProfiling, bool isTracing, bool hasBreakpoint,
                                       bool *ticked)
@@ -75,6 +97,23 @@ static ALWAYS_INLINE void em8051_tick(em8051 *aCPU, unsigned numTicks,
         // CPU core is awake
 
         int32_t tickDelay = aCPU->mTickDelay - numTicks;
+
+        /*
+         * Idle loop fast-forward. If the next iteration(s) of a known idle loop
+         * fall within this batch, skip them entirely and resume counting from
+         * the phase of the last skipped iteration. The batch may be longer than
+         * one iteration only when SystemCubes::tickLoopFastSBT has checked
+         * Hardware::idleStepLimit(), so no other state can change in between.
+         *
+         * This is disabled whenever anyone is watching individual instructions.
+         */
+
+        if (tickDelay <= 0 && !isProfiling && !isTracing && !hasBreakpoint && !ticked
+            && idle_loop_valid(aCPU)) {
+            unsigned cycles = aCPU->idleCycles;
+            tickDelay = cycles - (unsigned)(-tickDelay) % cycles;
+        }
+
         if (tickDelay < 0) {
             // Can happen when waking up from deep sleep
             tickDelay = 0;
@@ -120,7 +159,10 @@ static ALWAYS_INLINE void em8051_tick(em8051 *aCPU, unsigned numTicks,
             unsigned pc = aCPU->mPC;
             aCPU->mPreviousPC = pc;
 
+            aCPU->idleCycles = 0;
+
             if (sbt) {
+                // Translated self-loops call idle_loop_detect() themselves
                 aCPU->mTickDelay = sbt_rom_code[pc](aCPU);
             } else {
                 uint8_t opcode = aCPU->mCodeMem[pc];
@@ -128,6 +170,11 @@ static ALWAYS_INLINE void em8051_tick(em8051 *aCPU, unsigned numTicks,
                 uint8_t operand2 = aCPU->mCodeMem[(pc + 2) & PC_MASK];
                 aCPU->mTickDelay = aCPU->op[aCPU->mCodeMem[pc]](aCPU, pc, opcode, operand1, operand2);
                 aCPU->mPC = pc & PC_MASK;
+
+                if (UNLIKELY(aCPU->mPC == aCPU->mPreviousPC)) {
+                    uint8_t code[] = { opcode, operand1, operand2 };
+                    idle_loop_detect(aCPU, aCPU->mPC, aCPU->mTickDelay, code, sizeof code);
+                }
             }
             
             if (ticked)
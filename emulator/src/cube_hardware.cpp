@@ -30,6 +30,8 @@
 
 namespace Cube {
 
+void (*LCD::frameHook)(const LCD &lcd);
+
 bool Hardware::init(VirtualTime *masterTimer, const char *firmwareFile,
     FlashStorage::CubeRecord *flashStorage)
 {
@@ -135,11 +135,28 @@ class Hardware {
         
         CPU::em8051_tick(&cpu, tickBatch, true, false, false, false, NULL);
         hardwareTick();
-                    
-        return std::min(std::min(cpu.mTickDelay, (unsigned)cpu.prescaler12),
+
+        // A CPU parked in an idle loop doesn't need to wake up for each
+        // iteration. The caller must confirm this with idleStepLimit().
+        unsigned cpuDelay = cpu.idleCycles ? (unsigned)-1 : cpu.mTickDelay;
+
+        return std::min(std::min(cpuDelay, (unsigned)cpu.prescaler12),
                         (unsigned)hwDeadline.remaining());
     }
 
+    ALWAYS_INLINE unsigned idleStepLimit() {
+        /*
+         * After a round of tickFastSBT() across all cubes and the master,
+         * re-check any idle loop against the state those left behind. If the
+         * loop's input changed or an event is pending, we're back to stepping
+         * one CPU instruction (or basic block) at a time.
+         */
+
+        if (CPU::idle_loop_valid(&cpu))
+            return hwDeadline.remaining();
+        return cpu.mTickDelay;
+    }
+
     void lcdPulseTE() {
         if (time != NULL)
             lcd.pulseTE(hwDeadline);
@@ -58,6 +58,12 @@ class LCD {
     /* 16-bit RGB 5-6-5 format */
     uint16_t fb_mem[FB_SIZE];
 
+    /*
+     * Optional hook, called from the cube thread at the end of every
+     * frame (see CMD_DISPON below). Used by InputReplay to log frame hashes.
+     */
+    static void (*frameHook)(const LCD &lcd);
+
     void init() {
         // Framebuffer contents undefined. Simulate that...
         uint32_t i;
@@ -73,6 +79,7 @@ class LCD {
         ye = HEIGHT - 1;
         row = 0;
         col = 0;
+        fast_span = false;
         
         madctr = 0;
         colmod = COLMOD_18;
@@ -128,6 +135,23 @@ class LCD {
         return pixel_count;
     }
 
+    uint64_t hash() const {
+        /*
+         * Fast 64-bit hash of the framebuffer contents, for detecting
+         * changes and regressions. This is FNV-1a, applied to 32-bit
+         * words instead of bytes.
+         */
+
+        const uint32_t *words = reinterpret_cast<const uint32_t*>(fb_mem);
+        uint64_t h = 0xcbf29ce484222325ULL;
+
+        for (unsigned i = 0; i < FB_SIZE / 2; i++) {
+            h ^= words[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
     bool isVisible() {  
         return mode_awake && mode_display_on;
     }
@@ -163,6 +187,25 @@ class LCD {
         // Return to start row/column
         row = ys;
         col = xs;
+
+        /*
+         * Nearly every RAMWR the firmware issues is 16-bit color with
+         * MADCTR set to cancel out the model's own mirroring. In that
+         * layout, consecutive pixels within a row land at consecutive
+         * framebuffer addresses, so writeByte() can skip writePixel()
+         * and store directly through a running address. Everything that
+         * could change the layout requires a new command, so deciding
+         * once per RAMWR is sufficient.
+         */
+        uint8_t m = madctr ^ model.madctr_xor;
+        fast_span = colmod == COLMOD_16 && !(m & (MADCTR_MX | MADCTR_MY | MADCTR_MV));
+        if (fast_span)
+            spanAddress();
+    }
+
+    void spanAddress() {
+        // Address of the current pixel, in the fast_span layout only
+        fb_addr = (col + model.col_adj) + ((row + model.row_adj) << FB_ROW_SHIFT);
     }
 
     void applyMirroring(uint8_t flags, unsigned &row, unsigned &col) {
@@ -229,6 +272,20 @@ class LCD {
         case COLMOD_16:
             if (cmd_bytecount == 2) {
                 cmd_bytecount = 0;
+                if (LIKELY(fast_span)) {
+                    fb_mem[fb_addr & FB_MASK] = (pixel_bytes[0] << 8) | pixel_bytes[1];
+                    pixel_count++;
+
+                    if (LIKELY(++col <= xe)) {
+                        fb_addr++;
+                    } else {
+                        col = xs;
+                        if (++row > ye)
+                            row = ys;
+                        spanAddress();
+                    }
+                    break;
+                }
                 writePixel( (pixel_bytes[0] << 8) |
                             pixel_bytes[1] );
             }
@@ -288,6 +345,8 @@ class LCD {
              * like STAMP mode.
              */
             frame_count++;
+            if (UNLIKELY(frameHook != NULL))
+                frameHook(*this);
             break;
 
         case CMD_TEOFF:
@@ -434,6 +493,8 @@ class LCD {
 
     unsigned xs, xe, ys, ye;
     unsigned row, col;
+    unsigned fb_addr;
+    bool fast_span;
 
     uint8_t madctr;
     uint8_t colmod;
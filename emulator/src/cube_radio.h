@@ -100,6 +100,11 @@ class Radio {
         return c;
     }
 
+    uint64_t getTotalByteCount() const {
+        // Unlike getByteCount(), this never resets
+        return total_byte_count;
+    }
+
     uint8_t spiByte(uint8_t mosi) {
         // Chip not selected?
         if (csn)
@@ -213,6 +218,7 @@ class Radio {
             // Statistics for the debugger
             rx_count++;
             byte_count += incoming.len;
+            total_byte_count += incoming.len;
 
             if (tx_fifo_count) {
                 // ACK with payload
@@ -220,6 +226,7 @@ class Radio {
                 Tracer::logHex(cpu, "RADIO: ack", tx_tail->len, tx_tail->payload);
                 
                 byte_count += tx_tail->len;
+                total_byte_count += tx_tail->len;
                 ack = *tx_tail;
                 hasACK = true;
                 tx_fifo_tail = (tx_fifo_tail + 1) % FIFO_SIZE;
@@ -465,6 +472,7 @@ class Radio {
     
     uint32_t byte_count;
     uint32_t rx_count;
+    uint64_t total_byte_count;
     uint8_t irq_state;
     uint8_t irq_edge;
 
@@ -216,6 +216,7 @@ bool FlashStorage::checkData()
 
     if (data->header.cube_count == 0) {
         // Importing a file with no cubes. Update cubes and header, leave MC alone.
+        importErasedBlocks();
         initHeader();
         initCubes();
         LOG(("FLASH: Importing storage file with no saved cube data\n"));
@@ -236,6 +237,32 @@ bool FlashStorage::checkData()
     return true;
 }
 
+void FlashStorage::importErasedBlocks()
+{
+    /*
+     * Sparse backups from 'swiss backup' skip blocks that no volume uses.
+     * Those blocks read back as zeroes (or garbage), so restore them to
+     * their erased state here, and clear the bitmap afterwards so a
+     * re-import doesn't erase them again.
+     */
+
+    uint32_t *bits = data->header.mc_erasedBlocks;
+    const unsigned numBlocks = FlashDevice::CAPACITY / FlashDevice::ERASE_BLOCK_SIZE;
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < numBlocks; ++i)
+        if (bits[i / 32] & (1 << (i % 32))) {
+            memset(data->master.bytes + i * FlashDevice::ERASE_BLOCK_SIZE,
+                0xFF, FlashDevice::ERASE_BLOCK_SIZE);
+            count++;
+        }
+
+    memset(bits, 0, sizeof data->header.mc_erasedBlocks);
+
+    if (count)
+        LOG(("FLASH: Importing sparse backup, %d blocks erased\n", count));
+}
+
 bool FlashStorage::mapFile(const char *filename)
 {
 #ifdef _WIN32
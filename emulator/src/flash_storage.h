@@ -75,6 +75,11 @@ class FlashStorage {
                 uint32_t    mc_blockSize;
                 uint32_t    mc_capacity;
                 uint32_t    uniqueID;
+
+                // Only meaningful in imported files (cube_count == 0):
+                // MC erase blocks which were left out of a sparse backup.
+                uint32_t    mc_erasedBlocks[FlashDevice::CAPACITY /
+                                FlashDevice::ERASE_BLOCK_SIZE / 32];
             };
         };
 
@@ -108,6 +113,7 @@ class FlashStorage {
 
     void initData();
     bool checkData();
+    void importErasedBlocks();
 
     void initHeader();
     void initMC();
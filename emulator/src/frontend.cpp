@@ -26,7 +26,7 @@
 
 #include "frontend.h"
 #include "ostime.h"
-#include "mc_homebutton.h"
+#include "input_replay.h"
 #include "mc_neighbor.h"
 #include "mc_volume.h"
 #include <time.h>
@@ -399,7 +399,7 @@ void GLFWCALL Frontend::onKey(int key, int state)
             break;
 
         case 'B':
-            HomeButton::setPressed(true);
+            InputReplay::setHomeButton(true);
             break;
 
         case 'Z':
@@ -495,7 +495,7 @@ void GLFWCALL Frontend::onKey(int key, int state)
         switch (key) {
 
         case 'B':
-            HomeButton::setPressed(false);
+            InputReplay::setHomeButton(false);
             break;
 
         }
@@ -600,7 +600,7 @@ void Frontend::onMouseDown(int button)
             float centerDist = b2Distance(anchor, center);
 
             if (centerDist < MCConstants::CENTER_SIZE)
-                HomeButton::setPressed(true);
+                InputReplay::setHomeButton(true);
 
             b2RevoluteJointDef jointDef;
             jointDef.Initialize(mousePicker.mMC->getBody(), mouseBody, anchor);
@@ -716,7 +716,7 @@ void Frontend::onMouseUp(int button)
         }
 
         if (mousePicker.mMC) {
-            HomeButton::setPressed(glfwGetKey('B') == GLFW_PRESS);
+            InputReplay::setHomeButton(glfwGetKey('B') == GLFW_PRESS);
         }
 
         /* Mouse state reset */
@@ -1114,7 +1114,7 @@ void Frontend::ContactListener::updateSensors(b2Contact *contact, bool touching)
      */
     if (fdatA->type == fdatA->T_CUBE_NEIGHBOR && fdatB->type == fdatB->T_MC_NEIGHBOR) {
         unsigned cubeA = frontend.cubeID(fdatA->ptr.cube);
-        MCNeighbor::updateNeighbor(touching, fdatB->side, cubeA, fdatA->side);
+        frontend.sys->mcNeighbor.updateNeighbor(touching, fdatB->side, cubeA, fdatA->side);
     }
 }
 
@@ -179,10 +179,7 @@ void FrontendCube::setHoverTarget(float h)
 void FrontendCube::updateNeighbor(bool touching, unsigned mySide,
                                   unsigned otherSide, unsigned otherCube)
 {
-    if (touching)
-        hw->neighbors.setContact(mySide, otherSide, otherCube);
-    else
-        hw->neighbors.clearContact(mySide, otherSide, otherCube);
+    InputReplay::setNeighborContact(hw, touching, mySide, otherSide, otherCube);
 }
 
 void FrontendCube::animate()
@@ -226,7 +223,7 @@ void FrontendCube::animate()
      */
 
     b2Vec3 accelLocal = modelMatrix.Solve33(accelG);
-    hw->setAcceleration(accelLocal.x, accelLocal.y, accelLocal.z);
+    InputReplay::setAcceleration(hw, accelLocal.x, accelLocal.y, accelLocal.z);
 }
 
 void FrontendCube::computeAABB(b2AABB &aabb)
@@ -29,6 +29,7 @@
 
 #include <Box2D/Box2D.h>
 #include "system.h"
+#include "input_replay.h"
 #include "frontend_fixture.h"
 
 class FrontendCube;
@@ -123,7 +124,7 @@ class FrontendCube {
     void toggleFlip();
     
     void setTouch(float amount) {
-        hw->setTouch(amount);
+        InputReplay::setTouch(hw, amount);
     }
     
     bool isHovering() {
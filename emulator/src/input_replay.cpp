@@ -0,0 +1,356 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include "input_replay.h"
+#include "system.h"
+#include "mc_homebutton.h"
+
+bool InputReplay::playing;
+System *InputReplay::sys;
+FILE *InputReplay::recordFile;
+FILE *InputReplay::frameHashFile;
+std::vector<InputReplay::Event> InputReplay::events;
+unsigned InputReplay::nextEvent;
+float InputReplay::lastAccel[System::MAX_CUBES][3];
+
+
+bool InputReplay::init(System *sys)
+{
+    InputReplay::sys = sys;
+
+    if (!sys->opt_replayFilename.empty()) {
+        if (!load(sys->opt_replayFilename.c_str()))
+            return false;
+        playing = true;
+    }
+
+    if (!sys->opt_recordFilename.empty()) {
+        const char *name = sys->opt_recordFilename.c_str();
+        recordFile = fopen(name, "w");
+        if (!recordFile) {
+            LOG(("REPLAY: Error, can't open input log '%s' (%s)\n", name, strerror(errno)));
+            return false;
+        }
+
+        fprintf(recordFile, "# Siftulator input log\n");
+        fprintf(recordFile, "0 cubes %u\n", sys->opt_numCubes);
+
+        // Make sure the first acceleration sample for each cube gets logged
+        for (unsigned i = 0; i < System::MAX_CUBES; i++)
+            lastAccel[i][0] = lastAccel[i][1] = lastAccel[i][2] = -1e30f;
+    }
+
+    if (!sys->opt_frameHashFilename.empty()) {
+        const char *name = sys->opt_frameHashFilename.c_str();
+        frameHashFile = fopen(name, "w");
+        if (!frameHashFile) {
+            LOG(("REPLAY: Error, can't open frame hash log '%s' (%s)\n", name, strerror(errno)));
+            return false;
+        }
+        fprintf(frameHashFile, "# clocks cube frame hash\n");
+        Cube::LCD::frameHook = frameHook;
+    }
+
+    return true;
+}
+
+void InputReplay::exit()
+{
+    if (recordFile) {
+        fprintf(recordFile, "%"PRIu64" end\n", sys->time.clocks);
+        fclose(recordFile);
+        recordFile = NULL;
+    }
+
+    if (frameHashFile) {
+        Cube::LCD::frameHook = NULL;
+        fclose(frameHashFile);
+        frameHashFile = NULL;
+    }
+}
+
+void InputReplay::setAcceleration(Cube::Hardware *hw, float xG, float yG, float zG)
+{
+    /*
+     * The frontend calls this on every frame, whether or not anything
+     * changed. Only log the samples that differ.
+     */
+
+    float *last = lastAccel[hw->id()];
+
+    if (recordFile && (last[0] != xG || last[1] != yG || last[2] != zG)) {
+        last[0] = xG;
+        last[1] = yG;
+        last[2] = zG;
+        fprintf(recordFile, "%"PRIu64" accel %u %.9g %.9g %.9g\n",
+            sys->time.clocks, hw->id(), xG, yG, zG);
+    }
+
+    hw->setAcceleration(xG, yG, zG);
+}
+
+void InputReplay::setTouch(Cube::Hardware *hw, bool touching)
+{
+    if (recordFile)
+        fprintf(recordFile, "%"PRIu64" touch %u %d\n",
+            sys->time.clocks, hw->id(), touching);
+
+    hw->setTouch(touching);
+}
+
+void InputReplay::setNeighborContact(Cube::Hardware *hw, bool touching,
+    unsigned mySide, unsigned otherSide, unsigned otherCube)
+{
+    if (recordFile)
+        fprintf(recordFile, "%"PRIu64" neighbor %u %d %u %u %u\n",
+            sys->time.clocks, hw->id(), touching, mySide, otherSide, otherCube);
+
+    if (touching)
+        hw->neighbors.setContact(mySide, otherSide, otherCube);
+    else
+        hw->neighbors.clearContact(mySide, otherSide, otherCube);
+}
+
+void InputReplay::setHomeButton(bool pressed)
+{
+    if (recordFile)
+        fprintf(recordFile, "%"PRIu64" button %d\n", sys->time.clocks, pressed);
+
+    HomeButton::setPressed(pressed);
+}
+
+bool InputReplay::load(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        LOG(("REPLAY: Error, can't open input log '%s' (%s)\n", filename, strerror(errno)));
+        return false;
+    }
+
+    char line[256];
+    unsigned lineNumber = 0;
+    bool success = true;
+
+    events.clear();
+    nextEvent = 0;
+
+    while (fgets(line, sizeof line, f)) {
+        lineNumber++;
+
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+
+        Event ev;
+        if (!parse(line, ev)) {
+            LOG(("REPLAY: Error, bad event on line %u of '%s'\n", lineNumber, filename));
+            success = false;
+            break;
+        }
+
+        if (ev.type == EV_CUBES) {
+            // Not an event; start with the same number of cubes we recorded with
+            sys->opt_numCubes = ev.cube;
+            continue;
+        }
+
+        if (!events.empty() && ev.clocks < events.back().clocks) {
+            LOG(("REPLAY: Error, events out of order on line %u of '%s'\n", lineNumber, filename));
+            success = false;
+            break;
+        }
+
+        events.push_back(ev);
+        if (ev.type == EV_END)
+            break;
+    }
+
+    fclose(f);
+
+    if (success && (events.empty() || events.back().type != EV_END)) {
+        LOG(("REPLAY: Error, input log '%s' is truncated\n", filename));
+        success = false;
+    }
+
+    return success;
+}
+
+bool InputReplay::parse(const char *line, Event &ev)
+{
+    /*
+     * One event per line: a VirtualTime timestamp, an event name,
+     * and some event-specific parameters.
+     */
+
+    char name[16];
+    int offset = 0;
+    int state = 0;
+
+    memset(&ev, 0, sizeof ev);
+    if (sscanf(line, "%"SCNu64" %15s %n", &ev.clocks, name, &offset) < 2 || !offset)
+        return false;
+    line += offset;
+
+    if (!strcmp(name, "cubes")) {
+        ev.type = EV_CUBES;
+        if (sscanf(line, "%u", &ev.cube) != 1 || ev.cube > System::MAX_CUBES)
+            return false;
+
+    } else if (!strcmp(name, "accel")) {
+        ev.type = EV_ACCEL;
+        if (sscanf(line, "%u %f %f %f", &ev.cube, &ev.x, &ev.y, &ev.z) != 4)
+            return false;
+
+    } else if (!strcmp(name, "touch")) {
+        ev.type = EV_TOUCH;
+        if (sscanf(line, "%u %d", &ev.cube, &state) != 2)
+            return false;
+
+    } else if (!strcmp(name, "neighbor")) {
+        ev.type = EV_NEIGHBOR;
+        if (sscanf(line, "%u %d %u %u %u", &ev.cube, &state,
+                &ev.mySide, &ev.otherSide, &ev.otherCube) != 5)
+            return false;
+        if (ev.mySide >= Cube::Neighbors::NUM_SIDES ||
+            ev.otherSide >= Cube::Neighbors::NUM_SIDES ||
+            ev.otherCube >= System::MAX_CUBES)
+            return false;
+
+    } else if (!strcmp(name, "button")) {
+        ev.type = EV_BUTTON;
+        if (sscanf(line, "%d", &state) != 1)
+            return false;
+
+    } else if (!strcmp(name, "end")) {
+        ev.type = EV_END;
+
+    } else {
+        return false;
+    }
+
+    ev.state = state != 0;
+    return ev.cube < System::MAX_CUBES || ev.type == EV_CUBES;
+}
+
+void InputReplay::apply(const Event &ev)
+{
+    Cube::Hardware &cube = sys->cubes[ev.cube];
+
+    switch (ev.type) {
+
+    case EV_ACCEL:
+        cube.setAcceleration(ev.x, ev.y, ev.z);
+        break;
+
+    case EV_TOUCH:
+        cube.setTouch(ev.state);
+        break;
+
+    case EV_NEIGHBOR:
+        if (ev.state)
+            cube.neighbors.setContact(ev.mySide, ev.otherSide, ev.otherCube);
+        else
+            cube.neighbors.clearContact(ev.mySide, ev.otherSide, ev.otherCube);
+        break;
+
+    case EV_BUTTON:
+        HomeButton::setPressed(ev.state);
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool InputReplay::play(uint64_t clocks)
+{
+    while (nextEvent < events.size()) {
+        const Event &ev = events[nextEvent];
+        if (ev.clocks > clocks)
+            return false;
+
+        if (ev.type == EV_END) {
+            report();
+            return true;
+        }
+
+        apply(ev);
+        nextEvent++;
+    }
+    return false;
+}
+
+void InputReplay::report()
+{
+    /*
+     * Summarize the playback as a benchmark. Frame counts come from the
+     * LCD model, so these are frames actually displayed by each cube.
+     * MC busy time is measured against the cube with the most frames,
+     * which is usually the same as the number of System::paint() calls.
+     */
+
+    uint64_t clocks = sys->time.clocks;
+    uint64_t busyTicks = SystemMC::getBusyTicks();
+    double seconds = VirtualTime::toSeconds(clocks);
+    unsigned maxFrames = 0;
+
+    LOG(("REPLAY: Finished %u events in %.3f virtual seconds\n",
+        nextEvent, seconds));
+
+    for (unsigned i = 0; i < sys->opt_numCubes; i++) {
+        Cube::Hardware &cube = sys->cubes[i];
+        unsigned frames = cube.lcd.getFrameCount();
+        uint64_t radioBytes = cube.spi.radio.getTotalByteCount();
+
+        LOG(("REPLAY: Cube %u: %u frames, %.2f FPS, %.1f radio bytes/frame\n",
+            i, frames, frames / seconds, frames ? radioBytes / double(frames) : 0.0));
+
+        maxFrames = std::max(maxFrames, frames);
+    }
+
+    LOG(("REPLAY: MC busy %.1f%%, %.0f ticks/frame\n",
+        clocks ? 100.0 * busyTicks / clocks : 0.0,
+        maxFrames ? busyTicks / double(maxFrames) : 0.0));
+
+    fflush(stdout);
+}
+
+void InputReplay::frameHook(const Cube::LCD &lcd)
+{
+    // Called from the cube thread. Find the cube that owns this LCD.
+
+    for (unsigned i = 0; i < System::MAX_CUBES; i++) {
+        Cube::Hardware &cube = sys->cubes[i];
+        if (&cube.lcd == &lcd) {
+            fprintf(frameHashFile, "%"PRIu64" %u %u %016"PRIx64"\n",
+                sys->time.clocks, i, cube.lcd.getFrameCount(), lcd.hash());
+            return;
+        }
+    }
+}
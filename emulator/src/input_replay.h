@@ -0,0 +1,124 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Deterministic input recording and playback.
+ *
+ * While recording, every input the UI applies to the simulation (cube
+ * acceleration, touch, neighbor contacts, and the home button) is logged
+ * to a text file along with its VirtualTime timestamp.
+ *
+ * Playback runs headless, and applies each event from the MC thread at the
+ * first radio packet boundary on or after its timestamp. At that point the
+ * cube thread is stopped by the DeadlineSynchronizer, so the result doesn't
+ * depend on host thread scheduling. When the log runs out, we print some
+ * benchmark statistics and exit.
+ *
+ * Separately, we can log a hash of every LCD frame each cube displays.
+ * Two playbacks of the same log with the same firmware and game should
+ * produce identical frame hashes.
+ */
+
+#ifndef _INPUT_REPLAY_H
+#define _INPUT_REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "macros.h"
+
+class System;
+
+namespace Cube {
+    class Hardware;
+    class LCD;
+}
+
+
+class InputReplay {
+public:
+    /// Open files according to the System options. Call before the cubes are initialized.
+    static bool init(System *sys);
+    static void exit();
+
+    /*
+     * Live input, from the UI thread. The input is applied immediately,
+     * and logged if we're recording.
+     */
+    static void setAcceleration(Cube::Hardware *hw, float xG, float yG, float zG);
+    static void setTouch(Cube::Hardware *hw, bool touching);
+    static void setNeighborContact(Cube::Hardware *hw, bool touching,
+        unsigned mySide, unsigned otherSide, unsigned otherCube);
+    static void setHomeButton(bool pressed);
+
+    static ALWAYS_INLINE bool isPlaying() {
+        return UNLIKELY(playing);
+    }
+
+    /**
+     * Apply all events up to the given time. Must only be called from the MC
+     * thread, while the cube simulation is stopped in a deadline sync event.
+     * Returns true once the entire log has been played back and the results
+     * reported, at which point the caller should end that event and exit.
+     */
+    static bool play(uint64_t clocks);
+
+private:
+    enum EventType {
+        EV_CUBES,
+        EV_ACCEL,
+        EV_TOUCH,
+        EV_NEIGHBOR,
+        EV_BUTTON,
+        EV_END,
+    };
+
+    struct Event {
+        uint64_t clocks;
+        EventType type;
+        unsigned cube;
+        bool state;
+        unsigned mySide, otherSide, otherCube;
+        float x, y, z;
+    };
+
+    static bool playing;
+    static System *sys;
+    static FILE *recordFile;
+    static FILE *frameHashFile;
+    static std::vector<Event> events;
+    static unsigned nextEvent;
+
+    static float lastAccel[][3];
+
+    static bool load(const char *filename);
+    static bool parse(const char *line, Event &ev);
+    static void apply(const Event &ev);
+    static void report();
+    static void frameHook(const Cube::LCD &lcd);
+};
+
+#endif
@@ -25,6 +25,9 @@
  */
  
 #include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
 #include "lua_script.h"
 #include "lua_cube.h"
 #include "lua_system.h"
@@ -36,6 +39,12 @@
 
 const char LuaCube::className[] = "Cube";
 
+/*
+ * Reference screenshots, already converted to RGB565. Test suites compare
+ * against the same few images over and over, so we only decode each PNG once.
+ */
+static std::map<std::string, std::vector<uint16_t> > referenceCache;
+
 Lunar<LuaCube>::RegType LuaCube::methods[] = {
     LUNAR_DECLARE_METHOD(LuaCube, reset),
     LUNAR_DECLARE_METHOD(LuaCube, isDebugging),
@@ -47,6 +56,7 @@ Lunar<LuaCube>::RegType LuaCube::methods[] = {
     LUNAR_DECLARE_METHOD(LuaCube, handleRadioPacket),
     LUNAR_DECLARE_METHOD(LuaCube, saveScreenshot),
     LUNAR_DECLARE_METHOD(LuaCube, testScreenshot),
+    LUNAR_DECLARE_METHOD(LuaCube, lcdHash),
     LUNAR_DECLARE_METHOD(LuaCube, testSetEnabled),
     LUNAR_DECLARE_METHOD(LuaCube, testGetACK),
     LUNAR_DECLARE_METHOD(LuaCube, testWrite),
@@ -219,6 +229,9 @@ int LuaCube::saveScreenshot(lua_State *L)
     encoder.encode(pngData, pixels, lcd.WIDTH, lcd.HEIGHT);
     
     LodePNG::saveFile(pngData, filename);
+
+    // This may have replaced a reference image
+    referenceCache.erase(filename);
     
     return 0;
 }
@@ -229,42 +242,81 @@ int LuaCube::testScreenshot(lua_State *L)
     const lua_Integer tolerance = lua_tointeger(L, 2);
 
     Cube::LCD &lcd = LuaSystem::sys->cubes[id].lcd;
-    std::vector<uint8_t> pngData;
-    std::vector<uint8_t> pixels;
-    LodePNG::Decoder decoder;
-    
-    LodePNG::loadFile(pngData, filename);
-    if (!pngData.empty())
-        decoder.decode(pixels, pngData);
-    
-    if (pixels.empty()) {
-        lua_pushfstring(L, "error loading PNG file \"%s\"", filename);
-        lua_error(L);
+    std::vector<uint16_t> &ref = referenceCache[filename];
+
+    if (ref.empty()) {
+        std::vector<uint8_t> pngData;
+        std::vector<uint8_t> pixels;
+        LodePNG::Decoder decoder;
+
+        LodePNG::loadFile(pngData, filename);
+        if (!pngData.empty())
+            decoder.decode(pixels, pngData);
+
+        if (pixels.size() < lcd.FB_SIZE * 4) {
+            referenceCache.erase(filename);
+            lua_pushfstring(L, "error loading PNG file \"%s\"", filename);
+            lua_error(L);
+        }
+
+        ref.resize(lcd.FB_SIZE);
+        for (unsigned i = 0; i < lcd.FB_SIZE; i++)
+            ref[i] = RGB565(&pixels[i*4]).value;
     }
-    
-    for (unsigned i = 0; i < lcd.FB_SIZE; i++) {
-        RGB565 fbColor = lcd.fb_mem[i];
-        RGB565 refColor = &pixels[i*4];
-
-        int dR = int(fbColor.red()) - int(refColor.red());
-        int dG = int(fbColor.green()) - int(refColor.green());
-        int dB = int(fbColor.blue()) - int(refColor.blue());
-        int error = dR*dR + dG*dG + dB*dB;
-
-        if (error > tolerance) {
-            // Image mismatch. Return (x, y, lcdPixel, refPixel, error)
-            lua_pushinteger(L, i % lcd.WIDTH);
-            lua_pushinteger(L, i / lcd.WIDTH);
-            lua_pushinteger(L, fbColor.value);
-            lua_pushinteger(L, refColor.value);
-            lua_pushinteger(L, error);
-            return 5;
+
+    /*
+     * Most comparisons succeed, and most pixels match exactly, so compare
+     * four pixels at a time and only compute an error for pixels that differ.
+     */
+
+    STATIC_ASSERT((Cube::LCD::FB_SIZE & 3) == 0);
+
+    for (unsigned i = 0; i < lcd.FB_SIZE; i += 4) {
+        uint64_t fbWord, refWord;
+        memcpy(&fbWord, &lcd.fb_mem[i], sizeof fbWord);
+        memcpy(&refWord, &ref[i], sizeof refWord);
+        if (fbWord == refWord)
+            continue;
+
+        for (unsigned j = i; j < i + 4; j++) {
+            RGB565 fbColor = lcd.fb_mem[j];
+            RGB565 refColor = ref[j];
+            if (fbColor == refColor)
+                continue;
+
+            int dR = int(fbColor.red()) - int(refColor.red());
+            int dG = int(fbColor.green()) - int(refColor.green());
+            int dB = int(fbColor.blue()) - int(refColor.blue());
+            int error = dR*dR + dG*dG + dB*dB;
+
+            if (error > tolerance) {
+                // Image mismatch. Return (x, y, lcdPixel, refPixel, error)
+                lua_pushinteger(L, j % lcd.WIDTH);
+                lua_pushinteger(L, j / lcd.WIDTH);
+                lua_pushinteger(L, fbColor.value);
+                lua_pushinteger(L, refColor.value);
+                lua_pushinteger(L, error);
+                return 5;
+            }
         }
     }
     
     return 0;
 }
 
+int LuaCube::lcdHash(lua_State *L)
+{
+    /*
+     * Lua numbers can't hold a 64-bit hash exactly, so return it
+     * as a string of 16 hex digits.
+     */
+
+    char buf[17];
+    snprintf(buf, sizeof buf, "%016"PRIx64, LuaSystem::sys->cubes[id].lcd.hash());
+    lua_pushstring(L, buf);
+    return 1;
+}
+
 int LuaCube::handleRadioPacket(lua_State *L)
 {
     /*
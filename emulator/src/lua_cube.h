@@ -57,13 +57,17 @@ private:
      * LCD screenshots
      *
      * We can save a screenshot to PNG, or compare a PNG with the
-     * current LCD contents. Requires an exact match. On success,
-     * returns nil. On error, returns (x, y, lcdColor, refColor)
-     * to describe the mismatch.
+     * current LCD contents, within some tolerance. On success,
+     * returns nil. On error, returns (x, y, lcdColor, refColor, error)
+     * to describe the mismatch. Reference images are decoded once
+     * and cached.
+     *
+     * lcdHash() is a much cheaper way to check for an exact match.
      */
      
     int saveScreenshot(lua_State *L);
     int testScreenshot(lua_State *L);
+    int lcdHash(lua_State *L);
 
     /*
      * Factory test interface
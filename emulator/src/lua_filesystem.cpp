@@ -35,6 +35,8 @@
 #include "flash_recycler.h"
 #include "flash_syslfs.h"
 #include "elfprogram.h"
+#include "mc_flash_timing.h"
+#include "mc_timing.h"
 
 const char LuaFilesystem::className[] = "Filesystem";
 const char LuaFilesystem::callbackHostField[] = "__filesystem_callbackHost";
@@ -50,6 +52,8 @@ Lunar<LuaFilesystem>::RegType LuaFilesystem::methods[] = {
     LUNAR_DECLARE_METHOD(LuaFilesystem, volumeEraseCounts),
     LUNAR_DECLARE_METHOD(LuaFilesystem, volumePayload),
     LUNAR_DECLARE_METHOD(LuaFilesystem, simulatedBlockEraseCounts),
+    LUNAR_DECLARE_METHOD(LuaFilesystem, setFlashTiming),
+    LUNAR_DECLARE_METHOD(LuaFilesystem, flashStalls),
     LUNAR_DECLARE_METHOD(LuaFilesystem, rawRead),
     LUNAR_DECLARE_METHOD(LuaFilesystem, rawWrite),
     LUNAR_DECLARE_METHOD(LuaFilesystem, rawErase),
@@ -387,6 +391,65 @@ int LuaFilesystem::simulatedBlockEraseCounts(lua_State *L)
     return 1;
 }
 
+int LuaFilesystem::setFlashTiming(lua_State *L)
+{
+    /*
+     * Takes a table of options for the simulated flash timing model.
+     * Options not mentioned are reset to their defaults.
+     */
+
+    FlashTimingModel::Params params;
+
+    if (!LuaScript::argBegin(L, className))
+        return 0;
+
+    if (LuaScript::argMatch(L, "async"))
+        params.async = lua_toboolean(L, -1);
+
+    if (LuaScript::argMatch(L, "eraseSuspend"))
+        params.eraseSuspend = lua_toboolean(L, -1);
+
+    if (LuaScript::argMatch(L, "variation"))
+        params.variation = lua_toboolean(L, -1);
+
+    if (LuaScript::argMatch(L, "wear"))
+        params.wear = lua_tonumber(L, -1);
+
+    if (LuaScript::argMatch(L, "seed"))
+        params.seed = lua_tointeger(L, -1);
+
+    if (!LuaScript::argEnd(L))
+        return 0;
+
+    SystemMC::getFlashTiming().configure(params);
+    return 0;
+}
+
+int LuaFilesystem::flashStalls(lua_State *L)
+{
+    /*
+     * No parameters. Returns a table describing how long the simulated
+     * MCU has been blocked on flash since the last call, and resets
+     * those counters.
+     */
+
+    FlashTimingModel::Stalls stalls;
+    SystemMC::getFlashTiming().takeStalls(stalls);
+
+    lua_newtable(L);
+
+    lua_pushnumber(L, stalls.totalTicks / double(MCTiming::TICK_HZ));
+    lua_setfield(L, -2, "total");
+
+    lua_pushnumber(L, stalls.longestTicks / double(MCTiming::TICK_HZ));
+    lua_setfield(L, -2, "longest");
+
+    lua_pushnumber(L, stalls.count);
+    lua_setfield(L, -2, "count");
+
+    return 1;
+}
+
 int LuaFilesystem::rawRead(lua_State *L)
 {
     /*
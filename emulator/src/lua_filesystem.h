@@ -57,6 +57,8 @@ private:
     int volumePayload(lua_State *L);
 
     int simulatedBlockEraseCounts(lua_State *L);
+    int setFlashTiming(lua_State *L);
+    int flashStalls(lua_State *L);
 
     int rawRead(lua_State *L);
     int rawWrite(lua_State *L);
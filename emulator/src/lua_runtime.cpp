@@ -30,6 +30,7 @@
 #include "svmruntime.h"
 #include "svmloader.h"
 #include "svmdebugpipe.h"
+#include "mc_syscallstats.h"
 
 const char LuaRuntime::className[] = "Runtime";
 const char LuaRuntime::callbackHostField[] = "__runtime_callbackHost";
@@ -50,6 +51,8 @@ Lunar<LuaRuntime>::RegType LuaRuntime::methods[] = {
     LUNAR_DECLARE_METHOD(LuaRuntime, previousVolume),
     LUNAR_DECLARE_METHOD(LuaRuntime, flashToVirtAddr),
     LUNAR_DECLARE_METHOD(LuaRuntime, virtToFlashAddr),
+    LUNAR_DECLARE_METHOD(LuaRuntime, syscallStats),
+    LUNAR_DECLARE_METHOD(LuaRuntime, resetSyscallStats),
     {0,0}
 };
 
@@ -217,3 +220,50 @@ int LuaRuntime::flashToVirtAddr(lua_State *L)
     lua_pushinteger(L, SvmMemory::flashToVirtAddr(fa));
     return 1;
 }
+
+int LuaRuntime::syscallStats(lua_State *L)
+{
+    /*
+     * Takes no arguments. Returns a table, keyed by syscall name, with
+     * the cumulative counters for every syscall that has been called.
+     */
+
+    lua_newtable(L);
+
+    for (unsigned num = 0; num < SvmRuntime::getNumSyscalls(); ++num) {
+        const SyscallStats::Counters *c = SyscallStats::get(num);
+        const char *name = SvmRuntime::getSyscallName(num);
+        if (!c || !name || !c->calls)
+            continue;
+
+        lua_pushstring(L, name);
+        lua_newtable(L);
+
+        lua_pushnumber(L, c->calls);
+        lua_setfield(L, -2, "calls");
+        lua_pushnumber(L, c->ticks);
+        lua_setfield(L, -2, "ticks");
+        lua_pushnumber(L, c->busyTicks);
+        lua_setfield(L, -2, "busyTicks");
+        lua_pushnumber(L, c->bytes);
+        lua_setfield(L, -2, "bytes");
+
+        lua_newtable(L);
+        for (unsigned i = 0; i < SyscallStats::NUM_BUCKETS; ++i) {
+            lua_pushnumber(L, i + 1);
+            lua_pushnumber(L, c->histogram[i]);
+            lua_settable(L, -3);
+        }
+        lua_setfield(L, -2, "histogram");
+
+        lua_settable(L, -3);
+    }
+
+    return 1;
+}
+
+int LuaRuntime::resetSyscallStats(lua_State *L)
+{
+    SyscallStats::reset();
+    return 0;
+}
@@ -64,6 +64,9 @@ private:
 
     int virtToFlashAddr(lua_State *L);
     int flashToVirtAddr(lua_State *L);
+
+    int syscallStats(lua_State *L);
+    int resetSyscallStats(lua_State *L);
 };
 
 #endif
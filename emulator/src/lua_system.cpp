@@ -28,6 +28,11 @@
 #include "lua_system.h"
 #include "ostime.h"
 #include "assetloader.h"
+#include "audiomixer.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
 
 System *LuaSystem::sys = NULL;
 const char LuaSystem::className[] = "System";
@@ -41,9 +46,14 @@ Lunar<LuaSystem>::RegType LuaSystem::methods[] = {
     LUNAR_DECLARE_METHOD(LuaSystem, setTraceMode),
     LUNAR_DECLARE_METHOD(LuaSystem, setAssetLoaderBypass),
     LUNAR_DECLARE_METHOD(LuaSystem, vclock),
+    LUNAR_DECLARE_METHOD(LuaSystem, clock),
     LUNAR_DECLARE_METHOD(LuaSystem, vsleep),
     LUNAR_DECLARE_METHOD(LuaSystem, sleep),
     LUNAR_DECLARE_METHOD(LuaSystem, numCubes),
+    LUNAR_DECLARE_METHOD(LuaSystem, startAudioDigest),
+    LUNAR_DECLARE_METHOD(LuaSystem, stopAudioDigest),
+    LUNAR_DECLARE_METHOD(LuaSystem, audioDigest),
+    LUNAR_DECLARE_METHOD(LuaSystem, compareAudioDigest),
     {0,0}
 };
 
@@ -88,6 +98,9 @@ int LuaSystem::setOptions(lua_State *L)
     if (LuaScript::argMatch(L, "svmFlashStats"))
         sys->opt_svmFlashStats = lua_toboolean(L, -1);
 
+    if (LuaScript::argMatch(L, "svmSyscallStats"))
+        sys->opt_svmSyscallStats = lua_toboolean(L, -1);
+
     if (LuaScript::argMatch(L, "svmStackMonitor"))
         sys->opt_svmStackMonitor = lua_toboolean(L, -1);
 
@@ -127,6 +140,15 @@ int LuaSystem::vclock(lua_State *L)
     return 1;
 }
 
+int LuaSystem::clock(lua_State *L)
+{
+    /*
+     * Read the real-time clock, in seconds
+     */
+    lua_pushnumber(L, OSTime::clock());
+    return 1;
+}
+
 int LuaSystem::sleep(lua_State *L)
 {
     OSTime::sleep(luaL_checknumber(L, 1));
@@ -171,3 +193,89 @@ int LuaSystem::exit(lua_State *L)
     sys->exit();
     return 0;
 }
+
+int LuaSystem::startAudioDigest(lua_State *L)
+{
+    /*
+     * Optional argument is the window length, in seconds. Defaults to 1.
+     */
+
+    double seconds = luaL_optnumber(L, 1, 1.0);
+    if (seconds <= 0) {
+        lua_pushfstring(L, "audio digest window must be positive");
+        lua_error(L);
+    }
+
+    sys->audioDigest.start(unsigned(seconds * AudioMixer::SAMPLE_HZ + 0.5));
+    return 0;
+}
+
+int LuaSystem::stopAudioDigest(lua_State *L)
+{
+    sys->audioDigest.stop();
+    return 0;
+}
+
+int LuaSystem::audioDigest(lua_State *L)
+{
+    /*
+     * Returns an array with the hash of each completed window. Like
+     * Cube():lcdHash(), these are strings of 16 hex digits.
+     */
+
+    std::vector<uint64_t> windows;
+    sys->audioDigest.getWindows(windows);
+
+    lua_newtable(L);
+
+    for (unsigned i = 0; i < windows.size(); ++i) {
+        char buf[17];
+        snprintf(buf, sizeof buf, "%016"PRIx64, windows[i]);
+        lua_pushnumber(L, i + 1);
+        lua_pushstring(L, buf);
+        lua_settable(L, -3);
+    }
+
+    return 1;
+}
+
+int LuaSystem::compareAudioDigest(lua_State *L)
+{
+    /*
+     * Argument is an array of window hashes, as returned by audioDigest().
+     * Returns nothing if both digests have the same windows. Otherwise,
+     * returns the index of the first window that differs or that only one
+     * of the digests has, and the time in seconds at which it starts.
+     */
+
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    std::vector<uint64_t> windows;
+    sys->audioDigest.getWindows(windows);
+
+    unsigned expectedCount = lua_objlen(L, 1);
+    unsigned count = std::max<unsigned>(expectedCount, windows.size());
+
+    for (unsigned i = 0; i < count; ++i) {
+        bool match = false;
+
+        if (i < expectedCount && i < windows.size()) {
+            lua_rawgeti(L, 1, i + 1);
+            const char *expected = lua_tostring(L, -1);
+
+            char buf[17];
+            snprintf(buf, sizeof buf, "%016"PRIx64, windows[i]);
+            match = expected && !strcmp(expected, buf);
+            lua_pop(L, 1);
+        }
+
+        if (!match) {
+            lua_pushinteger(L, i + 1);
+            lua_pushnumber(L, double(i) * sys->audioDigest.getWindowSamples()
+                / AudioMixer::SAMPLE_HZ);
+            return 2;
+        }
+    }
+
+    return 0;
+}
@@ -50,8 +50,14 @@ private:
     int numCubes(lua_State *L);
 
     int vclock(lua_State *L);
+    int clock(lua_State *L);
     int vsleep(lua_State *L);
     int sleep(lua_State *L);
+
+    int startAudioDigest(lua_State *L);
+    int stopAudioDigest(lua_State *L);
+    int audioDigest(lua_State *L);
+    int compareAudioDigest(lua_State *L);
 };
 
 #endif
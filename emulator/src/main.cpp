@@ -87,10 +87,19 @@ static void usage()
             "  --svm-trace           Trace SVM instruction execution\n"
             "  --svm-stack           Monitor SVM stack usage\n"
             "  --svm-flash-stats     Dump statistics about flash memory usage\n"
+            "  --svm-syscall-stats   Dump statistics about the cost of each syscall\n"
             "  --waveout FILE.wav    Log all audio output to LOG.wav\n"
             "  --white-bg            Force the UI to use a plain white background\n"
             "  --window WxH          Initial window size (default 800x600)\n"
             "  --flush-logs          fflush stdout individual game logs to use them like a tail\n"
+            "  --deferred-logs       Format game logs on a background thread, for heavy logging\n"
+            "  --record INPUT.log    Record all cube and button input to INPUT.log\n"
+            "  --replay INPUT.log    Play back recorded input headless, then report benchmark stats\n"
+            "  --frame-hashes FILE   Log a hash of every LCD frame to FILE\n"
+            "  --bt-pipe PORT        Bridge the Bluetooth data pipe to a local TCP port\n"
+            "  --usb-pipe PORT       Bridge the USB data pipe to a local TCP port\n"
+            "  --bt-link BPS,US      Bluetooth bandwidth (bytes/sec) and latency (us)\n"
+            "  --usb-link BPS,US     USB bandwidth (bytes/sec) and latency (us)\n"
             "\n"
             "Games:\n"
             "  Any games specified on the command line will be installed to\n"
@@ -208,7 +217,8 @@ static int runScript(System &sys, const char *file)
 
 int main(int argc, char **argv)
 {
-    System& sys = System::getInstance();
+    // Static, so the flash file is written back even if we exit() early
+    static System sys;
     const char *scriptFile = NULL;
 
     // Attach an existing console, if it's already handy
@@ -269,6 +279,11 @@ int main(int argc, char **argv)
             continue;
         }
 
+        if (!strcmp(arg, "--svm-syscall-stats")) {
+            sys.opt_svmSyscallStats = true;
+            continue;
+        }
+
         if (!strcmp(arg, "--radio-trace")) {
             sys.opt_radioTrace = true;
             continue;
@@ -324,6 +339,32 @@ int main(int argc, char **argv)
             continue;
         }
 
+        if (!strcmp(arg, "--deferred-logs")) {
+            sys.opt_deferredLogs = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--record") && argv[c+1]) {
+            sys.opt_recordFilename = argv[c+1];
+            c++;
+            continue;
+        }
+
+        if (!strcmp(arg, "--replay") && argv[c+1]) {
+            // Playback is headless, and as fast as possible
+            sys.opt_replayFilename = argv[c+1];
+            sys.opt_headless = true;
+            sys.opt_turbo = true;
+            c++;
+            continue;
+        }
+
+        if (!strcmp(arg, "--frame-hashes") && argv[c+1]) {
+            sys.opt_frameHashFilename = argv[c+1];
+            c++;
+            continue;
+        }
+
         if (!strcmp(arg, "--waveout") && argv[c+1]) {
             sys.opt_waveoutFilename = argv[c+1];
             c++;
@@ -376,6 +417,36 @@ int main(int argc, char **argv)
             continue;
         }
 
+        if (!strcmp(arg, "--bt-pipe") && argv[c+1]) {
+            sys.opt_btPipePort = atoi(argv[c+1]);
+            c++;
+            continue;
+        }
+
+        if (!strcmp(arg, "--usb-pipe") && argv[c+1]) {
+            sys.opt_usbPipePort = atoi(argv[c+1]);
+            c++;
+            continue;
+        }
+
+        if (!strcmp(arg, "--bt-link") && argv[c+1]) {
+            if (sscanf(argv[c+1], "%u,%u", &sys.opt_btPipeBandwidth, &sys.opt_btPipeLatency) != 2) {
+                message("Error: invalid link argument \"%s\"", argv[c+1]);
+                return 1;
+            }
+            c++;
+            continue;
+        }
+
+        if (!strcmp(arg, "--usb-link") && argv[c+1]) {
+            if (sscanf(argv[c+1], "%u,%u", &sys.opt_usbPipeBandwidth, &sys.opt_usbPipeLatency) != 2) {
+                message("Error: invalid link argument \"%s\"", argv[c+1]);
+                return 1;
+            }
+            c++;
+            continue;
+        }
+
         if (!strncmp(arg, "-psn_", 5)) {
             // Used by Mac OS app bundles; ignore it.
             continue;
@@ -25,18 +25,71 @@
  */
 
 #include "btprotocol.h"
+#include "mc_datapipe.h"
+#include "system_mc.h"
+#include "tasks.h"
 
 /*
- * Siftulator doesn't yet support Bluetooth. This file contains stubs which
- * implement a fake Bluetooth device that's never available.
+ * Siftulator's Bluetooth device is only available when its data pipe is
+ * bridged to a socket (--bt-pipe). A connected socket client plays the
+ * part of a connected Bluetooth LE peer. The host sees the same packets
+ * that would cross the Data IN and Data OUT characteristics.
  */
 
+DataPipe SimBluetooth::pipe("Bluetooth", _SYS_BT_PACKET_BYTES + 1);
+bool SimBluetooth::producePending;
+
 bool BTProtocolHardware::isAvailable()
 {
-    return false;
+    return SimBluetooth::pipe.isEnabled();
 }
 
 void BTProtocolHardware::requestProduceData()
 {
-    // Nothing to do.
+    SimBluetooth::producePending = true;
+    Tasks::trigger(Tasks::BluetoothDriver);
+}
+
+void SimBluetooth::poll(uint64_t ticks)
+{
+    /*
+     * Runs as simulated time elapses. Like the nRF8001's interrupt, this
+     * only wakes up our driver task; callbacks into BTProtocol happen there.
+     */
+
+    if (!pipe.isEnabled())
+        return;
+
+    if (pipe.needsService(ticks) || (producePending && pipe.isReadyToSend(ticks)))
+        Tasks::trigger(Tasks::BluetoothDriver);
+
+    pipe.flush(ticks);
+}
+
+void SimBluetooth::task()
+{
+    uint64_t ticks = SystemMC::getTicks();
+
+    if (pipe.connectionChanged()) {
+        producePending = true;
+        if (pipe.isConnected())
+            BTProtocolCallbacks::onConnect();
+        else
+            BTProtocolCallbacks::onDisconnect();
+    }
+
+    DataPipe::Packet packet;
+    while (pipe.receive(ticks, packet))
+        BTProtocolCallbacks::onReceiveData(packet.bytes, packet.length);
+
+    // Like the nRF8001 driver, produce another packet each time we could send one.
+    while (producePending && pipe.isReadyToSend(ticks)) {
+        uint8_t buffer[_SYS_BT_PACKET_BYTES + 1];
+        unsigned length = BTProtocolCallbacks::onProduceData(buffer);
+        if (!length) {
+            producePending = false;
+            break;
+        }
+        pipe.send(ticks, buffer, length);
+    }
 }
@@ -29,9 +29,6 @@
 #include "system.h"
 #include "system_mc.h"
 
-static uint32_t gCrc;
-static bool gCrcInit = false;
-
 /**
  * Generated on Thu May 17 13:21:33 2012,
  * by pycrc v0.7.10, http://www.tty1.net/pycrc/
@@ -116,7 +113,7 @@ static const uint32_t gCrcTable[256] =
 
 void Crc32::init()
 {
-    gCrcInit = true;
+    SystemMC::getPeripherals().crcInit = true;
 
     /*
      * Self-test
@@ -139,19 +136,21 @@ void Crc32::init()
 
 void Crc32::deinit()
 {
-    gCrcInit = false;
+    SystemMC::getPeripherals().crcInit = false;
 }
 
 void Crc32::reset()
 {
-    ASSERT(gCrcInit);
-    gCrc = 0xffffffff;
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+    ASSERT(p.crcInit);
+    p.crc = 0xffffffff;
 }
 
 uint32_t Crc32::get()
 {
-    ASSERT(gCrcInit);
-    return gCrc;
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+    ASSERT(p.crcInit);
+    return p.crc;
 }
 
 void Crc32::addInline(uint32_t word)
@@ -162,11 +161,14 @@ void Crc32::addInline(uint32_t word)
 
 void Crc32::add(uint32_t word)
 {
-    ASSERT(gCrcInit);
-    gCrc = (gCrcTable[((gCrc >> 24) ^ (word >> 24)) & 0xff] ^ (gCrc << 8));
-    gCrc = (gCrcTable[((gCrc >> 24) ^ (word >> 16)) & 0xff] ^ (gCrc << 8));
-    gCrc = (gCrcTable[((gCrc >> 24) ^ (word >> 8 )) & 0xff] ^ (gCrc << 8));
-    gCrc = (gCrcTable[((gCrc >> 24) ^ (word      )) & 0xff] ^ (gCrc << 8));
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+    uint32_t crc = p.crc;
+    ASSERT(p.crcInit);
+    crc = (gCrcTable[((crc >> 24) ^ (word >> 24)) & 0xff] ^ (crc << 8));
+    crc = (gCrcTable[((crc >> 24) ^ (word >> 16)) & 0xff] ^ (crc << 8));
+    crc = (gCrcTable[((crc >> 24) ^ (word >> 8 )) & 0xff] ^ (crc << 8));
+    crc = (gCrcTable[((crc >> 24) ^ (word      )) & 0xff] ^ (crc << 8));
+    p.crc = crc;
 }
 
 void Crc32::addUniqueness()
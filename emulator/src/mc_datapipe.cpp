@@ -0,0 +1,380 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Must be before other headers
+#ifdef _WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   define WINVER WindowsXP
+#   define _WIN32_WINNT 0x502
+#   include <windows.h>
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#else
+#   include <sys/types.h>
+#   include <sys/socket.h>
+#   include <sys/select.h>
+#   include <netinet/tcp.h>
+#   include <netinet/in.h>
+#   include <netdb.h>
+#   include <unistd.h>
+#   define closesocket(_s) close(_s)
+#endif
+
+#ifdef MSG_NOSIGNAL
+#   define SEND_FLAGS MSG_NOSIGNAL
+#else
+#   define SEND_FLAGS 0
+#endif
+
+#include "mc_datapipe.h"
+#include "mc_timing.h"
+#include "macros.h"
+#include <string.h>
+#include <stdio.h>
+
+
+DataPipe::DataPipe(const char *name, unsigned maxPacketBytes)
+    : name(name), maxPacketBytes(maxPacketBytes), port(0), running(false),
+      thread(0), bytesPerSecond(0), latencyTicks(0), rxLinkFree(0),
+      txLinkFree(0), connected(false), clientConnected(false), rxStamped(0)
+{
+    ASSERT(maxPacketBytes <= MAX_PACKET_BYTES);
+}
+
+void DataPipe::start(int port, unsigned bytesPerSecond, unsigned latencyUS)
+{
+    /*
+     * Spawn a thread which listens for connections on our socket.
+     */
+
+    ASSERT(running == false);
+    ASSERT(thread == NULL);
+
+    this->port = port;
+    this->bytesPerSecond = bytesPerSecond;
+    this->latencyTicks = latencyUS * (MCTiming::TICK_HZ / 1000000);
+
+    running = true;
+    thread = new tthread::thread(threadEntry, (void*) this);
+}
+
+void DataPipe::stop()
+{
+    /*
+     * Ask the background thread to stop at its next convenience,
+     * asynchronously. Does not wait for the thread.
+     */
+
+    running = false;
+}
+
+uint64_t DataPipe::transferTicks(unsigned bytes) const
+{
+    // Time for this many bytes to cross the link, not counting latency.
+    if (!bytesPerSecond)
+        return 0;
+    return uint64_t(bytes) * MCTiming::TICK_HZ / bytesPerSecond;
+}
+
+bool DataPipe::connectionChanged()
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    if (clientConnected == connected)
+        return false;
+
+    connected = clientConnected;
+    txDelay.clear();
+    rxLinkFree = 0;
+    txLinkFree = 0;
+
+    if (!connected) {
+        // Anything still in flight is lost along with the connection
+        rxQueue.clear();
+        rxStamped = 0;
+        txBuffer.clear();
+    }
+
+    return true;
+}
+
+void DataPipe::stampArrivals(uint64_t ticks)
+{
+    /*
+     * Packets from the socket thread get an arrival time the first time
+     * we see them. Each one occupies the link in turn, then takes a fixed
+     * latency to show up on the other end. Caller holds 'lock'.
+     */
+
+    for (; rxStamped < rxQueue.size(); ++rxStamped) {
+        Packet &p = rxQueue[rxStamped];
+        rxLinkFree = MAX(ticks, rxLinkFree) + transferTicks(p.length);
+        p.deadline = rxLinkFree + latencyTicks;
+    }
+}
+
+bool DataPipe::needsService(uint64_t ticks)
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    if (clientConnected != connected)
+        return true;
+
+    stampArrivals(ticks);
+    return !rxQueue.empty() && rxQueue.front().deadline <= ticks;
+}
+
+bool DataPipe::receive(uint64_t ticks, Packet &packet)
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    stampArrivals(ticks);
+    if (rxQueue.empty() || rxQueue.front().deadline > ticks)
+        return false;
+
+    packet = rxQueue.front();
+    rxQueue.pop_front();
+    rxStamped--;
+    return true;
+}
+
+void DataPipe::send(uint64_t ticks, const uint8_t *bytes, unsigned length)
+{
+    ASSERT(length > 0 && length <= maxPacketBytes);
+
+    txDelay.push_back(Packet());
+    Packet &p = txDelay.back();
+
+    txLinkFree = MAX(ticks, txLinkFree) + transferTicks(length);
+    p.deadline = txLinkFree + latencyTicks;
+    p.length = length;
+    memcpy(p.bytes, bytes, length);
+}
+
+void DataPipe::flush(uint64_t ticks)
+{
+    if (txDelay.empty() || txDelay.front().deadline > ticks)
+        return;
+
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    while (!txDelay.empty() && txDelay.front().deadline <= ticks) {
+        const Packet &p = txDelay.front();
+        txBuffer.push_back(p.length);
+        txBuffer.insert(txBuffer.end(), p.bytes, p.bytes + p.length);
+        txDelay.pop_front();
+    }
+}
+
+void DataPipe::setClientConnected(bool c)
+{
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    clientConnected = c;
+    if (c) {
+        // Don't let a previous client's data leak into this connection
+        rxQueue.clear();
+        rxStamped = 0;
+        txBuffer.clear();
+    }
+}
+
+void DataPipe::threadEntry(void *param)
+{
+    DataPipe *self = (DataPipe *) param;
+    self->threadMain();
+}
+
+void DataPipe::threadMain()
+{
+    /*
+     * Listen for incoming TCP connections, and invoke handleClient()
+     * for each one. Only one client can be connected at a time.
+     */
+
+    #ifdef _WIN32
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+    #endif
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = 0x0100007f;
+    addr.sin_port = htons(port);
+
+    int listenFD = socket(AF_INET, SOCK_STREAM, 0);
+
+    unsigned long arg = 1;
+    setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, (const char *)&arg, sizeof arg);
+
+    if (bind(listenFD, (struct sockaddr *)&addr, sizeof addr) < 0) {
+        fprintf(stderr, "%s pipe: Can't bind to port!\n", name);
+        closesocket(listenFD);
+        return;
+    }
+
+    if (listen(listenFD, 1) < 0) {
+        fprintf(stderr, "%s pipe: Can't listen on socket\n", name);
+        closesocket(listenFD);
+        return;
+    }
+
+    fprintf(stderr, "%s pipe: Listening on port %d\n", name, port);
+
+    while (running) {
+        fd_set rfds;
+        struct timeval pollInterval = { 0, 100000 };  // 100ms
+
+        FD_ZERO(&rfds);
+        FD_SET(listenFD, &rfds);
+        if (select(listenFD + 1, &rfds, NULL, NULL, &pollInterval) < 1)
+            continue;
+
+        struct sockaddr_in addr;
+        socklen_t addrSize = sizeof addr;
+        int clientFD = accept(listenFD, (struct sockaddr *) &addr, &addrSize);
+        if (clientFD < 0)
+            break;
+
+        fprintf(stderr, "%s pipe: Client connected\n", name);
+        handleClient(clientFD);
+        fprintf(stderr, "%s pipe: Client disconnected\n", name);
+
+        closesocket(clientFD);
+    }
+
+    closesocket(listenFD);
+}
+
+void DataPipe::handleClient(int fd)
+{
+    /*
+     * Per-client loop. Reassemble incoming packets for the MC thread, and
+     * send whatever packets it has finished transmitting. We stop reading
+     * while the MC thread has a large backlog, so that a fast client sees
+     * TCP flow control instead of unbounded buffering.
+     */
+
+    unsigned long arg;
+    #ifdef SO_NOSIGPIPE
+        arg = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &arg, sizeof arg);
+    #endif
+    arg = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&arg, sizeof arg);
+
+    Packet partial;
+    unsigned partialLen = 0;
+
+    setClientConnected(true);
+
+    while (running) {
+        fd_set rfds;
+        uint8_t rxBuffer[4096];
+        struct timeval pollInterval = { 0, 1000 };  // 1ms
+        bool wantRead;
+
+        {
+            tthread::lock_guard<tthread::mutex> guard(lock);
+            wantRead = rxQueue.size() < MAX_RX_BACKLOG;
+        }
+
+        FD_ZERO(&rfds);
+        if (wantRead)
+            FD_SET(fd, &rfds);
+
+        int sel = select(fd + 1, &rfds, NULL, NULL, &pollInterval);
+        if (sel > 0 && FD_ISSET(fd, &rfds)) {
+            int ret = recv(fd, (char *) rxBuffer, sizeof rxBuffer, 0);
+            if (ret <= 0)
+                break;
+            if (!rxBytes(rxBuffer, ret, partial, partialLen))
+                break;
+        }
+
+        if (!txFlush(fd))
+            break;
+    }
+
+    setClientConnected(false);
+}
+
+bool DataPipe::rxBytes(const uint8_t *bytes, unsigned len, Packet &partial, unsigned &partialLen)
+{
+    /*
+     * Reassemble length-prefixed packets. 'partialLen' counts the bytes
+     * we have so far, including the length byte. Returns false on a
+     * framing error, which disconnects the client.
+     */
+
+    tthread::lock_guard<tthread::mutex> guard(lock);
+
+    while (len--) {
+        uint8_t byte = *(bytes++);
+
+        if (partialLen == 0) {
+            if (byte == 0 || byte > maxPacketBytes) {
+                fprintf(stderr, "%s pipe: Bad packet length (%d)\n", name, byte);
+                return false;
+            }
+            partial.length = byte;
+            partialLen = 1;
+            continue;
+        }
+
+        partial.bytes[partialLen - 1] = byte;
+        if (partialLen++ == partial.length) {
+            rxQueue.push_back(partial);
+            partialLen = 0;
+        }
+    }
+
+    return true;
+}
+
+bool DataPipe::txFlush(int fd)
+{
+    std::vector<uint8_t> buffer;
+
+    {
+        tthread::lock_guard<tthread::mutex> guard(lock);
+        buffer.swap(txBuffer);
+    }
+
+    const char *p = (const char *) &buffer[0];
+    unsigned remaining = buffer.size();
+
+    while (remaining) {
+        int ret = ::send(fd, p, remaining, SEND_FLAGS);
+        if (ret <= 0)
+            return false;
+        p += ret;
+        remaining -= ret;
+    }
+
+    return true;
+}
@@ -0,0 +1,176 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Siftulator's stand-in for the Base's USB and Bluetooth data links.
+ *
+ * Each link is bridged to a local TCP socket, so that companion apps and
+ * test scripts can exchange packets with a game running in the simulator.
+ * On the socket, every packet is framed as a single length byte followed
+ * by that many bytes of packet data. The packet data is exactly what the
+ * real link would carry: a 4-byte USBProtocol header plus payload for USB,
+ * or a 1-byte type plus payload for Bluetooth.
+ *
+ * A separate thread owns the socket. The MC simulation thread moves packets
+ * in and out of it, applying a simple bandwidth and latency model in
+ * simulated time, so that the game sees approximately the packet timing
+ * it would see on hardware regardless of how fast the host is.
+ */
+
+#ifndef MC_DATAPIPE_H
+#define MC_DATAPIPE_H
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "tinythread.h"
+
+
+class DataPipe {
+public:
+    static const unsigned MAX_PACKET_BYTES = 64;
+
+    struct Packet {
+        uint64_t deadline;
+        uint8_t length;
+        uint8_t bytes[MAX_PACKET_BYTES];
+    };
+
+    DataPipe(const char *name, unsigned maxPacketBytes);
+
+    /// Listen on a TCP port, with the given link model. Zero bandwidth is unlimited.
+    void start(int port, unsigned bytesPerSecond, unsigned latencyUS);
+    void stop();
+
+    bool isEnabled() const {
+        return port != 0;
+    }
+
+    /*
+     * Everything below is only for the MC thread.
+     */
+
+    /// Has a client connected or disconnected since the last call?
+    bool connectionChanged();
+
+    /// Is a client connected, as of the last connectionChanged()?
+    bool isConnected() const {
+        return connected;
+    }
+
+    /// Has the connection changed, or has a host-to-device packet arrived by now?
+    bool needsService(uint64_t ticks);
+
+    /// Retrieve the next host-to-device packet, if it has arrived by now.
+    bool receive(uint64_t ticks, Packet &packet);
+
+    /// Is the device-to-host direction of the link idle?
+    bool isReadyToSend(uint64_t ticks) const {
+        return connected && ticks >= txLinkFree;
+    }
+
+    /// Start sending a device-to-host packet. It occupies the link for a while.
+    void send(uint64_t ticks, const uint8_t *bytes, unsigned length);
+
+    /// Hand any device-to-host packets that have arrived to the socket thread.
+    void flush(uint64_t ticks);
+
+private:
+    // Stop reading from the socket when this many packets are waiting
+    static const unsigned MAX_RX_BACKLOG = 256;
+
+    const char *name;
+    unsigned maxPacketBytes;
+    int port;
+    volatile bool running;
+    tthread::thread *thread;
+
+    // Link model, in MC ticks
+    unsigned bytesPerSecond;
+    unsigned latencyTicks;
+    uint64_t rxLinkFree;
+    uint64_t txLinkFree;
+
+    // Owned by the MC thread
+    bool connected;
+    std::deque<Packet> txDelay;
+
+    // Shared with the socket thread, protected by 'lock'
+    tthread::mutex lock;
+    bool clientConnected;
+    unsigned rxStamped;
+    std::deque<Packet> rxQueue;
+    std::vector<uint8_t> txBuffer;
+
+    uint64_t transferTicks(unsigned bytes) const;
+    void stampArrivals(uint64_t ticks);
+
+    static void threadEntry(void *param);
+    void threadMain();
+    void handleClient(int fd);
+    bool rxBytes(const uint8_t *bytes, unsigned len, Packet &partial, unsigned &partialLen);
+    bool txFlush(int fd);
+    void setClientConnected(bool c);
+};
+
+
+/// Siftulator's Bluetooth hardware. Implemented by mc_bluetooth.cpp
+class SimBluetooth {
+public:
+    static DataPipe pipe;
+
+    /// Called as time elapses. Only wakes up task(), like a driver ISR would.
+    static void poll(uint64_t ticks);
+
+    /// Tasks::BluetoothDriver handler, moves packets to and from BTProtocol.
+    static void task();
+
+private:
+    static bool producePending;
+    friend class BTProtocolHardware;
+};
+
+
+/// Siftulator's USB hardware. Implemented by mc_usb.cpp
+class SimUSB {
+public:
+    static DataPipe pipe;
+
+    /// Called as time elapses. Only wakes up the USB tasks, like an ISR would.
+    static void poll(uint64_t ticks);
+
+    /// Tasks::UsbOUT handler, dispatches packets that have arrived from the host.
+    static void handleOUTData();
+
+    static bool isConnected();
+    static bool isReadyToSend();
+    static void write(const uint8_t *bytes, unsigned length);
+
+private:
+    static bool inPending;
+};
+
+#endif  // MC_DATAPIPE_H
@@ -34,6 +34,7 @@ void ELFDebugInfo::clear()
 {
     sections.clear();
     sectionMap.clear();
+    symbolIndex.clear();
 }
 
 bool ELFDebugInfo::copyProgramBytes(FlashMapSpan::ByteOffset byteOffset,
@@ -111,6 +112,36 @@ std::string ELFDebugInfo::readString(const std::string &section, uint32_t offset
         return "";
 }
 
+ElfSymbolIndex::Entry *ELFDebugInfo::lookupSymbol(uint32_t address) const
+{
+    /*
+     * Find the symbol containing 'address', via an index that's built the
+     * first time we need it. Symbol names are read and cached on demand.
+     */
+
+    if (!symbolIndex.isBuilt()) {
+        std::vector<Elf::Symbol> symbols;
+        const Elf::SectionHeader *SI = findSection(".symtab");
+
+        if (SI) {
+            symbols.resize(SI->sh_size / sizeof(Elf::Symbol));
+            if (!symbols.empty() && !copyProgramBytes(SI->sh_offset,
+                    (uint8_t*) &symbols[0], symbols.size() * sizeof(Elf::Symbol)))
+                symbols.clear();
+        }
+
+        symbolIndex.build(symbols.empty() ? 0 : &symbols[0], symbols.size());
+    }
+
+    ElfSymbolIndex::Entry *entry = symbolIndex.find(address);
+    if (entry && !entry->hasName) {
+        entry->name = readString(".strtab", entry->symbol.st_name);
+        entry->hasName = true;
+    }
+
+    return entry;
+}
+
 bool ELFDebugInfo::findNearestSymbol(uint32_t address,
     Elf::Symbol &symbol, std::string &name) const
 {
@@ -121,36 +152,11 @@ bool ELFDebugInfo::findNearestSymbol(uint32_t address,
     // If nothing is found, we still fill in the output buffer and name
     // with "(unknown)" and zeroes, but 'false' is returned.
 
-    const Elf::SectionHeader *SI = findSection(".symtab");
-    if (SI) {
-        Elf::Symbol currentSym;
-        const uint32_t worstOffset = (uint32_t) -1;
-        uint32_t bestOffset = worstOffset;
-
-        for (unsigned index = 0;; index++) {
-            uint32_t tableOffset = index * sizeof currentSym;
-
-            if (tableOffset + sizeof currentSym > SI->sh_size ||
-                !copyProgramBytes(
-                    SI->sh_offset + tableOffset,
-                    (uint8_t*) &currentSym, sizeof currentSym))
-                break;
-
-            // Strip the Thumb bit from function symbols.
-            if ((currentSym.st_info & 0xF) == Elf::STT_FUNC)
-                currentSym.st_value &= ~1;
-
-            uint32_t addrOffset = address - currentSym.st_value;
-            if (addrOffset < currentSym.st_size && addrOffset < bestOffset) {
-                symbol = currentSym;
-                bestOffset = addrOffset;
-            }
-        }
-
-        if (bestOffset != worstOffset) {
-            name = readString(".strtab", symbol.st_name);
-            return true;
-        }
+    const ElfSymbolIndex::Entry *entry = lookupSymbol(address);
+    if (entry) {
+        symbol = entry->symbol;
+        name = entry->name;
+        return true;
     }
 
     memset(&symbol, 0, sizeof symbol);
@@ -160,12 +166,19 @@ bool ELFDebugInfo::findNearestSymbol(uint32_t address,
 
 std::string ELFDebugInfo::formatAddress(uint32_t address) const
 {
-    Elf::Symbol symbol;
-    std::string name;
-
-    findNearestSymbol(address, symbol, name);
-    demangle(name);
-    uint32_t offset = address - symbol.st_value;
+    ElfSymbolIndex::Entry *entry = lookupSymbol(address);
+    std::string name = "(unknown)";
+    uint32_t offset = address;
+
+    if (entry) {
+        if (!entry->hasDemangledName) {
+            entry->demangledName = entry->name;
+            demangle(entry->demangledName);
+            entry->hasDemangledName = true;
+        }
+        name = entry->demangledName;
+        offset = address - entry->symbol.st_value;
+    }
 
     if (offset != 0) {
         char buf[16];
@@ -28,6 +28,7 @@
 #define ELF_DEBUG_INFO_H
 
 #include "elfprogram.h"
+#include "elfsymbolindex.h"
 #include <vector>
 #include <map>
 #include <string>
@@ -49,9 +50,11 @@ private:
     Elf::Program program;
     sections_t sections;
     sectionMap_t sectionMap;
+    mutable ElfSymbolIndex symbolIndex;
 
     static void demangle(std::string &name);
     std::string readString(const Elf::SectionHeader *SI, uint32_t offset) const;
+    ElfSymbolIndex::Entry *lookupSymbol(uint32_t address) const;
     const Elf::SectionHeader *findSection(const std::string &name) const;
 
     bool copyProgramBytes(FlashMapSpan::ByteOffset byteOffset, uint8_t *dest, uint32_t length) const;
@@ -26,14 +26,12 @@
 
 #include "system.h"
 #include "system_mc.h"
-#include "mc_timing.h"
+#include "mc_flash_timing.h"
 #include "svmmemory.h"
 #include "flash_device.h"
 #include "flash_storage.h"
 #include "lua_filesystem.h"
 
-static int gStealthIOCounter;
-
 
 void FlashDevice::setStealthIO(int counter)
 {
@@ -47,9 +45,10 @@ void FlashDevice::setStealthIO(int counter)
      * afterward.
      */
 
-    gStealthIOCounter += counter;
-    ASSERT(gStealthIOCounter >= 0);
-    ASSERT(gStealthIOCounter <= 4);
+    int &stealthIO = SystemMC::getPeripherals().flashStealthIO;
+    stealthIO += counter;
+    ASSERT(stealthIO >= 0);
+    ASSERT(stealthIO <= 4);
 }
 
 void FlashDevice::read(uint32_t address, uint8_t *buf, unsigned len)
@@ -65,9 +64,9 @@ void FlashDevice::read(uint32_t address, uint8_t *buf, unsigned len)
         ASSERT(0 && "MC flash read() out of range");
     }
 
-    if (!gStealthIOCounter) {
+    if (!SystemMC::getPeripherals().flashStealthIO) {
         LuaFilesystem::onRawRead(address, buf, len);
-        SystemMC::elapseTicks(MCTiming::TICKS_PER_PAGE_MISS);
+        SystemMC::getFlashTiming().read();
     }
 }
 
@@ -90,9 +89,9 @@ void FlashDevice::write(uint32_t address, const uint8_t *buf, unsigned len)
         len <= sizeof storage.bytes &&
         address + len <= sizeof storage.bytes) {
 
-        if (!gStealthIOCounter) {
+        if (!SystemMC::getPeripherals().flashStealthIO) {
             LuaFilesystem::onRawWrite(address, buf, len);
-            SystemMC::elapseTicks(MCTiming::TICKS_PER_PAGE_WRITE);
+            SystemMC::getFlashTiming().write(storage.eraseCounts[address / FlashDevice::ERASE_BLOCK_SIZE]);
         }
 
         // Program bits from 1 to 0 only.
@@ -116,12 +115,12 @@ void FlashDevice::eraseBlock(uint32_t address)
         // Address can be anywhere inside the actual sector
         unsigned sector = address - (address % FlashDevice::ERASE_BLOCK_SIZE);
 
-        if (!gStealthIOCounter) {
+        if (!SystemMC::getPeripherals().flashStealthIO) {
             // Log non-stealth erases, since these will introduce a visible performance hiccup.
             LOG(("FLASH: Erasing block %08x\n", address));
 
             LuaFilesystem::onRawErase(address);
-            SystemMC::elapseTicks(MCTiming::TICKS_PER_BLOCK_ERASE);
+            SystemMC::getFlashTiming().erase(storage.eraseCounts[sector / FlashDevice::ERASE_BLOCK_SIZE]);
         }
 
         memset(storage.bytes + sector, 0xFF, FlashDevice::ERASE_BLOCK_SIZE);
@@ -142,8 +141,8 @@ void FlashDevice::eraseAll()
 
 bool FlashDevice::busy()
 {
-    // everything is done synchronously in simulation
-    return false;
+    // Only ever true if the timing model is running operations asynchronously
+    return SystemMC::getFlashTiming().busy();
 }
 
 void FlashDevice::init()
@@ -0,0 +1,163 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "mc_flash_timing.h"
+#include "mc_timing.h"
+#include "system_mc.h"
+
+
+FlashTimingModel::FlashTimingModel()
+    : busyUntil(0), busyOp(OP_NONE), prngState(1)
+{
+    memset(&stalls, 0, sizeof stalls);
+}
+
+
+void FlashTimingModel::configure(const Params &p)
+{
+    params = p;
+    prngState = p.seed ? p.seed : 1;
+
+    // Anything still in progress finishes with the old timing
+}
+
+void FlashTimingModel::takeStalls(Stalls &s)
+{
+    s = stalls;
+    memset(&stalls, 0, sizeof stalls);
+}
+
+void FlashTimingModel::read()
+{
+    waitForReady(true);
+    stall(MCTiming::TICKS_PER_PAGE_MISS);
+}
+
+void FlashTimingModel::write(unsigned eraseCount)
+{
+    begin(OP_PROGRAM, sample(MCTiming::TICKS_PER_PAGE_WRITE_MIN,
+                             MCTiming::TICKS_PER_PAGE_WRITE,
+                             MCTiming::TICKS_PER_PAGE_WRITE_MAX, eraseCount));
+}
+
+void FlashTimingModel::erase(unsigned eraseCount)
+{
+    begin(OP_ERASE, sample(MCTiming::TICKS_PER_BLOCK_ERASE_MIN,
+                           MCTiming::TICKS_PER_BLOCK_ERASE,
+                           MCTiming::TICKS_PER_BLOCK_ERASE_MAX, eraseCount));
+}
+
+bool FlashTimingModel::busy()
+{
+    if (SystemMC::getTicks() >= busyUntil)
+        return false;
+
+    /*
+     * Reading the status register takes a little time too. This also
+     * guarantees that firmware which spins on busy() makes progress.
+     */
+    SystemMC::elapseTicks(MCTiming::TICKS_PER_FLASH_STATUS);
+    return true;
+}
+
+void FlashTimingModel::begin(Operation op, uint64_t ticks)
+{
+    waitForReady(false);
+
+    if (params.async) {
+        // Only wait if the next command needs the chip
+        busyUntil = SystemMC::getTicks() + ticks;
+        busyOp = op;
+    } else {
+        stall(ticks);
+    }
+}
+
+void FlashTimingModel::waitForReady(bool isRead)
+{
+    uint64_t now = SystemMC::getTicks();
+    if (now >= busyUntil)
+        return;
+
+    if (isRead && params.eraseSuspend && busyOp == OP_ERASE) {
+        /*
+         * Suspend the erase, let the read through, then resume. The erase
+         * makes no progress while suspended, and loses a bit more on resume.
+         */
+        stall(MCTiming::TICKS_PER_ERASE_SUSPEND);
+        busyUntil += MCTiming::TICKS_PER_ERASE_SUSPEND
+                   + MCTiming::TICKS_PER_PAGE_MISS
+                   + MCTiming::TICKS_PER_ERASE_RESUME;
+        return;
+    }
+
+    stall(busyUntil - now);
+}
+
+void FlashTimingModel::stall(uint64_t ticks)
+{
+    // Recursive elapseTicks() calls may issue flash I/O; count ours first.
+    stalls.totalTicks += ticks;
+    stalls.longestTicks = std::max(stalls.longestTicks, ticks);
+    stalls.count++;
+
+    while (ticks) {
+        unsigned chunk = (unsigned) std::min<uint64_t>(ticks, 0x7fffffff);
+        SystemMC::elapseTicks(chunk);
+        ticks -= chunk;
+    }
+}
+
+uint64_t FlashTimingModel::sample(unsigned min, unsigned typ, unsigned max, unsigned eraseCount)
+{
+    double ticks = typ;
+
+    if (params.variation) {
+        /*
+         * Triangular distribution over the datasheet's min/max, peaking
+         * at the typical value. Uses a small xorshift PRNG so that timing
+         * is repeatable for a given seed.
+         */
+        prngState ^= prngState << 13;
+        prngState ^= prngState >> 17;
+        prngState ^= prngState << 5;
+
+        double u = prngState / 4294967296.0;
+        double range = max - min;
+        double split = (typ - min) / range;
+
+        if (u < split)
+            ticks = min + sqrt(u * range * (typ - min));
+        else
+            ticks = max - sqrt((1.0 - u) * range * (max - typ));
+    }
+
+    ticks *= 1.0 + params.wear * eraseCount / 100000.0;
+    return uint64_t(ticks);
+}
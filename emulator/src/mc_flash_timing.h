@@ -0,0 +1,113 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Timing model for the simulated master flash device.
+ *
+ * By default, every flash operation stalls the simulated MCU for a fixed,
+ * typical amount of time. That's a good average, but it hides the things
+ * that actually make a game hitch on hardware: programs and erases on the
+ * real chip run in the background until the next command has to wait for
+ * them, their latency varies from chip to chip and grows with wear, and a
+ * read that lands in the middle of a block erase can only get through by
+ * suspending that erase.
+ *
+ * This model can optionally reproduce all of those, and it keeps track of
+ * how long the MCU was actually blocked on flash, so that scripts can
+ * measure worst-case stalls for a particular workload.
+ *
+ * Each SystemMC owns one model, reachable via SystemMC::getFlashTiming().
+ */
+
+#ifndef _MC_FLASH_TIMING_H
+#define _MC_FLASH_TIMING_H
+
+#include <stdint.h>
+
+
+class FlashTimingModel {
+public:
+    struct Params {
+        // Program/erase run in the background, later commands wait for them
+        bool async;
+
+        // Reads may suspend an in-progress erase (requires 'async')
+        bool eraseSuspend;
+
+        // Pick latencies from the datasheet min/max range, instead of typical
+        bool variation;
+
+        // Fractional increase in program/erase time per 100,000 erase cycles
+        double wear;
+
+        // Seed for latency variation. Same seed, same timing.
+        uint32_t seed;
+
+        Params() : async(false), eraseSuspend(false), variation(false), wear(0), seed(1) {}
+    };
+
+    struct Stalls {
+        uint64_t totalTicks;    // Total time the MCU spent blocked on flash
+        uint64_t longestTicks;  // Longest single blocking operation
+        unsigned count;         // Number of operations that blocked
+    };
+
+    FlashTimingModel();
+
+    void configure(const Params &p);
+    const Params &getParams() const {
+        return params;
+    }
+
+    // Called by FlashDevice for each non-stealth operation
+    void read();
+    void write(unsigned eraseCount);
+    void erase(unsigned eraseCount);
+    bool busy();
+
+    // Read and reset the stall counters
+    void takeStalls(Stalls &s);
+
+private:
+    enum Operation {
+        OP_NONE,
+        OP_PROGRAM,
+        OP_ERASE,
+    };
+
+    Params params;
+    Stalls stalls;
+    uint64_t busyUntil;
+    Operation busyOp;
+    uint32_t prngState;
+
+    void waitForReady(bool isRead);
+    void begin(Operation op, uint64_t ticks);
+    void stall(uint64_t ticks);
+    uint64_t sample(unsigned min, unsigned typ, unsigned max, unsigned eraseCount);
+};
+
+#endif
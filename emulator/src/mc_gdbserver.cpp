@@ -67,6 +67,11 @@ void GDBServer::setMessageCallback(GDBServer::MessageCallback cb)
     instance.messageCb = cb;
 }
 
+void GDBServer::setMemoryCallback(GDBServer::MemoryCallback cb)
+{
+    instance.memoryCb = cb;
+}
+
 void GDBServer::start(int port)
 {
     /*
@@ -178,10 +183,15 @@ void GDBServer::handleClient()
     setNonBlock(clientFD);
 
     resetPacketState();
+    noAckMode = false;
+    targetStopped = false;
+    regsValid = false;
+    ramValidPages = 0;
 
     // On connect, GDB assumes we're already stopped.
     debugBreak();
     clearBreakpoints();
+    clearWatchpoints();
 
     while (1) {
         fd_set efds, rfds;
@@ -275,7 +285,8 @@ void GDBServer::rxBytes(char *bytes, int len)
                 packetState = S_PAYLOAD;
             } else if (byte == 0x03) {
                 debugBreak();
-                txByte('+');
+                if (!noAckMode)
+                    txByte('+');
                 waitingForStop = true;
             }
             break;
@@ -292,7 +303,8 @@ void GDBServer::rxBytes(char *bytes, int len)
                 // Overflowed receive buffer. Discard the packet.
                 // Note the -1 above; we leave room for a NUL terminator.
                 packetState = S_NOT_IN_PACKET;
-                txByte('-');
+                if (!noAckMode)
+                    txByte('-');
             }
             break;
 
@@ -302,7 +314,8 @@ void GDBServer::rxBytes(char *bytes, int len)
                 packetState = S_CHECKSUM_1;
             } else {
                 packetState = S_NOT_IN_PACKET;
-                txByte('-');
+                if (!noAckMode)
+                    txByte('-');
             }
             break;
 
@@ -311,12 +324,13 @@ void GDBServer::rxBytes(char *bytes, int len)
             packetState = S_NOT_IN_PACKET;
             if ((rxChecksum & 0xF) == digitFromHex(byte)) {
                 // Successfully received
-                txByte('+');
+                if (!noAckMode)
+                    txByte('+');
                 
                 // NUL terminate and dispatch.
                 rxPacket[rxPacketLen] = 0;
                 handlePacket();
-            } else {
+            } else if (!noAckMode) {
                 txByte('-');
             }
             break;
@@ -365,6 +379,17 @@ void GDBServer::txHexByte(uint8_t byte)
     txByte(digitToHex(byte));
 }
 
+void GDBServer::txBinaryByte(uint8_t byte)
+{
+    // Binary data, escaping the bytes that are special to the framing
+    if (byte == '#' || byte == '$' || byte == '}' || byte == '*') {
+        txByte('}');
+        txByte(byte ^ 0x20);
+    } else {
+        txByte(byte);
+    }
+}
+
 void GDBServer::txHexWord(uint32_t word)
 {
     txHexByte(word >> 0);
@@ -381,6 +406,14 @@ uint8_t GDBServer::rxByte(uint32_t &offset)
         return 0;
 }
 
+uint8_t GDBServer::rxBinaryByte(uint32_t &offset)
+{
+    uint8_t byte = rxByte(offset);
+    if (byte == '}')
+        return rxByte(offset) ^ 0x20;
+    return byte;
+}
+
 uint8_t GDBServer::rxHexByte(uint32_t &offset)
 {
     int high = digitFromHex(rxByte(offset));
@@ -440,11 +473,29 @@ void GDBServer::handlePacket()
     switch (rxPacket[0])
     {
         case 'q': {
-            if (packetStartsWith("qSupported")) return txPacketString("PacketSize=100");
+            if (packetStartsWith("qSupported")) return txPacketString(
+                "PacketSize=4000;QStartNoAckMode+;binary-upload+");
             if (packetStartsWith("qOffsets"))   return txPacketString("Text=0;Data=0;Bss=0");
             break;
         }
 
+        case 'Q': {
+            if (packetStartsWith("QStartNoAckMode")) {
+                // This reply is still acknowledged, but nothing after it.
+                txPacketString("OK");
+                noAckMode = true;
+                return;
+            }
+            break;
+        }
+
+        case 'v': {
+            if (packetStartsWith("vCont?"))     return txPacketString("vCont;c;C;s;S");
+            if (packetStartsWith("vCont;") && handleVCont())
+                return;
+            break;
+        }
+
         case '?': {
             // Why did we last stop?
             waitingForStop = true;
@@ -453,14 +504,11 @@ void GDBServer::handlePacket()
 
         case 'g': {
             // Read all registers
+            if (!regsValid)
+                readRegisters();
             txPacketBegin();
-            uint32_t bitmap = Debugger::allRegisterBits();
-            msgCmd[0] = Debugger::M_READ_REGISTERS | bitmap;
-            uint32_t replyLen = message(1);
-            for (uint32_t r = 0; r < NUM_GDB_REGISTERS; r++) {
-                uint32_t word = findRegisterInPacket(bitmap, regGDBtoSVM(r));
-                txHexWord((word < replyLen) ? msgReply[word] : -1);
-            }
+            for (uint32_t r = 0; r < NUM_GDB_REGISTERS; r++)
+                txHexWord(regSnapshot[r]);
             return txPacketEnd();
         }
 
@@ -478,23 +526,19 @@ void GDBServer::handlePacket()
             }
             msgCmd[0] = Debugger::M_WRITE_REGISTERS | bitmap;
             message(1 + svmRegCount);
+            regsValid = false;
             return txPacketString("OK");
         }
 
         case 'p': {
             // Read single register
             txPacketBegin();
-            int reg = 0;
+            unsigned reg = 0;
             if (sscanf(rxPacket, "p%x", &reg) == 1) {
-                uint32_t bitmap = Debugger::allRegisterBits() & Debugger::argBit(regGDBtoSVM(reg));
-                if (bitmap) {
-                    msgCmd[0] = Debugger::M_READ_REGISTERS | bitmap;
-                    if (message(1) == 1)
-                        txHexWord(msgReply[0]);
-                } else {
-                    // Unavailable register
-                    txHexWord(-1);
-                }
+                if (!regsValid)
+                    readRegisters();
+                // Unavailable registers read as all ones
+                txHexWord(reg < NUM_GDB_REGISTERS ? regSnapshot[reg] : -1);
             }
             return txPacketEnd();
         }
@@ -505,14 +549,43 @@ void GDBServer::handlePacket()
             txPacketBegin();
             if (sscanf(rxPacket, "m%x,%x", &addr, &size) == 2)
                 while (size > 0) {
-                    uint8_t buffer[128];
+                    uint8_t buffer[1024];
                     int chunk = MIN((int) sizeof buffer, size);
                     if (!readMemory(addr, buffer, chunk))
                         break;
                     for (int i = 0; i < chunk; ++i)
                         txHexByte(buffer[i]);
+                    addr += chunk;
+                    size -= chunk;
+                }
+            return txPacketEnd();
+        }
+
+        case 'x': {
+            // Read memory, binary reply. Escaping may double the size.
+            int addr = 0, size = 0;
+            txPacketBegin();
+            if (sscanf(rxPacket, "x%x,%x", &addr, &size) == 2) {
+                bool empty = true;
+                size = MIN(size, (int) MAX_PACKET / 2);
+                if (size == 0)
+                    txByte('b');
+                while (size > 0) {
+                    uint8_t buffer[1024];
+                    int chunk = MIN((int) sizeof buffer, size);
+                    if (!readMemory(addr, buffer, chunk))
+                        break;
+                    if (empty)
+                        txByte('b');
+                    empty = false;
+                    for (int i = 0; i < chunk; ++i)
+                        txBinaryByte(buffer[i]);
+                    addr += chunk;
                     size -= chunk;
                 }
+                if (empty && size)
+                    txString("E01");
+            }
             return txPacketEnd();
         }
 
@@ -524,7 +597,21 @@ void GDBServer::handlePacket()
             int addr = 0, size = 0;
             if (delim && sscanf(rxPacket, "M%x,%x", &addr, &size) == 2) {
                 uint32_t offset = (delim - rxPacket) + 1;
-                if (writeMemory(addr, size, offset))
+                if (writeMemory(addr, size, offset, false))
+                    txString("OK");
+            }
+            return txPacketEnd();
+        }
+
+        case 'X': {
+            // Write memory, binary data (RAM only)
+            // Xaddr,length:bytes...
+            txPacketBegin();
+            char *delim = (char*) memchr(rxPacket, ':', rxPacketLen);
+            int addr = 0, size = 0;
+            if (delim && sscanf(rxPacket, "X%x,%x", &addr, &size) == 2) {
+                uint32_t offset = (delim - rxPacket) + 1;
+                if (writeMemory(addr, size, offset, true))
                     txString("OK");
             }
             return txPacketEnd();
@@ -532,23 +619,20 @@ void GDBServer::handlePacket()
 
         case 'D': {
             // Detach debugger
-            msgCmd[0] = Debugger::M_DETACH;
-            message(1);
+            resume(Debugger::M_DETACH);
             return txPacketString("OK");
         }
 
         case 'c': {
             // Continue executing; clear stop signal.
-            msgCmd[0] = Debugger::M_SIGNAL | Debugger::S_RUNNING;
-            message(1);
+            resume(Debugger::M_SIGNAL | Debugger::S_RUNNING);
             waitingForStop = true;
             return;
         }
 
         case 's': {
             // Single step
-            msgCmd[0] = Debugger::M_STEP;
-            message(1);
+            resume(Debugger::M_STEP);
             waitingForStop = true;
             return;
         }
@@ -558,8 +642,11 @@ void GDBServer::handlePacket()
             txPacketBegin();
             int t = 0, addr = 0, length = 0;
             if (sscanf(rxPacket, "Z%x,%x,%x", &t, &addr, &length) == 3) {
+                uint32_t watchType = watchTypeFromGDB(t);
                 if ((t == 0 || t == 1) && insertBreakpoint(addr))
                     txString("OK");
+                else if (watchType && insertWatchpoint(addr, watchType | (length & Debugger::WATCH_LENGTH_MASK)))
+                    txString("OK");
                 else
                     txString("E01");
             }
@@ -571,9 +658,13 @@ void GDBServer::handlePacket()
             txPacketBegin();
             int t = 0, addr = 0, length = 0;
             if (sscanf(rxPacket, "z%x,%x,%x", &t, &addr, &length) == 3) {
+                uint32_t watchType = watchTypeFromGDB(t);
                 if (t == 0 || t == 1) {
                     removeBreakpoint(addr);
                     txString("OK");
+                } else if (watchType) {
+                    removeWatchpoint(addr, watchType | (length & Debugger::WATCH_LENGTH_MASK));
+                    txString("OK");
                 } else {
                     txString("E01");
                 }
@@ -603,13 +694,31 @@ void GDBServer::pollForStop()
         return;
 
     msgCmd[0] = Debugger::M_IS_STOPPED;
-    if (message(1) >= 1) {
+    uint32_t replyLen = message(1);
+    if (replyLen >= 1) {
         int signal = msgReply[0];
         if (signal != Debugger::S_RUNNING) {
+            uint32_t watchType = replyLen >= 3 ? msgReply[1] : Debugger::W_NONE;
+            uint32_t watchAddr = replyLen >= 3 ? msgReply[2] : 0;
+
+            // Read registers now, GDB will ask for them right away.
+            snapshotStop();
 
             txPacketBegin();
-            txByte('S');
-            txHexByte(signal);
+            if (watchType != Debugger::W_NONE) {
+                // Stopped by a watchpoint; say which kind, and where.
+                char buf[32];
+                const char *reason = "awatch";
+                if (watchType == Debugger::W_WRITE) reason = "watch";
+                if (watchType == Debugger::W_READ) reason = "rwatch";
+                snprintf(buf, sizeof buf, "%s:%x;", reason, watchAddr);
+                txByte('T');
+                txHexByte(signal);
+                txString(buf);
+            } else {
+                txByte('S');
+                txHexByte(signal);
+            }
             txPacketEnd();
             txFlush();
 
@@ -618,11 +727,129 @@ void GDBServer::pollForStop()
     }
 }
 
+bool GDBServer::handleVCont()
+{
+    /*
+     * We only have one thread, so the first action applies to it. Signals
+     * passed with 'C' and 'S' are ignored, just like the target does for
+     * 'c' and 's'. Returns false for actions we don't support.
+     */
+
+    switch (rxPacket[6]) {
+        case 'c':
+        case 'C':
+            resume(Debugger::M_SIGNAL | Debugger::S_RUNNING);
+            break;
+
+        case 's':
+        case 'S':
+            resume(Debugger::M_STEP);
+            break;
+
+        default:
+            return false;
+    }
+
+    waitingForStop = true;
+    return true;
+}
+
+void GDBServer::resume(uint32_t msg)
+{
+    // Anything that lets the target run discards our snapshot first.
+    targetStopped = false;
+    regsValid = false;
+    ramValidPages = 0;
+
+    msgCmd[0] = msg;
+    message(1);
+}
+
+void GDBServer::snapshotStop()
+{
+    /*
+     * The target has stopped. Start a new snapshot, with the registers
+     * read in one message. RAM pages are read later, as needed.
+     */
+
+    targetStopped = true;
+    ramValidPages = 0;
+    readRegisters();
+}
+
+void GDBServer::readRegisters()
+{
+    // Registers only stay valid while we know the target is stopped.
+
+    uint32_t bitmap = Debugger::allRegisterBits();
+    msgCmd[0] = Debugger::M_READ_REGISTERS | bitmap;
+    uint32_t replyLen = message(1);
+    for (uint32_t r = 0; r < NUM_GDB_REGISTERS; r++) {
+        uint32_t word = findRegisterInPacket(bitmap, regGDBtoSVM(r));
+        regSnapshot[r] = (word < replyLen) ? msgReply[word] : -1;
+    }
+    regsValid = targetStopped;
+}
+
+void GDBServer::snapshotInvalidate(uint32_t addr, uint32_t bytes)
+{
+    // Forget any snapshot pages that overlap a write.
+    for (unsigned i = 0; i < SNAPSHOT_PAGES; ++i) {
+        uint32_t page = SvmMemory::VIRTUAL_RAM_BASE + i * SNAPSHOT_PAGE_SIZE;
+        if (addr < page + SNAPSHOT_PAGE_SIZE && addr + bytes > page)
+            ramValidPages &= ~(1 << i);
+    }
+}
+
+bool GDBServer::snapshotRead(uint32_t addr, uint8_t *buffer, uint32_t bytes)
+{
+    /*
+     * Read RAM from the snapshot, filling in missing pages. Only valid
+     * while the target is stopped, and only for reads entirely in RAM.
+     */
+
+    STATIC_ASSERT(SNAPSHOT_PAGES <= 32);
+
+    uint32_t offset = addr - SvmMemory::VIRTUAL_RAM_BASE;
+    if (!targetStopped || addr < SvmMemory::VIRTUAL_RAM_BASE
+        || offset >= SvmMemory::RAM_SIZE_IN_BYTES
+        || bytes > SvmMemory::RAM_SIZE_IN_BYTES - offset)
+        return false;
+
+    if (bytes == 0)
+        return true;
+
+    unsigned first = offset / SNAPSHOT_PAGE_SIZE;
+    unsigned last = (offset + bytes - 1) / SNAPSHOT_PAGE_SIZE;
+
+    for (unsigned i = first; i <= last; ++i)
+        if (!(ramValidPages & (1 << i))) {
+            uint32_t pageAddr = SvmMemory::VIRTUAL_RAM_BASE + i * SNAPSHOT_PAGE_SIZE;
+            uint8_t *page = ramSnapshot + i * SNAPSHOT_PAGE_SIZE;
+
+            if (memoryCb ? !memoryCb(pageAddr, page, SNAPSHOT_PAGE_SIZE)
+                         : !readTargetMemory(pageAddr, page, SNAPSHOT_PAGE_SIZE))
+                return false;
+            ramValidPages |= 1 << i;
+        }
+
+    memcpy(buffer, ramSnapshot + offset, bytes);
+    return true;
+}
+
 bool GDBServer::readMemory(uint32_t addr, uint8_t *buffer, uint32_t bytes)
 {
     if (debugInfo && debugInfo->readROM(addr, buffer, bytes))
         return true;
 
+    if (snapshotRead(addr, buffer, bytes))
+        return true;
+
+    return readTargetMemory(addr, buffer, bytes);
+}
+
+bool GDBServer::readTargetMemory(uint32_t addr, uint8_t *buffer, uint32_t bytes)
+{
     // We have to go to hardware to complete this read. Break it up into
     // multiple reply-buffer-sized chunks.
 
@@ -645,8 +872,10 @@ bool GDBServer::readMemory(uint32_t addr, uint8_t *buffer, uint32_t bytes)
     return true;
 }
 
-bool GDBServer::writeMemory(uint32_t addr, uint32_t bytes, uint32_t packetOffset)
+bool GDBServer::writeMemory(uint32_t addr, uint32_t bytes, uint32_t packetOffset, bool binary)
 {
+    snapshotInvalidate(addr, bytes);
+
     while (bytes) {
         uint32_t chunk = MIN(bytes, Debugger::MAX_CMD_BYTES - sizeof(uint32_t));
 
@@ -658,7 +887,7 @@ bool GDBServer::writeMemory(uint32_t addr, uint32_t bytes, uint32_t packetOffset
         uint8_t *cmdBytes = reinterpret_cast<uint8_t*>(&msgCmd[2]);
 
         for (uint32_t i = 0; i < chunk; i++)
-            cmdBytes[i] = rxHexByte(packetOffset);
+            cmdBytes[i] = binary ? rxBinaryByte(packetOffset) : rxHexByte(packetOffset);
 
         message((chunk + 3) / 4 + 2);
 
@@ -772,3 +1001,76 @@ void GDBServer::removeBreakpoint(uint32_t addr)
         }
     sendBreakpoints(bitmap);
 }
+
+uint32_t GDBServer::watchTypeFromGDB(int t)
+{
+    // Z2 = write, Z3 = read, Z4 = access watchpoint
+    switch (t) {
+        case 2:     return Debugger::W_WRITE;
+        case 3:     return Debugger::W_READ;
+        case 4:     return Debugger::W_ACCESS;
+        default:    return Debugger::W_NONE;
+    }
+}
+
+uint32_t GDBServer::sendWatchpoints(uint32_t bitmap)
+{
+    /*
+     * Resend one or more watchpoints to the target, from our local cache.
+     * Returns the bitmap of slots that the target accepted.
+     */
+
+    if (!bitmap)
+        return 0;
+
+    unsigned words = 1;
+    uint32_t slots = bitmap << Debugger::BITMAP_SHIFT;
+    msgCmd[0] = Debugger::M_SET_WATCHPOINTS | bitmap;
+
+    while (slots) {
+        unsigned i = Intrinsic::CLZ(slots);
+        slots &= ~Intrinsic::LZ(i);
+        ASSERT(i < Debugger::NUM_WATCHPOINTS);
+        ASSERT(words + 1 < Debugger::MAX_CMD_WORDS);
+        msgCmd[words++] = watchpoints[i].addr;
+        msgCmd[words++] = watchpoints[i].typeAndLength;
+    }
+
+    return message(words) >= 1 ? msgReply[0] : 0;
+}
+
+void GDBServer::clearWatchpoints()
+{
+    memset(watchpoints, 0, sizeof watchpoints);
+    sendWatchpoints(Debugger::ALL_WATCHPOINT_BITS);
+}
+
+bool GDBServer::insertWatchpoint(uint32_t addr, uint32_t typeAndLength)
+{
+    // Find an unused watchpoint slot, and make sure the target took it.
+    for (unsigned i = 0; i < GDB_WATCHPOINTS; ++i)
+        if (watchpoints[i].typeAndLength == 0) {
+            uint32_t bit = Debugger::argBit(i);
+            watchpoints[i].addr = addr;
+            watchpoints[i].typeAndLength = typeAndLength;
+            if (sendWatchpoints(bit) & bit)
+                return true;
+
+            watchpoints[i].typeAndLength = 0;
+            sendWatchpoints(bit);
+            return false;
+        }
+    return false;
+}
+
+void GDBServer::removeWatchpoint(uint32_t addr, uint32_t typeAndLength)
+{
+    // Remove an existing watchpoint.
+    uint32_t bitmap = 0;
+    for (unsigned i = 0; i < GDB_WATCHPOINTS; ++i)
+        if (watchpoints[i].addr == addr && watchpoints[i].typeAndLength == typeAndLength) {
+            watchpoints[i].typeAndLength = 0;
+            bitmap |= Debugger::argBit(i);
+        }
+    sendWatchpoints(bitmap);
+}
@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 #include "svm.h"
+#include "svmmemory.h"
 #include "tinythread.h"
 
 class ELFDebugInfo;
@@ -37,6 +38,7 @@ class ELFDebugInfo;
 class GDBServer {
 public:
     typedef uint32_t (*MessageCallback)(const uint32_t *cmd, uint32_t cmdWords, uint32_t *reply);
+    typedef bool (*MemoryCallback)(uint32_t addr, uint8_t *buffer, uint32_t bytes);
     
     static void start(int port);
     static void stop();
@@ -44,6 +46,10 @@ public:
     static void setDebugInfo(const ELFDebugInfo *info);
     static void setMessageCallback(MessageCallback cb);
 
+    /// Optional bulk RAM reader, used to fill snapshots while the target
+    /// is stopped. Without one, we read RAM through debugger messages.
+    static void setMemoryCallback(MemoryCallback cb);
+
 private:
     GDBServer() {}
     static GDBServer instance;
@@ -51,19 +57,24 @@ private:
     tthread::thread *thread;
     const ELFDebugInfo *debugInfo;
     MessageCallback messageCb;
+    MemoryCallback memoryCb;
 
     int port;
     int clientFD;
     int packetState;
     bool running;
     bool waitingForStop;
+    bool noAckMode;
+
+    // Advertised in qSupported, in hex. Also bounds our 'm' and 'x' replies.
+    static const unsigned MAX_PACKET = 0x4000;
 
     unsigned txBufferLen;
     unsigned rxPacketLen;
     uint8_t rxChecksum;
     uint8_t txChecksum;
-    char txBuffer[2048];
-    char rxPacket[1024];
+    char txBuffer[4096];
+    char rxPacket[MAX_PACKET + 1];
 
     uint32_t msgCmd[Svm::Debugger::MAX_CMD_WORDS];
     uint32_t msgReply[Svm::Debugger::MAX_REPLY_WORDS];
@@ -71,8 +82,27 @@ private:
     static const unsigned GDB_BREAKPOINTS = Svm::Debugger::NUM_BREAKPOINTS;
     uint32_t breakpoints[GDB_BREAKPOINTS];
 
+    static const unsigned GDB_WATCHPOINTS = Svm::Debugger::NUM_WATCHPOINTS;
+    struct Watchpoint {
+        uint32_t addr;
+        uint32_t typeAndLength;
+    } watchpoints[GDB_WATCHPOINTS];
+
     // Register format
     static const unsigned NUM_GDB_REGISTERS = 26;
+
+    /*
+     * Snapshot of the target, taken each time it stops and discarded when
+     * it resumes. Registers are read all at once when we report the stop.
+     * RAM is filled in a page at a time, as GDB asks for it.
+     */
+    static const unsigned SNAPSHOT_PAGE_SIZE = 1024;
+    static const unsigned SNAPSHOT_PAGES = SvmMemory::RAM_SIZE_IN_BYTES / SNAPSHOT_PAGE_SIZE;
+    bool targetStopped;
+    bool regsValid;
+    uint32_t ramValidPages;
+    uint32_t regSnapshot[NUM_GDB_REGISTERS];
+    uint8_t ramSnapshot[SvmMemory::RAM_SIZE_IN_BYTES];
     int regGDBtoSVM(uint32_t r);
     static uint32_t findRegisterInPacket(uint32_t bitmap, uint32_t svmReg);
 
@@ -97,7 +127,10 @@ private:
     void txHexByte(uint8_t byte);
     void txHexWord(uint32_t word);
     
+    void txBinaryByte(uint8_t byte);
+
     uint8_t rxByte(uint32_t &offset);
+    uint8_t rxBinaryByte(uint32_t &offset);
     uint8_t rxHexByte(uint32_t &offset);
     uint32_t rxHexWord(uint32_t &offset);
 
@@ -106,14 +139,28 @@ private:
     
     void debugBreak();
     void pollForStop();
+    void resume(uint32_t msg);
+    bool handleVCont();
+
+    void snapshotStop();
+    void readRegisters();
+    void snapshotInvalidate(uint32_t addr, uint32_t bytes);
+    bool snapshotRead(uint32_t addr, uint8_t *buffer, uint32_t bytes);
 
     void sendBreakpoints(uint32_t bitmap);
     void clearBreakpoints();
     bool insertBreakpoint(uint32_t addr);
     void removeBreakpoint(uint32_t addr);
 
+    static uint32_t watchTypeFromGDB(int t);
+    uint32_t sendWatchpoints(uint32_t bitmap);
+    void clearWatchpoints();
+    bool insertWatchpoint(uint32_t addr, uint32_t typeAndLength);
+    void removeWatchpoint(uint32_t addr, uint32_t typeAndLength);
+
     bool readMemory(uint32_t addr, uint8_t *buffer, uint32_t bytes);
-    bool writeMemory(uint32_t addr, uint32_t bytes, uint32_t packetOffset);
+    bool readTargetMemory(uint32_t addr, uint8_t *buffer, uint32_t bytes);
+    bool writeMemory(uint32_t addr, uint32_t bytes, uint32_t packetOffset, bool binary);
 };
 
 #endif  // GDB_SERVER_H
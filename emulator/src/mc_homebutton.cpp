@@ -27,20 +27,20 @@
 #include "tasks.h"
 #include "macros.h"
 #include "pause.h"
+#include "system_mc.h"
 
 namespace HomeButton
 {
 
-static uint32_t state;
-
-
 void init()
 {
-    state = 0;
+    SystemMC::getPeripherals().homeButton = 0;
 }
 
 void setPressed(bool value)
 {
+    uint32_t &state = SystemMC::getPeripherals().homeButton;
+
     if (state != value) {
         state = value;
         HomeButton::update();
@@ -51,7 +51,7 @@ void setPressed(bool value)
 
 bool isPressed()
 {
-    return state;
+    return SystemMC::getPeripherals().homeButton;
 }
 
 } // namespace HomeButton
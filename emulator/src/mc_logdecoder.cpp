@@ -35,9 +35,10 @@ void LogDecoder::init()
     scriptType = _SYS_SCRIPT_NONE;
     scriptBuffer.clear();
     handlers.clear();
+    formats.clear();
 }
 
-void LogDecoder::formatLog(ELFDebugInfo &DI,
+void LogDecoder::formatLog(ELFDebugInfo *DI,
     char *out, size_t outSize, char *fmt, uint32_t *args, size_t argCount)
 {
     // This is a simple printf()-like formatter, used to format log entries.
@@ -123,7 +124,10 @@ void LogDecoder::formatLog(ELFDebugInfo &DI,
                 case 'P':
                     done = true;
                     ASSERT(argCount && "Too few arguments in format string");
-                    out += snprintf(out, outEnd - out, "%s", DI.formatAddress(*args).c_str());
+                    if (DI)
+                        out += snprintf(out, outEnd - out, "%s", DI->formatAddress(*args).c_str());
+                    else
+                        out += snprintf(out, outEnd - out, "0x%08x", *args);
                     argCount--;
                     args++;
                     break;
@@ -205,7 +209,50 @@ void LogDecoder::formatLog(ELFDebugInfo &DI,
     }
 }
 
-size_t LogDecoder::decode(ELFDebugInfo &DI, SvmLogTag tag, uint32_t *buffer)
+bool LogDecoder::usesSymbols(const char *fmt)
+{
+    // Does this format string have a %P conversion? We skip the same
+    // prefix characters as formatLog(), so "%-10P" and "%8P" count,
+    // but the literal "%%P" doesn't.
+
+    while (const char *p = strchr(fmt, '%')) {
+        p++;
+        while (*p && strchr("0123456789 -+.", *p))
+            p++;
+
+        if (*p == 'P')
+            return true;
+        if (!*p)
+            return false;
+        fmt = p + 1;
+    }
+    return false;
+}
+
+const LogDecoder::Format &LogDecoder::getFormat(ELFDebugInfo *DI, SvmLogTag tag)
+{
+    std::map<uint32_t, Format>::iterator I = formats.find(tag.getParam());
+    if (I != formats.end())
+        return I->second;
+
+    Format &f = formats[tag.getParam()];
+    if (DI) {
+        f.str = DI->readString(".debug_logstr", tag.getParam());
+        f.needsSymbols = usesSymbols(f.str.c_str());
+    } else {
+        f.needsSymbols = false;
+    }
+    return f;
+}
+
+void LogDecoder::defineFormat(uint32_t param, const char *str)
+{
+    Format &f = formats[param];
+    f.str = str;
+    f.needsSymbols = false;
+}
+
+size_t LogDecoder::decode(ELFDebugInfo *DI, SvmLogTag tag, uint32_t *buffer)
 {
     char outBuffer[1024];
 
@@ -214,14 +261,15 @@ size_t LogDecoder::decode(ELFDebugInfo &DI, SvmLogTag tag, uint32_t *buffer)
         // Stow all arguments, plus the log tag. The post-processor
         // will do some printf()-like formatting on the stored arguments.
         case _SYS_LOGTYPE_FMT: {
-            std::string fmt = DI.readString(".debug_logstr", tag.getParam());
+            // formatLog() edits the string in place, but restores it
+            std::string &fmt = const_cast<Format&>(getFormat(DI, tag)).str;
             if (fmt.empty()) {
                 LOG(("SVMLOG: No symbol table found. Raw data:\n"
                      "\t[%08x] %08x %08x %08x %08x %08x %08x %08x\n",
                      tag.getValue(), buffer[0], buffer[1], buffer[2],
                      buffer[3], buffer[4], buffer[5], buffer[6]));
             } else {
-                formatLog(DI, outBuffer, sizeof outBuffer, (char*) fmt.c_str(),
+                formatLog(DI, outBuffer, sizeof outBuffer, &fmt[0],
                     buffer, tag.getArity());
                 writeLog(outBuffer);
             }
@@ -269,7 +317,7 @@ void LogDecoder::writeLog(const char *str)
 {
     if (scriptType == _SYS_SCRIPT_NONE) {
         LOG(("%s", str));
-        if (System::getInstance().opt_flushLogs) {
+        if (SystemMC::getSystem()->opt_flushLogs) {
             fflush(stdout);
         }
     } else {
@@ -291,3 +339,137 @@ void LogDecoder::setScriptHandler(unsigned type, ScriptHandler handler)
 {
     handlers[type] = handler;
 }
+
+
+DeferredLogDecoder::DeferredLogDecoder()
+    : thread(0), busy(false)
+{
+    decoder.init();
+}
+
+void DeferredLogDecoder::start()
+{
+    ASSERT(thread == NULL);
+    thread = new tthread::thread(threadEntry, (void*) this);
+}
+
+void DeferredLogDecoder::reset()
+{
+    if (!isRunning())
+        return;
+
+    tthread::lock_guard<tthread::mutex> guard(lock);
+    defined.clear();
+    append(TYPE_RESET << 27);
+    wake.notify_all();
+}
+
+bool DeferredLogDecoder::commit(LogDecoder &mainDecoder, ELFDebugInfo &DI,
+    SvmLogTag tag, const uint32_t *buffer, uint32_t bytes)
+{
+    if (!isRunning())
+        return false;
+    if (tag.getType() == _SYS_LOGTYPE_SCRIPT || mainDecoder.inScript())
+        return false;
+
+    const LogDecoder::Format *format = 0;
+    if (tag.getType() == _SYS_LOGTYPE_FMT) {
+        format = &mainDecoder.getFormat(&DI, tag);
+        if (format->str.empty() || format->needsSymbols)
+            return false;
+    }
+
+    tthread::lock_guard<tthread::mutex> guard(lock);
+    while (stream.size() > MAX_PENDING_WORDS)
+        idle.wait(lock);
+
+    if (format && defined.insert(tag.getParam()).second) {
+        // First use of this format string; include it, with its NUL.
+        uint32_t length = format->str.size() + 1;
+        append((TYPE_DEFINE << 27) | tag.getParam());
+        append(length);
+        append(format->str.c_str(), length);
+    }
+
+    append(tag.getValue());
+    append(buffer, bytes);
+    wake.notify_all();
+    return true;
+}
+
+void DeferredLogDecoder::flush()
+{
+    if (!isRunning())
+        return;
+
+    tthread::lock_guard<tthread::mutex> guard(lock);
+    while (busy || !stream.empty())
+        idle.wait(lock);
+}
+
+void DeferredLogDecoder::append(uint32_t word)
+{
+    stream.push_back(word);
+}
+
+void DeferredLogDecoder::append(const void *bytes, uint32_t length)
+{
+    // Pad to a whole number of words
+    unsigned offset = stream.size();
+    stream.resize(offset + (length + 3) / 4);
+    memcpy(&stream[offset], bytes, length);
+}
+
+void DeferredLogDecoder::threadEntry(void *param)
+{
+    DeferredLogDecoder *self = (DeferredLogDecoder *) param;
+    self->threadMain();
+}
+
+void DeferredLogDecoder::threadMain()
+{
+    std::vector<uint32_t> words;
+
+    while (1) {
+        {
+            tthread::lock_guard<tthread::mutex> guard(lock);
+            busy = false;
+            idle.notify_all();
+            while (stream.empty())
+                wake.wait(lock);
+            words.swap(stream);
+            busy = true;
+        }
+
+        decodeStream(words);
+        words.clear();
+    }
+}
+
+void DeferredLogDecoder::decodeStream(std::vector<uint32_t> &words)
+{
+    unsigned i = 0;
+    while (i < words.size()) {
+        SvmLogTag tag(words[i++]);
+
+        switch (tag.getType()) {
+
+            case TYPE_RESET:
+                decoder.init();
+                break;
+
+            case TYPE_DEFINE: {
+                uint32_t length = words[i++];
+                decoder.defineFormat(tag.getParam(), (const char *) &words[i]);
+                i += (length + 3) / 4;
+                break;
+            }
+
+            default: {
+                size_t bytes = decoder.decode(NULL, tag, &words[i]);
+                i += (bytes + 3) / 4;
+                break;
+            }
+        }
+    }
+}
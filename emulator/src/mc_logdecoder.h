@@ -29,7 +29,10 @@
 
 #include "mc_elfdebuginfo.h"
 #include "svmdebugpipe.h"
+#include "tinythread.h"
 #include <string>
+#include <vector>
+#include <set>
 #include <map>
 
 class LogDecoder {
@@ -39,6 +42,11 @@ public:
         void *context;
     };
 
+    struct Format {
+        std::string str;
+        bool needsSymbols;      // Uses %P, which reads the ELF symbol table
+    };
+
     // Reset the internal state of the decoder
     void init();
 
@@ -47,10 +55,25 @@ public:
 
     // Decode a log entry with the specified tag and data buffer.
     // Returns the actual number of bytes consumed from 'buffer'.
-    size_t decode(ELFDebugInfo &DI, SvmLogTag tag, uint32_t *buffer);
+    // With no debug info, format strings must already be in the cache.
+    size_t decode(ELFDebugInfo *DI, SvmLogTag tag, uint32_t *buffer);
+
+    // Format string for a _SYS_LOGTYPE_FMT tag, read once per tag and cached.
+    const Format &getFormat(ELFDebugInfo *DI, SvmLogTag tag);
+
+    // Does a format string have a %P conversion, with any prefix?
+    static bool usesSymbols(const char *fmt);
+
+    // Add a format string to the cache directly, without debug info.
+    void defineFormat(uint32_t param, const char *str);
+
+    // Is a script block being collected? Script text must stay in order.
+    bool inScript() const {
+        return scriptType != _SYS_SCRIPT_NONE;
+    }
 
 private:
-    void formatLog(ELFDebugInfo &DI, char *out, size_t outSize,
+    void formatLog(ELFDebugInfo *DI, char *out, size_t outSize,
         char *fmt, uint32_t *args, size_t argCount);
 
     void writeLog(const char *str);
@@ -59,6 +82,69 @@ private:
     unsigned scriptType;
     std::string scriptBuffer;
     std::map<unsigned, ScriptHandler> handlers;
+    std::map<uint32_t, Format> formats;
+};
+
+
+/**
+ * Formats logs on a background thread (--deferred-logs), so that heavy
+ * logging doesn't slow down the simulation thread. The simulation thread
+ * only appends each record's raw tag and argument words to a stream.
+ * The first time a format tag is used, its string goes into the stream
+ * too, so the background thread never touches the program's flash.
+ *
+ * Records that can't be formatted from the stream alone (scripts and
+ * %P symbol lookups) are refused by commit(). The caller should flush()
+ * and decode those synchronously.
+ */
+
+class DeferredLogDecoder {
+public:
+    DeferredLogDecoder();
+
+    void start();
+
+    bool isRunning() const {
+        return thread != 0;
+    }
+
+    // Forget format strings sent so far, when a new program starts
+    void reset();
+
+    // Queue a record for the background thread. Returns false if refused.
+    bool commit(LogDecoder &decoder, ELFDebugInfo &DI, SvmLogTag tag,
+        const uint32_t *buffer, uint32_t bytes);
+
+    // Wait until every queued record has been written
+    void flush();
+
+private:
+    // Internal record types, beyond the _SYS_LOGTYPE_* range
+    static const uint32_t TYPE_DEFINE = 30;
+    static const uint32_t TYPE_RESET = 31;
+
+    // Make the simulation thread wait if the background thread falls this far behind
+    static const unsigned MAX_PENDING_WORDS = 1024 * 1024;
+
+    tthread::thread *thread;
+    tthread::mutex lock;
+    tthread::condition_variable wake;
+    tthread::condition_variable idle;
+    std::vector<uint32_t> stream;
+    bool busy;
+
+    // Only used by the simulation thread
+    std::set<uint32_t> defined;
+
+    // Only used by the background thread
+    LogDecoder decoder;
+
+    void append(uint32_t word);
+    void append(const void *bytes, uint32_t length);
+
+    static void threadEntry(void *param);
+    void threadMain();
+    void decodeStream(std::vector<uint32_t> &words);
 };
 
 #endif  // LOG_DECODER_H
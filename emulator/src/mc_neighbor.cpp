@@ -29,24 +29,17 @@
 #include "system.h"
 #include "system_mc.h"
 
-MCNeighbor::CubeInfo MCNeighbor::cubes[MCNeighbor::NUM_SIDES];
-TickDeadline MCNeighbor::deadline;
-uint32_t MCNeighbor::nbrSides;
-uint32_t MCNeighbor::txSides;
-uint32_t MCNeighbor::txData;
-uint32_t MCNeighbor::txRegister;
-
 
 void MCNeighbor::updateNeighbor(bool touching, unsigned mcSide, unsigned cube, unsigned cubeSide)
 {
     ASSERT(mcSide < NUM_SIDES);
 
     if (touching) {
-        MCNeighbor::cubes[mcSide].id = cube;
-        MCNeighbor::cubes[mcSide].side = cubeSide;
-        MCNeighbor::nbrSides |= 1 << mcSide;
+        cubes[mcSide].id = cube;
+        cubes[mcSide].side = cubeSide;
+        nbrSides |= 1 << mcSide;
     } else {
-        MCNeighbor::nbrSides &= ~(1 << mcSide);
+        nbrSides &= ~(1 << mcSide);
     }
 
     // Wake up virtual hardware simulation
@@ -60,17 +53,21 @@ void NeighborTX::init()
 
 void NeighborTX::start(unsigned data, unsigned sideMask)
 {
-    MCNeighbor::txData = data;
-    MCNeighbor::txSides = sideMask;
+    MCNeighbor &mcn = SystemMC::getSystem()->mcNeighbor;
+
+    mcn.txData = data;
+    mcn.txSides = sideMask;
 
     // Wake up virtual hardware simulation
-    MCNeighbor::deadline.set(0);
+    mcn.deadline.set(0);
 }
 
 void NeighborTX::stop()
 {
-    MCNeighbor::txData = 0;
-    MCNeighbor::txSides = 0;
+    MCNeighbor &mcn = SystemMC::getSystem()->mcNeighbor;
+
+    mcn.txData = 0;
+    mcn.txSides = 0;
 }
 
 void MCNeighbor::deadlineWork()
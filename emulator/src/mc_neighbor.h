@@ -35,6 +35,8 @@
  * thread, and we run the hardware simulation on the cube thread, as we need to run our
  * transmit process in lockstep with the cube clock. As such, in a lot of ways this file
  * actually acts much more like it's part of the cube hardware model than the MC.
+ *
+ * Each System owns one MCNeighbor, alongside its cubes.
  */
 
 #include "macros.h"
@@ -44,18 +46,20 @@
 class MCNeighbor {
 public:
 
-    static void updateNeighbor(bool touching, unsigned mcSide, unsigned cube, unsigned cubeSide);
+    MCNeighbor() : txRegister(0), nbrSides(0), txSides(0), txData(0) {}
+
+    void updateNeighbor(bool touching, unsigned mcSide, unsigned cube, unsigned cubeSide);
 
-    static void cubeInit(const VirtualTime *vtime) {
+    void cubeInit(const VirtualTime *vtime) {
         deadline.init(vtime);
     }
 
-    static ALWAYS_INLINE void cubeTick() {
+    ALWAYS_INLINE void cubeTick() {
         if (deadline.hasPassed())
             deadlineWork();
     }
 
-    static ALWAYS_INLINE uint64_t cubeDeadlineRemaining() {
+    ALWAYS_INLINE uint64_t cubeDeadlineRemaining() {
         return deadline.remaining();
     }
 
@@ -70,19 +74,19 @@ private:
         unsigned side;
     };
 
-    static CubeInfo cubes[NUM_SIDES];
+    CubeInfo cubes[NUM_SIDES];
 
     // Cube thread, virtual time tracking
-    static TickDeadline deadline;
-    static uint32_t txRegister;
+    TickDeadline deadline;
+    uint32_t txRegister;
 
     // Atomic words
-    static uint32_t nbrSides;
-    static uint32_t txSides;
-    static uint32_t txData;
+    uint32_t nbrSides;
+    uint32_t txSides;
+    uint32_t txData;
 
-    static void deadlineWork();
-    static void transmitPulse(const CubeInfo &dest);
+    void deadlineWork();
+    void transmitPulse(const CubeInfo &dest);
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "mc_timing.h"
 #include "bits.h"
 #include "noise.h"
+#include "input_replay.h"
 
 namespace RadioMC {
 
@@ -255,6 +256,8 @@ void SystemMC::doRadioPacket()
 
     sys->getCubeSync().beginEventAt(radioPacketDeadline, mThreadRunning);
 
+    bool replayFinished = InputReplay::isPlaying() && InputReplay::play(radioPacketDeadline);
+
     if (RadioManager::isRadioEnabled()) {
         bool dropped = sys->opt_radioNoise &&
             RadioMC::testPacketLoss(buf.packet.len, buf.ptx.dest->channel);
@@ -269,6 +272,9 @@ void SystemMC::doRadioPacket()
     radioPacketDeadline += MCTiming::TICKS_PER_PACKET;
     sys->getCubeSync().endEvent(radioPacketDeadline);
 
+    if (replayFinished)
+        SystemMC::exit(0);
+
     if (RadioManager::isRadioEnabled()) {
 
         --buf.triesRemaining;
@@ -32,6 +32,7 @@
 #include "system.h"
 #include "system_mc.h"
 #include "svmmemory.h"
+#include "svmdebugger.h"
 
 #include <string.h>
 
@@ -289,6 +290,36 @@ static void emulateFault(FaultCode code)
 }
 
 
+static bool emulateWatchpoint(reg_t addr, unsigned bytes,
+    Debugger::WatchTypes type, unsigned instrBytes)
+{
+    /*
+     * Slow path for loads and stores, only taken while the debugger has a
+     * data watchpoint armed. If this access is watched, back the PC up to
+     * the instruction that made it, and stop there without performing it.
+     * Returns 'true' if the caller should abort the instruction.
+     */
+
+    reg_t pc = regs[REG_PC] - instrBytes;
+    if (!SvmDebugger::isWatched(pc, addr, bytes, type))
+        return false;
+
+    emulateEnterException(pc);
+    saveUserRegs();
+
+    SvmDebugger::watchpoint();
+
+    restoreUserRegs();
+    emulateExitException();
+    return true;
+}
+
+#define WATCH(addr, bytes, type, instrBytes) \
+    if (UNLIKELY(SvmDebugger::watchpointsArmed()) && \
+        emulateWatchpoint(addr, bytes, Debugger::type, instrBytes)) \
+        return;
+
+
 /***************************************************************************
  * Instruction Emulation
  ***************************************************************************/
@@ -643,6 +674,7 @@ static void emulateSTRSPImm(uint16_t instr)
         return emulateFault(F_STORE_ADDRESS);
     if (!SvmMemory::isAddrAligned(addr, 4))
         return emulateFault(F_STORE_ALIGNMENT);
+    WATCH(addr, 4, W_WRITE, 2);
 
     *reinterpret_cast<uint32_t*>(addr) = SvmMemory::squashPhysicalAddr(regs[Rt]);
 
@@ -660,6 +692,7 @@ static void emulateLDRSPImm(uint16_t instr)
         return emulateFault(F_LOAD_ADDRESS);
     if (!SvmMemory::isAddrAligned(addr, 4))
         return emulateFault(F_LOAD_ALIGNMENT);
+    WATCH(addr, 4, W_READ, 2);
 
     regs[Rt] = *reinterpret_cast<uint32_t*>(addr);
 
@@ -732,6 +765,7 @@ static void emulateSTR(uint32_t instr)
         return emulateFault(F_STORE_ADDRESS);
     if (!SvmMemory::isAddrAligned(addr, 4))
         return emulateFault(F_STORE_ALIGNMENT);
+    WATCH(addr, 4, W_WRITE, 4);
 
     *reinterpret_cast<uint32_t*>(addr) = SvmMemory::squashPhysicalAddr(regs[Rt]);
 
@@ -749,6 +783,7 @@ static void emulateLDR(uint32_t instr)
         return emulateFault(F_LOAD_ADDRESS);
     if (!SvmMemory::isAddrAligned(addr, 4))
         return emulateFault(F_LOAD_ALIGNMENT);
+    WATCH(addr, 4, W_READ, 4);
 
     regs[Rt] = *reinterpret_cast<uint32_t*>(addr);
 
@@ -770,8 +805,10 @@ static void emulateSTRBH(uint32_t instr)
     if (instr & HalfwordBit) {
         if (!SvmMemory::isAddrAligned(addr, 2))
             return emulateFault(F_STORE_ALIGNMENT);
+        WATCH(addr, 2, W_WRITE, 4);
         *reinterpret_cast<uint16_t*>(addr) = regs[Rt];
     } else {
+        WATCH(addr, 1, W_WRITE, 4);
         *reinterpret_cast<uint8_t*>(addr) = regs[Rt];
     }
 
@@ -790,22 +827,25 @@ static void emulateLDRBH(uint32_t instr)
 
     if (!SvmMemory::isAddrValid(addr))
         return emulateFault(F_LOAD_ADDRESS);
+    if (instr & HalfwordBit) {
+        if (!SvmMemory::isAddrAligned(addr, 2))
+            return emulateFault(F_LOAD_ALIGNMENT);
+        WATCH(addr, 2, W_READ, 4);
+    } else {
+        WATCH(addr, 1, W_READ, 4);
+    }
 
     switch (instr & (HalfwordBit | SignExtBit)) {
     case 0:
         regs[Rt] = *reinterpret_cast<uint8_t*>(addr);
         break;
     case HalfwordBit:
-        if (!SvmMemory::isAddrAligned(addr, 2))
-            return emulateFault(F_LOAD_ALIGNMENT);
         regs[Rt] = *reinterpret_cast<uint16_t*>(addr);
         break;
     case SignExtBit:
         regs[Rt] = (uint32_t)signExtend(*reinterpret_cast<uint8_t*>(addr), 8);
         break;
     case HalfwordBit | SignExtBit:
-        if (!SvmMemory::isAddrAligned(addr, 2))
-            return emulateFault(F_LOAD_ALIGNMENT);
         regs[Rt] = (uint32_t)signExtend(*reinterpret_cast<uint16_t*>(addr), 16);
         break;
     }
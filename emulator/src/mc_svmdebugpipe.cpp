@@ -25,6 +25,7 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
 #include "lua_script.h"
 #include "svm.h"
 #include "svmdebugpipe.h"
@@ -41,6 +42,7 @@ using namespace Svm;
 
 static ELFDebugInfo gELFDebugInfo;
 static LogDecoder gLogDecoder;
+static DeferredLogDecoder *gDeferredLog;
 static LuaScript *gLuaScript;
 
 
@@ -68,6 +70,9 @@ bool SvmDebugPipe::fault(FaultCode code)
      * Nope. Pass it through, but log it along the way.
      */
 
+    if (gDeferredLog)
+        gDeferredLog->flush();
+
     uint32_t pcVA = SvmRuntime::reconstructCodeAddr(SvmCpu::reg(REG_PC));
     std::string pcName = formatAddress(pcVA);
 
@@ -138,8 +143,17 @@ void SvmDebugPipe::logCommit(SvmLogTag tag, uint32_t *buffer, uint32_t bytes)
     // In simulation, we can decode right away. Note that we use the raw Flash
     // interface instead of going through the cache, since we don't want
     // debug log decoding to affect caching behavior.
+    //
+    // With --deferred-logs, most records are formatted on another thread.
+    // Anything it refuses is decoded here, after everything before it.
+
+    if (gDeferredLog) {
+        if (gDeferredLog->commit(gLogDecoder, gELFDebugInfo, tag, buffer, bytes))
+            return;
+        gDeferredLog->flush();
+    }
 
-    uint32_t decodedSize = gLogDecoder.decode(gELFDebugInfo, tag, buffer);
+    uint32_t decodedSize = gLogDecoder.decode(&gELFDebugInfo, tag, buffer);
     ASSERT(decodedSize == bytes);
 }
 
@@ -236,11 +250,41 @@ static uint32_t debuggerMsgCallback(const uint32_t *cmd,
     return replyWords;
 }
 
+static bool debuggerMemoryCallback(uint32_t addr, uint8_t *buffer, uint32_t bytes)
+{
+    /*
+     * Called by the GDBServer thread to read a large span of RAM while
+     * the target is stopped, without a message round-trip per reply.
+     * Holding the mailbox lock keeps us from racing with a debugger
+     * message, such as a RAM write, that the SVM thread is handling.
+     *
+     * We use debugMapRAM() rather than mapRAM(), since the latter updates
+     * syscall statistics that belong to the SVM thread.
+     */
+
+    DebuggerMailbox &mbox = gDebuggerMailbox;
+    tthread::lock_guard<tthread::mutex> guard(mbox.m);
+
+    SvmMemory::PhysAddr pa;
+    if (!SvmMemory::debugMapRAM(SvmMemory::VirtAddr(addr), bytes, pa))
+        return false;
+
+    memcpy(buffer, pa, bytes);
+    return true;
+}
+
 void SvmDebugPipe::setSymbolSource(const Elf::Program &program)
 {
     gELFDebugInfo.init(program);
     GDBServer::setDebugInfo(&gELFDebugInfo);
     GDBServer::setMessageCallback(debuggerMsgCallback);
+    GDBServer::setMemoryCallback(debuggerMemoryCallback);
+}
+
+static void flushDeferredLog()
+{
+    // Don't lose queued log output when Siftulator exits
+    gDeferredLog->flush();
 }
 
 static void luaHandler(const char *str, void*)
@@ -258,4 +302,13 @@ void SvmDebugPipe::init()
     LogDecoder::ScriptHandler lua = { luaHandler };
     gLogDecoder.init();
     gLogDecoder.setScriptHandler(_SYS_SCRIPT_LUA, lua);
+
+    // Never deleted, since its thread may outlive any static destructors
+    if (SystemMC::getSystem()->opt_deferredLogs && !gDeferredLog) {
+        gDeferredLog = new DeferredLogDecoder();
+        gDeferredLog->start();
+        atexit(flushDeferredLog);
+    }
+    if (gDeferredLog)
+        gDeferredLog->reset();
 }
@@ -29,6 +29,7 @@
 #include "svmmemory.h"
 #include "system.h"
 #include "system_mc.h"
+#include "mc_syscallstats.h"
 
 using namespace Svm;
 
@@ -48,3 +49,17 @@ void SvmRuntime::onStackModification(SvmMemory::PhysAddr sp)
              reinterpret_cast<void*>(stackLowWaterMark), int(topOfStackPA - stackLowWaterMark)));
     }
 }
+
+/*
+ * If enabled, count the cost of each syscall. See SyscallStats.
+ */
+void SvmRuntime::onSyscallEnter(unsigned num)
+{
+    if (SystemMC::getSystem()->opt_svmSyscallStats)
+        SyscallStats::enter(num);
+}
+
+void SvmRuntime::onSyscallExit(unsigned num)
+{
+    SyscallStats::exit(num);
+}
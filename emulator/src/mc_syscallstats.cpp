@@ -0,0 +1,182 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "mc_syscallstats.h"
+#include "system_mc.h"
+#include "svmruntime.h"
+#include "svmmemory.h"
+#include "mc_timing.h"
+#include "macros.h"
+
+SyscallStats::Counters SyscallStats::total[MAX_SYSCALLS];
+SyscallStats::Counters SyscallStats::periodic[MAX_SYSCALLS];
+SysTime::Ticks SyscallStats::timestamp;
+bool SyscallStats::active;
+uint64_t SyscallStats::enterTicks;
+uint64_t SyscallStats::enterBusyTicks;
+uint64_t SyscallStats::enterBytes;
+
+
+void SyscallStats::enter(unsigned num)
+{
+    active = true;
+    enterTicks = SystemMC::getTicks();
+    enterBusyTicks = SystemMC::getBusyTicks();
+    enterBytes = SvmMemory::bytesAccessed;
+}
+
+void SyscallStats::exit(unsigned num)
+{
+    /*
+     * Syscalls are never nested, but stats may have been switched on
+     * in the middle of one. Only count syscalls we saw the start of.
+     */
+
+    if (!active || num >= MAX_SYSCALLS)
+        return;
+    active = false;
+
+    /*
+     * The SVC instruction's own cost is elapsed by SvmCpu only after the
+     * handler returns, and work done natively inside a handler (like the
+     * soft-float syscalls) doesn't advance virtual time at all. Charge
+     * that fixed overhead here, so cheap but frequent syscalls still add
+     * up to a visible share of the frame.
+     */
+
+    uint64_t ticks = SystemMC::getTicks() - enterTicks + MCTiming::TICKS_PER_SVC;
+    uint64_t busyTicks = SystemMC::getBusyTicks() - enterBusyTicks + MCTiming::TICKS_PER_SVC;
+    uint64_t bytes = SvmMemory::bytesAccessed - enterBytes;
+
+    add(total[num], ticks, busyTicks, bytes);
+    add(periodic[num], ticks, busyTicks, bytes);
+
+    dumpStats();
+}
+
+void SyscallStats::add(Counters &c, uint64_t ticks, uint64_t busyTicks, uint64_t bytes)
+{
+    unsigned bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && (ticks >> bucket))
+        bucket++;
+
+    c.calls++;
+    c.ticks += ticks;
+    c.busyTicks += busyTicks;
+    c.bytes += bytes;
+    c.histogram[bucket]++;
+}
+
+void SyscallStats::reset()
+{
+    memset(total, 0, sizeof total);
+}
+
+bool SyscallStats::costSort(unsigned i, unsigned j)
+{
+    // Most busy time first; break ties (like the fixed-cost syscalls) by count
+    if (periodic[j].busyTicks != periodic[i].busyTicks)
+        return periodic[j].busyTicks < periodic[i].busyTicks;
+    return periodic[j].calls < periodic[i].calls;
+}
+
+unsigned SyscallStats::percentile(const Counters &c, unsigned pct)
+{
+    // Upper bound, in ticks, for the given percentage of calls
+
+    uint64_t threshold = (c.calls * pct + 99) / 100;
+    uint64_t count = 0;
+
+    for (unsigned i = 0; i < NUM_BUCKETS; ++i) {
+        count += c.histogram[i];
+        if (count >= threshold)
+            return 1 << i;
+    }
+    return 1 << NUM_BUCKETS;
+}
+
+void SyscallStats::dumpStats()
+{
+    const SysTime::Ticks interval = SysTime::sTicks(1);
+    const unsigned numHotSyscalls = 10;
+
+    SysTime::Ticks now = SysTime::ticks();
+    SysTime::Ticks tickDiff = now - timestamp;
+    if (tickDiff < interval)
+        return;
+
+    double dt = tickDiff / (double) SysTime::sTicks(1);
+    double mcTicks = dt * MCTiming::TICK_HZ;
+
+    /*
+     * Overall totals
+     */
+
+    uint64_t calls = 0, ticks = 0, busyTicks = 0;
+    for (unsigned i = 0; i < MAX_SYSCALLS; ++i) {
+        calls += periodic[i].calls;
+        ticks += periodic[i].ticks;
+        busyTicks += periodic[i].busyTicks;
+    }
+
+    LOG(("\nSYSCALL: %9.1f calls/s, %6.2f%% of time in syscalls, %6.2f%% busy\n",
+        calls / dt, ticks / mcTicks * 100.0, busyTicks / mcTicks * 100.0));
+
+    /*
+     * The N syscalls with the most busy time
+     */
+
+    std::vector<unsigned> hot(MAX_SYSCALLS);
+    for (unsigned i = 0; i < hot.size(); ++i)
+        hot[i] = i;
+
+    std::partial_sort(hot.begin(), hot.begin() + numHotSyscalls,
+                      hot.end(), costSort);
+
+    for (unsigned i = 0; i < numHotSyscalls; ++i) {
+        const Counters &c = periodic[hot[i]];
+        const char *name = SvmRuntime::getSyscallName(hot[i]);
+
+        if (c.calls == 0)
+            break;
+
+        LOG(("SYSCALL: [%6.2f%% busy] %9.1f calls/s, %7.1f ticks/call, "
+            "p50 <%6u p99 <%6u, %9.1f bytes/s  %s\n",
+            c.busyTicks / mcTicks * 100.0, c.calls / dt,
+            c.ticks / double(c.calls), percentile(c, 50), percentile(c, 99),
+            c.bytes / dt, name ? name : "(unknown)"));
+    }
+
+    /*
+     * Next stats interval...
+     */
+
+    memset(periodic, 0, sizeof periodic);
+    timestamp = now;
+}
@@ -0,0 +1,90 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Per-syscall cost accounting, for finding out which syscalls dominate
+ * a game's frame time. Enabled with --svm-syscall-stats.
+ *
+ * Cost is measured in virtual time, as the number of MC ticks that
+ * elapse during each call. We count both the total time, and the
+ * 'busy' time which excludes waiting for interrupts; a syscall like
+ * _SYS_paint() spends most of its time blocked, not working.
+ *
+ * Native work inside a syscall isn't modelled in virtual time, so each
+ * call is also charged the fixed SVC overhead from MCTiming. Syscalls
+ * that only compute, like floating point math, cost exactly that.
+ */
+
+#ifndef _MC_SYSCALLSTATS_H
+#define _MC_SYSCALLSTATS_H
+
+#include <stdint.h>
+#include "systime.h"
+
+
+class SyscallStats {
+public:
+    static const unsigned MAX_SYSCALLS = 256;
+
+    // Histogram bucket N counts calls that took less than 2^N ticks
+    static const unsigned NUM_BUCKETS = 24;
+
+    struct Counters {
+        uint64_t calls;
+        uint64_t ticks;
+        uint64_t busyTicks;
+        uint64_t bytes;         // User memory mapped or copied
+        uint32_t histogram[NUM_BUCKETS];
+    };
+
+    static void enter(unsigned num);
+    static void exit(unsigned num);
+
+    /// Reset the cumulative counters. Doesn't affect the periodic report.
+    static void reset();
+
+    /// Cumulative counters for one syscall, or NULL if out of range.
+    static const Counters *get(unsigned num) {
+        return num < MAX_SYSCALLS ? &total[num] : 0;
+    }
+
+private:
+    static Counters total[MAX_SYSCALLS];
+    static Counters periodic[MAX_SYSCALLS];
+    static SysTime::Ticks timestamp;
+
+    static bool active;
+    static uint64_t enterTicks;
+    static uint64_t enterBusyTicks;
+    static uint64_t enterBytes;
+
+    static void add(Counters &c, uint64_t ticks, uint64_t busyTicks, uint64_t bytes);
+    static void dumpStats();
+    static bool costSort(unsigned i, unsigned j);
+    static unsigned percentile(const Counters &c, unsigned pct);
+};
+
+#endif
@@ -59,6 +59,23 @@ struct MCTiming {
     static const unsigned TICKS_PER_PAGE_WRITE = 51200;     // min 1.4ms, max 5ms. go with ~3.2ms in the middle
     static const unsigned TICKS_PER_BLOCK_ERASE = 21600000; // min 0.7s, max 2s.   go with ~1.35s in the middle
 
+    // Datasheet limits for the same, used by the optional flash timing model
+    static const unsigned TICKS_PER_PAGE_WRITE_MIN = 22400;
+    static const unsigned TICKS_PER_PAGE_WRITE_MAX = 80000;
+    static const unsigned TICKS_PER_BLOCK_ERASE_MIN = 11200000;
+    static const unsigned TICKS_PER_BLOCK_ERASE_MAX = 32000000;
+
+    // Erase suspend latency (20us max), and an arbitrary 100us of lost erase
+    // progress each time a suspended erase is resumed.
+    static const unsigned TICKS_PER_ERASE_SUSPEND = 320;
+    static const unsigned TICKS_PER_ERASE_RESUME = 1600;
+
+    // XXX: Arbitrary time for one poll of the flash status register
+    static const unsigned TICKS_PER_FLASH_STATUS = 160;
+
+    // How often we move packets through the simulated USB and Bluetooth links (100us)
+    static const unsigned TICKS_PER_PIPE_POLL = 1600;
+
     // Delay long enough for cubes to establish a HWID, for auto-pairing.
     static const unsigned STARTUP_DELAY = 200000;
 
@@ -0,0 +1,105 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo Thundercracker simulator
+ * Micah Elizabeth Scott <micah@misc.name>
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "usbprotocol.h"
+#include "event.h"
+#include "system_mc.h"
+#include "mc_datapipe.h"
+#include "tasks.h"
+
+/*
+ * Siftulator's USB device. When the USB data pipe is bridged to a socket
+ * (--usb-pipe), a connected socket client acts as a host with the Base
+ * plugged in. Packets on the socket are whole USBProtocol messages, the
+ * same bytes that cross the bulk endpoints on hardware.
+ */
+
+DataPipe SimUSB::pipe("USB", USBProtocolMsg::MAX_LEN);
+bool SimUSB::inPending;
+
+bool SimUSB::isConnected()
+{
+    return pipe.isConnected();
+}
+
+bool SimUSB::isReadyToSend()
+{
+    if (pipe.isReadyToSend(SystemMC::getTicks()))
+        return true;
+
+    // Try again from Tasks::UsbIN once the link is idle
+    inPending = true;
+    return false;
+}
+
+void SimUSB::write(const uint8_t *bytes, unsigned length)
+{
+    pipe.send(SystemMC::getTicks(), bytes, length);
+    inPending = true;
+}
+
+void SimUSB::poll(uint64_t ticks)
+{
+    /*
+     * This runs as simulated time elapses, which may be in the middle of
+     * a flash operation or a syscall. Like the USB ISR on hardware, we
+     * only note what happened and leave the real work to our tasks.
+     */
+
+    if (!pipe.isEnabled())
+        return;
+
+    if (pipe.connectionChanged()) {
+        Event::setBasePending(pipe.isConnected()
+            ? Event::PID_BASE_USB_CONNECT
+            : Event::PID_BASE_USB_DISCONNECT);
+    }
+
+    if (pipe.needsService(ticks))
+        Tasks::trigger(Tasks::UsbOUT);
+
+    // Keep the IN pipe busy for as long as userspace has packets queued
+    if (inPending && pipe.isReadyToSend(ticks)) {
+        inPending = false;
+        Tasks::trigger(Tasks::UsbIN);
+    }
+
+    pipe.flush(ticks);
+}
+
+void SimUSB::handleOUTData()
+{
+    DataPipe::Packet packet;
+    while (pipe.receive(SystemMC::getTicks(), packet)) {
+        if (packet.length < USBProtocolMsg::HEADER_BYTES)
+            continue;
+
+        USBProtocolMsg m;
+        m.len = packet.length;
+        memcpy(m.bytes, packet.bytes, packet.length);
+        USBProtocol::dispatch(m);
+    }
+}
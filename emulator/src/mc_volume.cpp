@@ -38,28 +38,32 @@ namespace Volume {
  */
 static const int kDefault = MAX_VOLUME >> MIXER_GAIN_LOG2;
 
-static int currentVolume = 0;
-static int unmuteVolume = 0;
-
 void init()
 {
-    currentVolume = SystemMC::getSystem()->opt_mute ? 0 : kDefault;
-    unmuteVolume = kDefault;
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+    p.volume = SystemMC::getSystem()->opt_mute ? 0 : kDefault;
+    p.unmuteVolume = kDefault;
 }
 
 int systemVolume()
 {
+    int currentVolume = SystemMC::getPeripherals().volume;
     ASSERT(currentVolume >= 0 && currentVolume <= MAX_VOLUME);
     return currentVolume;
 }
 
 void setSystemVolume(int v)
 {
-	unmuteVolume = currentVolume = clamp(v, 0, MAX_VOLUME);
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+	p.unmuteVolume = p.volume = clamp(v, 0, MAX_VOLUME);
 }
 
 void toggleMute()
 {
+    SystemMC::Peripherals &p = SystemMC::getPeripherals();
+    int &currentVolume = p.volume;
+    int &unmuteVolume = p.unmuteVolume;
+
 	if (currentVolume) {
 		unmuteVolume = currentVolume;
 		currentVolume = 0;
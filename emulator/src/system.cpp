@@ -29,6 +29,8 @@
 #include "system.h"
 #include "cube_debug.h"
 #include "mc_gdbserver.h"
+#include "mc_datapipe.h"
+#include "input_replay.h"
 
 
 System::System()
@@ -42,15 +44,24 @@ System::System()
         opt_lockRotationByDefault(false),
         opt_noCubeReconnect(false),
         opt_flushLogs(false),
+        opt_deferredLogs(false),
         opt_paintTrace(false),
         opt_svmTrace(false),
         opt_svmFlashStats(false),
+        opt_svmSyscallStats(false),
         opt_gdbServerPort(0),
+        opt_btPipePort(0),
+        opt_btPipeBandwidth(2500),
+        opt_btPipeLatency(15000),
+        opt_usbPipePort(0),
+        opt_usbPipeBandwidth(1000000),
+        opt_usbPipeLatency(1000),
         opt_cube0Debug(false),
         opt_mute(false),
         opt_radioNoise(0),
         mIsInitialized(false),
-        mIsStarted(false)
+        mIsStarted(false),
+        smc(this)
         {}
 
 
@@ -62,10 +73,14 @@ bool System::init()
     if (!flash.init(opt_flashFilename.empty() ? NULL : opt_flashFilename.c_str()))
         return false;
 
+    // May change opt_numCubes, so this must come before SystemCubes
+    if (!InputReplay::init(this))
+        return false;
+
     if (!sc.init(this))
         return false;
 
-    if (!smc.init(this))
+    if (!smc.init())
         return false;
 
     time.init();
@@ -121,6 +136,10 @@ void System::start()
 
     if (opt_gdbServerPort)
         GDBServer::start(opt_gdbServerPort);
+    if (opt_btPipePort)
+        SimBluetooth::pipe.start(opt_btPipePort, opt_btPipeBandwidth, opt_btPipeLatency);
+    if (opt_usbPipePort)
+        SimUSB::pipe.start(opt_usbPipePort, opt_usbPipeBandwidth, opt_usbPipeLatency);
 }
 
 void System::exit()
@@ -132,6 +151,10 @@ void System::exit()
     if (mIsStarted) {
         if (opt_gdbServerPort)
             GDBServer::stop();
+        if (opt_btPipePort)
+            SimBluetooth::pipe.stop();
+        if (opt_usbPipePort)
+            SimUSB::pipe.stop();
 
         smc.stop();
         sc.stop();
@@ -143,4 +166,5 @@ void System::exit()
     sc.exit();
     flash.exit();
     tracer.close();
+    InputReplay::exit();
 }
@@ -27,6 +27,10 @@
 /*
  * The whole system- all the hardware we're simulating.
  * This module brings it all together.
+ *
+ * Simulator-only state belongs to a System instance, rather than to the
+ * process. Firmware code, which has no System to pass around, reaches
+ * the current one via SystemMC::getSystem().
  */
 
 #ifndef _SYSTEM_H
@@ -42,6 +46,8 @@
 #include "tracer.h"
 #include "tinythread.h"
 #include "flash_storage.h"
+#include "audio_digest.h"
+#include "mc_neighbor.h"
 
 
 class System {
@@ -55,6 +61,8 @@ class System {
     Cube::Hardware cubes[MAX_CUBES];
     Tracer tracer;
     FlashStorage flash;
+    AudioDigest audioDigest;
+    MCNeighbor mcNeighbor;
 
     // Static Options; can be set prior to init only
     bool opt_headless;
@@ -63,6 +71,9 @@ class System {
     std::string opt_flashFilename;
     std::string opt_launcherFilename;
     std::string opt_waveoutFilename;
+    std::string opt_recordFilename;
+    std::string opt_replayFilename;
+    std::string opt_frameHashFilename;
 
     // UI options
     bool opt_whiteBackground;
@@ -77,6 +88,7 @@ class System {
     bool opt_traceEnabledAtStartup;
     bool opt_noCubeReconnect;
     bool opt_flushLogs;
+    bool opt_deferredLogs;
 
     // Master firmware debug options
     bool opt_paintTrace;
@@ -84,9 +96,18 @@ class System {
     // SVM options
     bool opt_svmTrace;
     bool opt_svmFlashStats;
+    bool opt_svmSyscallStats;
     bool opt_svmStackMonitor;
     unsigned opt_gdbServerPort;
 
+    // Simulated data links, bridged to local sockets
+    unsigned opt_btPipePort;
+    unsigned opt_btPipeBandwidth;
+    unsigned opt_btPipeLatency;
+    unsigned opt_usbPipePort;
+    unsigned opt_usbPipeBandwidth;
+    unsigned opt_usbPipeLatency;
+
     // Debug options, applicable to cube 0 only
     bool opt_cube0Debug;
     std::string opt_cube0Profile;
@@ -95,6 +116,8 @@ class System {
     bool opt_mute;
     double opt_radioNoise;
 
+    System();
+
     bool init();
     void start();
     void exit();
@@ -117,22 +140,11 @@ class System {
     }
 
  private:
-    System();
-    
     bool mIsInitialized;
     bool mIsStarted;
 
     SystemCubes sc;
     SystemMC smc;
-
-public:
-
-    inline static System& getInstance() {
-        static System sys;
-        return sys;
-    }
-
-
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "ostime.h"
 #include "system_cubes.h"
 #include "mc_neighbor.h"
+#include "input_replay.h"
 
 
 bool SystemCubes::init(System *sys)
@@ -36,7 +37,7 @@ bool SystemCubes::init(System *sys)
     this->sys = sys;
     deadlineSync.init(&sys->time, &mThreadRunning);
 
-    MCNeighbor::cubeInit(&sys->time);
+    sys->mcNeighbor.cubeInit(&sys->time);
 
     if (sys->opt_cubeFirmware.empty() && (!sys->opt_cube0Profile.empty() || 
                                            sys->opt_cube0Debug)) {
@@ -189,8 +190,8 @@ void SystemCubes::threadFn(void *param)
     if (sys->opt_cube0Debug && sys->opt_numCubes)
         Cube::Debug::attach(&sys->cubes[0]);
 
-    // Seed PRNG per-thread
-    srand(OSTime::clock() * 1e6);
+    // Seed PRNG per-thread. Input playback must be repeatable, so it gets a fixed seed.
+    srand(InputReplay::isPlaying() ? 1 : OSTime::clock() * 1e6);
 
     while (self->mThreadRunning) {
         /*
@@ -228,7 +229,7 @@ void SystemCubes::threadFn(void *param)
 ALWAYS_INLINE void SystemCubes::tick(unsigned count)
 {
     sys->time.tick(count);
-    MCNeighbor::cubeTick();
+    sys->mcNeighbor.cubeTick();
     deadlineSync.tick();
 }
 
@@ -306,6 +307,7 @@ NEVER_INLINE void SystemCubes::tickLoopFastSBT()
 
     while (batch && stepSize) {
         unsigned nextStep;
+        bool idle = false;
 
         batch -= stepSize;
         nextStep = batch;
@@ -313,12 +315,24 @@ NEVER_INLINE void SystemCubes::tickLoopFastSBT()
         for (unsigned i = 0; i < nCubes; i++) {
             Cube::Hardware &cube = sys->cubes[i];
             nextStep = std::min(nextStep, sys->cubes[i].tickFastSBT(stepSize));
+            idle |= cube.cpu.idleCycles != 0;
         }
 
         tick(stepSize);
 
         stepSize = std::min(nextStep, (unsigned)deadlineSync.remaining());
-        stepSize = std::min(stepSize, (unsigned)MCNeighbor::cubeDeadlineRemaining());
+        stepSize = std::min(stepSize, (unsigned)sys->mcNeighbor.cubeDeadlineRemaining());
+
+        /*
+         * Cubes in an idle loop asked to skip past their next instruction.
+         * That's only safe if nothing poked them after they were ticked:
+         * later cubes may have sent neighbor pulses, and tick() may have run
+         * the master, which delivers radio packets.
+         */
+
+        if (idle)
+            for (unsigned i = 0; i < nCubes; i++)
+                stepSize = std::min(stepSize, sys->cubes[i].idleStepLimit());
     }
 }
 
@@ -340,6 +354,6 @@ NEVER_INLINE void SystemCubes::tickLoopEmpty()
         tick(stepSize);
 
         stepSize = std::min(nextStep, (unsigned)deadlineSync.remaining());
-        stepSize = std::min(stepSize, (unsigned)MCNeighbor::cubeDeadlineRemaining());
+        stepSize = std::min(stepSize, (unsigned)sys->mcNeighbor.cubeDeadlineRemaining());
     }
 }
@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <setjmp.h>
 #include <errno.h>
+#include <string.h>
 
 #include "system.h"
 #include "system_mc.h"
@@ -49,6 +50,7 @@
 #include "protocol.h"
 #include "tasks.h"
 #include "mc_timing.h"
+#include "mc_datapipe.h"
 #include "lodepng.h"
 #include "sysinfo.h"
 #include "crc.h"
@@ -59,14 +61,22 @@
 #include "led.h"
 
 SystemMC *SystemMC::instance;
-std::vector< std::vector<uint8_t> > SystemMC::pendingGameInstalls;
-tthread::mutex SystemMC::pendingGameInstallLock;
 
 
-bool SystemMC::init(System *sys)
+SystemMC::SystemMC(System *sys)
+    : sys(sys), audioSampleCount(0), mThread(0), mThreadRunning(false)
 {
-    this->sys = sys;
+    /*
+     * There's only one simulated MC at a time, for now. Firmware code
+     * reaches it, and the System that owns it, through this pointer.
+     */
     instance = this;
+    memset(&peripherals, 0, sizeof peripherals);
+}
+
+bool SystemMC::init()
+{
+    audioSampleCount = 0;
 
     if (!sys->opt_waveoutFilename.empty() &&
         !waveOut.open(sys->opt_waveoutFilename.c_str(), AudioMixer::SAMPLE_HZ)) {
@@ -191,8 +201,10 @@ void SystemMC::threadFn(void *param)
      
     // Start the master at some point shortly after the cubes come up
     instance->ticks = instance->sys->time.clocks + MCTiming::STARTUP_DELAY;
+    instance->idleTicks = instance->ticks;
     instance->radioPacketDeadline = instance->ticks + MCTiming::TICKS_PER_PACKET;
     instance->heartbeatDeadline = instance->ticks;
+    instance->dataPipeDeadline = instance->ticks;
 
     instance->sys->getCubeSync().beginEventAt(instance->ticks, instance->mThreadRunning);
     instance->sys->getCubeSync().endEvent(instance->radioPacketDeadline);
@@ -245,6 +257,8 @@ void Tasks::waitForInterrupt()
     // important to run all async events (including exit) from halt().
 
     SystemMC *self = SystemMC::instance;
+    if (self->radioPacketDeadline > self->ticks)
+        self->idleTicks += self->radioPacketDeadline - self->ticks;
     self->ticks = self->radioPacketDeadline;
     self->elapseTicks(0);
 }
@@ -257,18 +271,19 @@ Cube::Hardware *SystemMC::getCubeForSlot(CubeSlot *slot)
 bool SystemMC::installGame(const char *path)
 {
     bool success = true;
-    bool restartThread = instance && instance->mThreadRunning;
+    bool restartThread = instance->mThreadRunning;
 
     if (restartThread)
         instance->stop();
 
-    tthread::lock_guard<tthread::mutex> guard(pendingGameInstallLock);
+    tthread::lock_guard<tthread::mutex> guard(instance->pendingGameInstallLock);
+    std::vector< std::vector<uint8_t> > &pending = instance->pendingGameInstalls;
 
-    pendingGameInstalls.push_back(std::vector<uint8_t>());
-    LodePNG::loadFile(pendingGameInstalls.back(), path);
+    pending.push_back(std::vector<uint8_t>());
+    LodePNG::loadFile(pending.back(), path);
     
-    if (pendingGameInstalls.back().empty()) {
-        pendingGameInstalls.pop_back();
+    if (pending.back().empty()) {
+        pending.pop_back();
         success = false;
         LOG(("FLASH: Error, couldn't open ELF file '%s' (%s)\n",
             path, strerror(errno)));
@@ -299,20 +314,43 @@ void SystemMC::elapseTicks(unsigned n)
         Tasks::heartbeatISR();
         self->heartbeatDeadline += MCTiming::TICK_HZ / Tasks::HEARTBEAT_HZ;
     }
+
+    // USB and Bluetooth links, bridged to local sockets. These only
+    // wake up tasks; packets are handled later, from Tasks::work().
+    if (self->ticks >= self->dataPipeDeadline) {
+        self->dataPipeDeadline = self->ticks + MCTiming::TICKS_PER_PIPE_POLL;
+        SimBluetooth::poll(self->ticks);
+        SimUSB::poll(self->ticks);
+    }
+}
+
+void SystemMC::logAudioSamples(const int16_t *samples, unsigned count)
+{
+    instance->audioSampleCount += count;
+    instance->waveOut.write(samples, count);
+    instance->sys->audioDigest.write(samples, count);
 }
 
 unsigned SystemMC::suggestAudioSamplesToMix()
 {
     /*
      * SysTime-based clock for audio logging in --headless mode.
+     *
+     * If nothing is logging the audio, don't mix it at all. Keep the
+     * clock current though, so that a digest started later on begins
+     * with the audio from that point rather than a burst of backlog.
      */
 
-    if (instance->waveOut.isOpen()) {
-        unsigned currentSample = SysTime::ticks() / SysTime::hzTicks(AudioMixer::SAMPLE_HZ);
-        unsigned prevSamples = instance->waveOut.getSampleCount();
-        if (currentSample > prevSamples)
-            return currentSample - prevSamples;
+    unsigned currentSample = SysTime::ticks() / SysTime::hzTicks(AudioMixer::SAMPLE_HZ);
+
+    if (!instance->waveOut.isOpen() && !instance->sys->audioDigest.isEnabled()) {
+        instance->audioSampleCount = currentSample;
+        return 0;
     }
+
+    unsigned prevSamples = instance->audioSampleCount;
+    if (currentSample > prevSamples)
+        return currentSample - prevSamples;
     return 0;
 }
 
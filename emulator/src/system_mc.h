@@ -31,6 +31,7 @@
 #include <vector>
 #include "tinythread.h"
 #include "wavefile.h"
+#include "mc_flash_timing.h"
 
 class System;
 class Radio;
@@ -45,7 +46,23 @@ namespace Cube {
 
 class SystemMC {
  public:
-    bool init(System *sys);
+    /**
+     * Simulated MC peripherals which don't need a class of their own.
+     * The mc_* modules behind Crc32, FlashDevice, HomeButton and Volume
+     * keep their state here, so it belongs to one System.
+     */
+    struct Peripherals {
+        uint32_t crc;
+        bool crcInit;
+        int flashStealthIO;
+        uint32_t homeButton;
+        int volume;
+        int unmuteVolume;
+    };
+
+    SystemMC(System *sys);
+
+    bool init();
     void exit();
 
     void start();
@@ -61,6 +78,14 @@ class SystemMC {
         return instance->sys;
     }
 
+    static Peripherals &getPeripherals() {
+        return instance->peripherals;
+    }
+
+    static FlashTimingModel &getFlashTiming() {
+        return instance->flashTiming;
+    }
+
     // Exit from Siftulator entirely, from within the System simulation thread.
     static void exit(int result);
 
@@ -74,11 +99,10 @@ class SystemMC {
 
     /**
      * Log some audio data. Has no effect unless --waveout was
-     * specified on the command line, and the file opened successfully.
+     * specified on the command line and the file opened successfully,
+     * or an audio digest is running.
      */
-    static void logAudioSamples(const int16_t *samples, unsigned count) {
-        instance->waveOut.write(samples, count);
-    }
+    static void logAudioSamples(const int16_t *samples, unsigned count);
 
     /**
      * How many audio samples should we mix?
@@ -87,6 +111,19 @@ class SystemMC {
      */
     static unsigned suggestAudioSamplesToMix();
 
+    /// Current MC time, in ticks. Only meaningful from the MC thread.
+    static uint64_t getTicks() {
+        return instance->ticks;
+    }
+
+    /**
+     * Total number of ticks the MC has spent doing work, rather than
+     * waiting for interrupts. Only meaningful from the MC thread.
+     */
+    static uint64_t getBusyTicks() {
+        return instance->ticks - instance->idleTicks;
+    }
+
  private:
     static void threadFn(void *);
     void doRadioPacket();
@@ -100,15 +137,21 @@ class SystemMC {
     friend class Tasks;
 
     static SystemMC *instance;
-    static std::vector< std::vector<uint8_t> > pendingGameInstalls;
-    static tthread::mutex pendingGameInstallLock;
+
+    std::vector< std::vector<uint8_t> > pendingGameInstalls;
+    tthread::mutex pendingGameInstallLock;
 
     uint64_t ticks;
+    uint64_t idleTicks;
     uint64_t radioPacketDeadline;
     uint64_t heartbeatDeadline;
+    uint64_t dataPipeDeadline;
 
     System *sys;
+    Peripherals peripherals;
+    FlashTimingModel flashTiming;
     WaveWriter waveOut;
+    unsigned audioSampleCount;
     
     tthread::thread *mThread;
     bool mThreadRunning;
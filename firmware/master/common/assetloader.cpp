@@ -34,14 +34,19 @@
 _SYSAssetLoader *AssetLoader::userLoader;
 const _SYSAssetConfiguration *AssetLoader::userConfig[_SYS_NUM_CUBE_SLOTS];
 uint8_t AssetLoader::userConfigSize[_SYS_NUM_CUBE_SLOTS];
+const _SYSAssetConfiguration *AssetLoader::pendingConfig[_SYS_NUM_CUBE_SLOTS];
+uint8_t AssetLoader::pendingConfigSize[_SYS_NUM_CUBE_SLOTS];
 uint8_t AssetLoader::cubeTaskState[_SYS_NUM_CUBE_SLOTS];
 uint8_t AssetLoader::cubeBufferAvail[_SYS_NUM_CUBE_SLOTS];
 uint8_t AssetLoader::cubeLastQuery[_SYS_NUM_CUBE_SLOTS];
+uint8_t AssetLoader::cubeSkipSlots[_SYS_NUM_CUBE_SLOTS];
 SysTime::Ticks AssetLoader::cubeDeadline[_SYS_NUM_CUBE_SLOTS];
 AssetLoader::SubState AssetLoader::cubeTaskSubstate[_SYS_NUM_CUBE_SLOTS];
 _SYSCubeIDVector AssetLoader::activeCubes;
 _SYSCubeIDVector AssetLoader::startedCubes;
 _SYSCubeIDVector AssetLoader::cacheCoherentCubes;
+_SYSCubeIDVector AssetLoader::prefetchCubes;
+_SYSCubeIDVector AssetLoader::drainCubes;
 _SYSCubeIDVector AssetLoader::resetPendingCubes;
 _SYSCubeIDVector AssetLoader::resetAckCubes;
 _SYSCubeIDVector AssetLoader::queryPendingCubes;
@@ -59,13 +64,19 @@ void AssetLoader::init()
     // This is sufficient to invalidate all other state
     userLoader = NULL;
     activeCubes = 0;
+    prefetchCubes = 0;
+    drainCubes = 0;
 }
 
 void AssetLoader::finish()
 {
-    // Wait until loads finish and/or cubes disconnect
+    // Nobody is going to use our prefetched data now
+    stopPrefetch(prefetchCubes);
+
+    // Wait until loads finish and/or cubes disconnect. Asset loading is
+    // latency-bound, so don't let idle-time flash work wait on an erase.
     while (activeCubes)
-        Tasks::idle();
+        Tasks::idle(Tasks::eraseLatencyTasks());
 
     // Reset user state, disconnecting the AssetLoader
     init();
@@ -73,12 +84,75 @@ void AssetLoader::finish()
 
 void AssetLoader::cancel(_SYSCubeIDVector cv)
 {
-    // Undo the effects of 'start'. Make this cube inactive, and don't auto-restart it.
+    /*
+     * A load which is still draining a prefetched group hasn't written
+     * anything of its own yet. Turn it back into a prefetch, and let that
+     * group finish quietly rather than leaving the slot indeterminate.
+     */
+
+    _SYSCubeIDVector iterCV = cv & drainCubes & ~prefetchCubes;
+    while (iterCV) {
+        _SYSCubeID id = Intrinsic::CLZ(iterCV);
+        iterCV ^= Intrinsic::LZ(id);
+        pendingConfig[id] = NULL;
+        pendingConfigSize[id] = 0;
+    }
+    Atomic::Or(prefetchCubes, cv & drainCubes);
     Atomic::And(startedCubes, ~cv);
+    stopPrefetch(cv);
+
+    // Undo the effects of 'start'. Make this cube inactive, and don't auto-restart it.
+    cv &= ~prefetchCubes;
     Atomic::And(activeCubes, ~cv);
     updateActiveCubes();
 }
 
+void AssetLoader::stopPrefetch(_SYSCubeIDVector cv)
+{
+    /*
+     * Stop prefetching on these cubes. Cubes which are between groups stop
+     * right away, others finish their current group first.
+     */
+
+    cv &= prefetchCubes & activeCubes;
+    while (cv) {
+        _SYSCubeID id = Intrinsic::CLZ(cv);
+        _SYSCubeIDVector bit = Intrinsic::LZ(id);
+        cv ^= bit;
+
+        if (isWritingGroup(id)) {
+            drainCube(id, NULL, 0);
+        } else {
+            Atomic::And(activeCubes, ~bit);
+            Atomic::And(prefetchCubes, ~bit);
+            Atomic::And(drainCubes, ~bit);
+        }
+    }
+    updateActiveCubes();
+}
+
+void AssetLoader::drainCube(_SYSCubeID id, const _SYSAssetConfiguration *cfg, unsigned cfgSize)
+{
+    // Switch to 'cfg' (or stop, if NULL) as soon as the current group is finished
+    pendingConfig[id] = cfg;
+    pendingConfigSize[id] = cfgSize;
+    Atomic::SetLZ(drainCubes, id);
+}
+
+void AssetLoader::finishDrain(_SYSCubeID id)
+{
+    // The cube is between groups now, or we gave up on it. Move on to the pending configuration.
+    Atomic::ClearLZ(drainCubes, id);
+
+    if (!pendingConfig[id])
+        return fsmEnterState(id, S_COMPLETE);
+
+    userConfig[id] = pendingConfig[id];
+    userConfigSize[id] = pendingConfigSize[id];
+    resetDeadline(id);
+    fsmEnterState(id, S_RESET1);
+}
+
 void AssetLoader::cubeConnect(_SYSCubeID id)
 {
     // Restart loading on this cube, if we aren't done loading yet
@@ -89,7 +163,7 @@ void AssetLoader::cubeConnect(_SYSCubeID id)
     // Forget about any queries sent prior to the connect
     cubeLastQuery[id] = 0;
 
-    if (!activeCubes) {
+    if (!(activeCubes & ~prefetchCubes)) {
         /*
          * Load is already done! If we added a new cube now,
          * there wouldn't be a non-racy way for userspace to
@@ -113,6 +187,15 @@ void AssetLoader::cubeDisconnect(_SYSCubeID id)
     ASSERT(id < _SYS_NUM_CUBE_SLOTS);
     _SYSCubeIDVector bit = Intrinsic::LZ(id);
     Atomic::And(activeCubes, ~bit);
+
+    // A load that was waiting on a prefetched group starts from scratch if we reconnect
+    if ((drainCubes & bit) && !(prefetchCubes & bit)) {
+        userConfig[id] = pendingConfig[id];
+        userConfigSize[id] = pendingConfigSize[id];
+    }
+    Atomic::And(drainCubes, ~bit);
+    Atomic::And(prefetchCubes, ~bit);
+
     Atomic::And(cacheCoherentCubes, ~bit);
     Atomic::And(queryErrorCubes, ~bit);
     Atomic::And(queryPendingCubes, ~bit);
@@ -129,11 +212,31 @@ void AssetLoader::start(_SYSAssetLoader *loader, const _SYSAssetConfiguration *c
     ASSERT(cfg);
     ASSERT(cfgSize < 0x100);
 
+    /*
+     * Cubes that are partway through prefetching a group need to finish
+     * that group before they can switch over. Either way, these are real
+     * loads from now on.
+     */
+
+    _SYSCubeIDVector drainCV = 0;
+    _SYSCubeIDVector iterCV = cv & (prefetchCubes | drainCubes) & activeCubes;
+    while (iterCV) {
+        _SYSCubeID id = Intrinsic::CLZ(iterCV);
+        _SYSCubeIDVector bit = Intrinsic::LZ(id);
+        iterCV ^= bit;
+
+        if (isWritingGroup(id)) {
+            drainCube(id, cfg, cfgSize);
+            drainCV |= bit;
+        }
+    }
+    Atomic::And(prefetchCubes, ~cv);
+
     // If these cubes were already loading, temporarily cancel them
-    cancel(cv);
+    cancel(cv & ~drainCV);
 
     // Update per-cube state
-    _SYSCubeIDVector iterCV = cv;
+    iterCV = cv & ~drainCV;
     while (iterCV) {
         _SYSCubeID id = Intrinsic::CLZ(iterCV);
         _SYSCubeIDVector bit = Intrinsic::LZ(id);
@@ -165,6 +268,59 @@ void AssetLoader::start(_SYSAssetLoader *loader, const _SYSAssetConfiguration *c
     Tasks::trigger(Tasks::AssetLoader);
 }
 
+void AssetLoader::prefetch(_SYSAssetLoader *loader, const _SYSAssetConfiguration *cfg,
+    unsigned cfgSize, _SYSCubeIDVector cv)
+{
+    /*
+     * Like start(), but this is only a hint. We never touch cubes that
+     * are doing a real load, and we don't auto-restart on reconnect.
+     * Any prefetch already in progress is replaced.
+     */
+
+    ASSERT(loader);
+    ASSERT(userLoader == loader || !userLoader);
+    userLoader = loader;
+
+    ASSERT(cfg);
+    ASSERT(cfgSize < 0x100);
+
+    cv &= CubeSlots::userConnected & ~(activeCubes & ~prefetchCubes);
+
+    _SYSCubeIDVector iterCV = cv;
+    while (iterCV) {
+        _SYSCubeID id = Intrinsic::CLZ(iterCV);
+        _SYSCubeIDVector bit = Intrinsic::LZ(id);
+        iterCV ^= bit;
+
+        if ((activeCubes & bit) && isWritingGroup(id)) {
+            drainCube(id, cfg, cfgSize);
+            continue;
+        }
+
+        Atomic::Or(prefetchCubes, bit);
+        Atomic::And(drainCubes, ~bit);
+
+        userConfig[id] = cfg;
+        userConfigSize[id] = cfgSize;
+
+        resetDeadline(id);
+        fsmEnterState(id, S_RESET1);
+
+        // Reset the FIFO, but leave the game's progress counters alone
+        _SYSAssetLoaderCube *lc = AssetUtil::mapLoaderCube(loader, id);
+        if (lc) {
+            lc->head = 0;
+            lc->tail = 0;
+        } else {
+            LOG(("ASSET[%d]: Cannot map _SYSAssetLoaderCube. Bad _SYSAssetLoader address.\n", id));
+        }
+    }
+
+    Atomic::Or(activeCubes, cv);
+    updateActiveCubes();
+    Tasks::trigger(Tasks::AssetLoader);
+}
+
 void AssetLoader::ackReset(_SYSCubeID id)
 {
     /*
@@ -327,8 +483,13 @@ void AssetLoader::heartbeat()
         if (now > cubeDeadline[id]) {
             LOG(("ASSET[%d]: Deadline passed, restarting load\n", id));
 
-            resetDeadline(id);
-            fsmEnterState(id, S_RESET1);
+            if (drainCubes & Intrinsic::LZ(id)) {
+                // Don't bother finishing the old group
+                finishDrain(id);
+            } else {
+                resetDeadline(id);
+                fsmEnterState(id, S_RESET1);
+            }
         }
     }
 }
@@ -356,6 +517,7 @@ void AssetLoader::prepareCubeForLoading(_SYSCubeID id)
     int groupsFree[_SYS_ASSET_SLOTS_PER_BANK];
     unsigned numSlots = VirtAssetSlots::getNumBoundSlots();
     _SYSCubeIDVector bit = Intrinsic::LZ(id);
+    bool isPrefetch = prefetchCubes & bit;
 
     for (unsigned slot = 0; slot < numSlots; ++slot) {
         SysLFS::AssetSlotRecord asr;
@@ -436,9 +598,29 @@ void AssetLoader::prepareCubeForLoading(_SYSCubeID id)
      */
 
     unsigned totalData = 0;
+    cubeSkipSlots[id] = 0;
+
+    /*
+     * Prefetched groups are committed to their slot as soon as each one
+     * finishes, even if the game never starts this configuration. So a
+     * prefetch only runs if the whole configuration fits in free space;
+     * otherwise it could leave a slot half-filled with groups nobody asked
+     * for, forcing an erase on the next start() of anything else.
+     */
+
+    bool fits = true;
+    for (unsigned slot = 0; slot < numSlots; ++slot)
+        if (tilesFree[slot] < 0 || groupsFree[slot] < 0)
+            fits = false;
 
     for (unsigned slot = 0; slot < numSlots; ++slot) {
 
+        if (isPrefetch && !fits) {
+            // Prefetches never erase. Leave every slot alone.
+            cubeSkipSlots[id] |= 1 << slot;
+            continue;
+        }
+
         if (tilesFree[slot] < 0 || groupsFree[slot] < 0) {
             // Underflow! Erase the slot.
             LOG(("ASSET[%d]: Automatically erasing slot %d\n", id, slot));
@@ -455,7 +637,7 @@ void AssetLoader::prepareCubeForLoading(_SYSCubeID id)
      */
 
     _SYSAssetLoaderCube *lc = AssetUtil::mapLoaderCube(userLoader, id);
-    if (lc) {
+    if (lc && !isPrefetch) {
         lc->progress = 0;
         lc->total = totalData;
     }
@@ -49,6 +49,14 @@ struct AssetGroupInfo;
  * userspace _SYSAssetLoader. We orchestrate the loading process and
  * access flash memory from a Task which fills the FIFO with commands
  * and data.
+ *
+ * A configuration can also be prefetched. This runs the same state machine,
+ * but silently and only with radio bandwidth nobody else wants. It never
+ * erases a slot. Groups are committed as soon as they finish, so a cube is
+ * only prefetched if the whole configuration fits in free space. A cube's
+ * flash is only safe to abandon between groups, so if a prefetch needs to
+ * stop mid-group, it "drains" that group first and then moves on to
+ * whatever configuration is pending, if any.
  */
 
 class AssetLoader
@@ -57,6 +65,8 @@ public:
     // Userspace-visible operations
     static void start(_SYSAssetLoader *loader, const _SYSAssetConfiguration *cfg,
         unsigned cfgSize, _SYSCubeIDVector cv);
+    static void prefetch(_SYSAssetLoader *loader, const _SYSAssetConfiguration *cfg,
+        unsigned cfgSize, _SYSCubeIDVector cv);
     static void cancel(_SYSCubeIDVector cv);
     static void finish();
 
@@ -87,6 +97,11 @@ public:
         return activeCubes;
     }
 
+    /// Which of the active cubes are only prefetching?
+    static ALWAYS_INLINE _SYSCubeIDVector getPrefetchCubes() {
+        return prefetchCubes;
+    }
+
     /// Which cubes have we validated the cache on?
     static ALWAYS_INLINE _SYSCubeIDVector getCacheCoherentCubes() {
         return cacheCoherentCubes;
@@ -145,17 +160,28 @@ private:
     // Synchronous preparations (Happens while we're waiting for reset)
     static void prepareCubeForLoading(_SYSCubeID id);
 
+    // Prefetch helpers
+    static void stopPrefetch(_SYSCubeIDVector cv);
+    static void drainCube(_SYSCubeID id, const _SYSAssetConfiguration *cfg, unsigned cfgSize);
+    static void finishDrain(_SYSCubeID id);
+
+    // Is this cube partway through writing a group to flash?
+    static ALWAYS_INLINE bool isWritingGroup(_SYSCubeID id) {
+        unsigned state = cubeTaskState[id];
+        return state >= S_CONFIG_ADDR && state <= S_CONFIG_FINISH;
+    }
+
     // Simulation-only asset loader bypass hook
     #ifdef SIFTEO_SIMULATOR
     static bool loaderBypass(_SYSCubeID id, AssetGroupInfo &group);
     #endif
 
-    // Copy activeCubes to read-only userspace 'busyCubes' value.
+    // Copy activeCubes to read-only userspace 'busyCubes' value. Prefetches are invisible.
     static ALWAYS_INLINE void updateActiveCubes()
     {
         _SYSAssetLoader *localUserLoader = userLoader;
         if (localUserLoader)
-            localUserLoader->busyCubes = activeCubes;
+            localUserLoader->busyCubes = activeCubes & ~prefetchCubes;
     }
 
     /*
@@ -182,16 +208,23 @@ private:
     static const _SYSAssetConfiguration *userConfig[_SYS_NUM_CUBE_SLOTS];
     static uint8_t userConfigSize[_SYS_NUM_CUBE_SLOTS];
 
+    // Configuration to switch to after draining the current group. NULL to just stop.
+    static const _SYSAssetConfiguration *pendingConfig[_SYS_NUM_CUBE_SLOTS];
+    static uint8_t pendingConfigSize[_SYS_NUM_CUBE_SLOTS];
+
     // Aggregate cube state, set up by high-level entry points
     static _SYSCubeIDVector activeCubes;            // Cubes that are currently loading
     static _SYSCubeIDVector startedCubes;           // Started, and restartable on cubeConnect()
     static _SYSCubeIDVector cacheCoherentCubes;     // We're sure SysLFS state matches actual cube flash mem
+    static _SYSCubeIDVector prefetchCubes;          // Active, but only prefetching
+    static _SYSCubeIDVector drainCubes;             // Finish the current group, then use pendingConfig
 
     // Task-owned cube state. Read-only from ISR.
     static uint8_t cubeTaskState[_SYS_NUM_CUBE_SLOTS];
     static SubState cubeTaskSubstate[_SYS_NUM_CUBE_SLOTS];
     static SysTime::Ticks cubeDeadline[_SYS_NUM_CUBE_SLOTS];
     static uint8_t cubeLastQuery[_SYS_NUM_CUBE_SLOTS];
+    static uint8_t cubeSkipSlots[_SYS_NUM_CUBE_SLOTS];     // Slots a prefetch can't fit into
 
     // ISR-owned cube state. Read-only from tasks.
     static uint8_t cubeBufferAvail[_SYS_NUM_CUBE_SLOTS];
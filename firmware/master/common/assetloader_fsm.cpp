@@ -63,8 +63,13 @@ void AssetLoader::fsmEnterState(_SYSCubeID id, TaskState s)
          */
         case S_COMPLETE:
             Atomic::ClearLZ(activeCubes, id);
+            if (prefetchCubes & Intrinsic::LZ(id)) {
+                // Prefetches finish silently
+                Atomic::ClearLZ(prefetchCubes, id);
+            } else {
+                Event::setCubePending(Event::PID_CUBE_ASSETDONE, id);
+            }
             updateActiveCubes();
-            Event::setCubePending(Event::PID_CUBE_ASSETDONE, id);
             return;
 
         default:
@@ -323,6 +328,11 @@ void AssetLoader::fsmTaskState(_SYSCubeID id, TaskState s)
                     cubeTaskSubstate[id].config.index = index + 1;
                     continue;
                 }
+                if ((prefetchCubes & bit) && (cubeSkipSlots[id] & (1 << slot))) {
+                    // Prefetch would need to erase this slot, skip it
+                    cubeTaskSubstate[id].config.index = index + 1;
+                    continue;
+                }
                 VirtAssetSlot &vSlot = VirtAssetSlots::getInstance(slot);
 
                 // Now search for the group, allocating it if it wasn't found.
@@ -410,7 +420,8 @@ void AssetLoader::fsmTaskState(_SYSCubeID id, TaskState s)
 
             // Update current load offset and the progress indicator
             offset += bytes;
-            lc->progress += bytes;
+            if (!(prefetchCubes & bit))
+                lc->progress += bytes;
             cubeTaskSubstate[id].config.offset = offset;
             resetDeadline(id);
 
@@ -463,6 +474,10 @@ void AssetLoader::fsmTaskState(_SYSCubeID id, TaskState s)
                 id, index+1, userConfigSize[id],
                 (SysTime::ticks() - groupBeginTimestamp[id]) / double(SysTime::sTicks(1))));
 
+            // Were we waiting for this group before switching configurations?
+            if (drainCubes & bit)
+                return finishDrain(id);
+
             // Next Configuration node!
             cubeTaskSubstate[id].config.index = index + 1;
             return fsmEnterState(id, S_CONFIG_INIT);
@@ -60,6 +60,7 @@ void CubeSlot::connect(SysLFS::Key cubeRecord, const RadioAddress &addr, const R
     pendingChannel = INVALID_CHANNEL;
     ackOptional = false;
     napDeadline = 0;
+    loaderPolls = 0;
 
     // Store new identity
     lastACK = fullACK;
@@ -163,6 +164,8 @@ void CubeSlot::setVideoBuffer(_SYSVideoBuffer *v)
         vf.apply(v);
     }
 
+    // The LCD no longer necessarily shows this buffer's contents
+    paintControl.getWindow().invalidate();
     vbuf = v;
 }
 
@@ -242,17 +245,18 @@ bool CubeSlot::radioProduce(PacketTransmission &tx, SysTime::Ticks now)
     } else if (UNLIKELY(CubeSlots::sendStipple & cv)) {
         // Send a stipple pattern
         codec.encodeStipple(tx.packet, vbuf);
+        paintControl.getWindow().invalidate();
         Atomic::And(CubeSlots::sendStipple, ~cv);
         ASSERT(!tx.packet.isFull());
 
     } else if (LIKELY(0 == (CubeSlots::vramPaused & cv))) {
         // Normal updates from VideoBuffer
 
-        if (codec.encodeVRAM(tx.packet, vbuf)) {
+        if (codec.encodeVRAM(tx.packet, vbuf, paintControl.getWindow())) {
             // Finished flushing Video Buffer. Maybe trigger a render.
 
             if (paintControl.vramFlushed(this)) {
-                if (!codec.encodeVRAM(tx.packet, vbuf)) {
+                if (!codec.encodeVRAM(tx.packet, vbuf, paintControl.getWindow())) {
                     // Didn't have enough room to flush the trigger. More work to do!
                     idle = false;
                 }
@@ -272,7 +276,7 @@ bool CubeSlot::radioProduce(PacketTransmission &tx, SysTime::Ticks now)
      * flashEscape.
      */
 
-    if (AssetLoader::getActiveCubes() & cv) {
+    if (AssetLoader::getActiveCubes() & ~AssetLoader::getPrefetchCubes() & cv) {
         // Loading is in progress
 
         // Keep the radio from sleeping as long as we're loading assets.
@@ -281,11 +285,18 @@ bool CubeSlot::radioProduce(PacketTransmission &tx, SysTime::Ticks now)
         if (AssetLoader::needFlashPacket(id()) && codec.escFlash(tx.packet)) {
             // Loader has data to send. Send an escape, and be done with this packet.
             AssetLoader::produceFlashPacket(id(), tx.packet);
+            loaderPolls = 0;
+
+            // Tiles may change without any VRAM changes
+            paintControl.getWindow().invalidate();
+
+            // If there's more ready to go, ask to keep the radio
+            tx.burst = AssetLoader::needFlashPacket(id());
             return true;
         }
 
         // Otherwise, maybe the loader needs a full ACK before it can make progress?
-        if (AssetLoader::needFullACK(id()) && codec.escRequestAck(tx.packet))
+        if (AssetLoader::needFullACK(id()) && requestLoaderACK(tx, now))
             return true;
     }
 
@@ -309,6 +320,29 @@ bool CubeSlot::radioProduce(PacketTransmission &tx, SysTime::Ticks now)
         return true;
     }
 
+    /*
+     * Lowest priority: Asset prefetching
+     *
+     * Prefetches only get packets that would otherwise have been empty,
+     * so they never compete with rendering or with a real asset load.
+     * They write to unused flash, so there's no need to invalidate
+     * the paint window here.
+     */
+
+    if ((AssetLoader::getPrefetchCubes() & cv) && tx.packet.len == 0) {
+        idle = false;
+
+        if (AssetLoader::needFlashPacket(id()) && codec.escFlash(tx.packet)) {
+            AssetLoader::produceFlashPacket(id(), tx.packet);
+            loaderPolls = 0;
+            tx.burst = AssetLoader::needFlashPacket(id());
+            return true;
+        }
+
+        if (AssetLoader::needFullACK(id()) && requestLoaderACK(tx, now))
+            return true;
+    }
+
     /*
      * Last priority: Radio power management
      *
@@ -334,6 +368,29 @@ bool CubeSlot::radioProduce(PacketTransmission &tx, SysTime::Ticks now)
     return true;
 }
 
+bool CubeSlot::requestLoaderACK(PacketTransmission &tx, SysTime::Ticks now)
+{
+    /*
+     * The asset loader is waiting on this cube, usually for it to make room
+     * in its flash FIFO. An explicit ACK request gets us the latest FIFO
+     * state. But if several requests in a row turn up no progress, the cube
+     * is busy programming flash and our packets are just stealing its CPU
+     * time. In that case, ask it to take a short nap after this ACK. The
+     * radio goes to other producers in the meantime.
+     */
+
+    if (!codec.escRequestAck(tx.packet))
+        return false;
+
+    if (++loaderPolls >= LOADER_POLLS_BEFORE_NAP && getVersion() >= CUBE_FEATURE_NAP &&
+        codec.escRadioNap(tx.packet, LOADER_NAP_TICKS)) {
+        napDeadline = now + SysTime::msTicks(1) + (uint32_t(SysTime::hzTicks(32768)) * LOADER_NAP_TICKS);
+        loaderPolls = 0;
+    }
+
+    return true;
+}
+
 void CubeSlot::radioEmptyAcknowledge()
 {
     ackOptional = false;
@@ -374,8 +431,10 @@ void CubeSlot::radioAcknowledge(const PacketBuffer &packet)
         // This ACK includes a valid flash_fifo_bytes counter
 
         uint8_t loadACK = ack->flash_fifo_bytes - lastACK.flash_fifo_bytes;
-        if (loadACK)
+        if (loadACK) {
             AssetLoader::ackData(id(), loadACK);
+            loaderPolls = 0;
+        }
     }
 
     if (packet.len >= offsetof(RF_ACKType, accel) + sizeof ack->accel) {
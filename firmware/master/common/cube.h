@@ -194,6 +194,10 @@ class CubeSlot {
         return &address;
     }
 
+    ALWAYS_INLINE bool isNapping(SysTime::Ticks now) const {
+        return napDeadline > now;
+    }
+
     ALWAYS_INLINE SysLFS::Key getCubeRecordKey() const {
         ASSERT(cubeRecord >= SysLFS::kCubeBase);
         ASSERT(cubeRecord < static_cast<SysLFS::Key>(SysLFS::kCubeBase + SysLFS::NUM_PAIRINGS));
@@ -207,6 +211,10 @@ class CubeSlot {
     // determine whether pending channel hop value is valid
     static const unsigned INVALID_CHANNEL = 0xff;
 
+    // Unanswered asset loader ACK requests before we let the cube nap, and for how long (32.768 kHz ticks)
+    static const unsigned LOADER_POLLS_BEFORE_NAP = 4;
+    static const unsigned LOADER_NAP_TICKS = 33;
+
     // Large data
     SysTime::Ticks napDeadline;     // Accessed on ISR only, after connect
     PaintControl paintControl;
@@ -223,10 +231,12 @@ class CubeSlot {
     RF_ACKType lastACK;
 
     uint8_t pendingChannel;
+    uint8_t loaderPolls;
     bool ackOptional;
 
     uint16_t calculateTimeSync();
     unsigned suggestNapTicks();
+    bool requestLoaderACK(PacketTransmission &tx, SysTime::Ticks now);
 
     void queryResponse(const PacketBuffer &packet);
 
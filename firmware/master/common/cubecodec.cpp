@@ -30,6 +30,7 @@
 #include "cubeslots.h"
 #include "svmmemory.h"
 #include "tasks.h"
+#include "paintcontrol.h"
 
 using namespace Intrinsic;
 
@@ -37,7 +38,7 @@ uint16_t CubeCodec::exemptionBegin;
 uint16_t CubeCodec::exemptionEnd;
 
 
-bool CubeCodec::encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb)
+bool CubeCodec::encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb, PaintWindow &window)
 {
     /*
      * Note that we have to sweep that change map as we go. Since
@@ -69,6 +70,9 @@ bool CubeCodec::encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb)
      * Returns true iff all VRAM has been flushed. The caller should try
      * to send this additional data, if there's still room in the TX
      * buffer.
+     *
+     * Every word we send is also reported to the cube's PaintWindow, so
+     * it can keep track of which scanlines need to be redrawn.
      */
 
     bool flushed = false;
@@ -120,6 +124,8 @@ bool CubeCodec::encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb)
                     break;
                 }
 
+                window.wordEncoded(vb, addr);
+
                 // Extend or reset the exemption range.
                 if (addr != exemptionEnd)
                     exemptionBegin = addr;
@@ -33,6 +33,8 @@
 #include "radio.h"
 #include "vram.h"
 
+class PaintWindow;
+
 #ifdef CODEC_DEBUG
 #define CODEC_DEBUG_LOG(x)   DEBUG_LOG(x)
 #else
@@ -117,7 +119,7 @@ class CubeCodec {
     }
 
     // Returns 'true' if finished.
-    bool encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb);
+    bool encodeVRAM(PacketBuffer &buf, _SYSVideoBuffer *vb, PaintWindow &window);
 
     bool encodeVRAMAddr(PacketBuffer &buf, uint16_t addr);
     bool encodeVRAMData(PacketBuffer &buf, uint16_t data);
@@ -172,7 +172,8 @@ void CubeSlots::finishCubes(_SYSCubeIDVector cv, uint32_t excludedTasks)
         if (finished)
             break;
 
-        Tasks::idle(excludedTasks);
+        // Never stall a frame behind a flash erase
+        Tasks::idle(excludedTasks | Tasks::eraseLatencyTasks());
     }
 }
 
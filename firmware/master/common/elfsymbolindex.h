@@ -0,0 +1,152 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Thundercracker firmware
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Sorted index of the symbols in an ELF .symtab, for quickly mapping
+ * addresses back to symbols. Host-side only; shared by the emulator's
+ * and swiss's ELFDebugInfo implementations.
+ *
+ * Symbol names are cached here too, but it's up to the caller to fill
+ * them in, since only the caller knows how to read the string table.
+ */
+
+#ifndef ELF_SYMBOL_INDEX_H
+#define ELF_SYMBOL_INDEX_H
+
+#include "elfdefs.h"
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+class ElfSymbolIndex {
+public:
+    struct Entry {
+        Elf::Symbol symbol;
+        uint64_t end;
+        bool hasName;
+        bool hasDemangledName;
+        std::string name;
+        std::string demangledName;
+    };
+
+    ElfSymbolIndex() : built(false) {}
+
+    bool isBuilt() const {
+        return built;
+    }
+
+    void clear() {
+        entries.clear();
+        maxEnd.clear();
+        built = false;
+    }
+
+    /**
+     * Build the index from the raw contents of a .symtab section.
+     * Symbols with no size can never contain an address, so they're skipped.
+     */
+    void build(const Elf::Symbol *symbols, unsigned count)
+    {
+        clear();
+
+        std::vector<Elf::Symbol> sorted;
+        sorted.reserve(count);
+
+        for (unsigned i = 0; i < count; ++i) {
+            Elf::Symbol sym = symbols[i];
+
+            // Strip the Thumb bit from function symbols.
+            if ((sym.st_info & 0xF) == Elf::STT_FUNC)
+                sym.st_value &= ~1;
+
+            if (sym.st_size)
+                sorted.push_back(sym);
+        }
+
+        // Stable, so that symbols at the same address stay in table order.
+        // Sort the bare symbols, before we have any strings to shuffle around.
+        std::stable_sort(sorted.begin(), sorted.end(), symbolLess);
+
+        entries.resize(sorted.size());
+        for (unsigned i = 0; i < sorted.size(); ++i) {
+            Entry &e = entries[i];
+            e.symbol = sorted[i];
+            e.end = uint64_t(e.symbol.st_value) + e.symbol.st_size;
+            e.hasName = false;
+            e.hasDemangledName = false;
+        }
+
+        // Running maximum of each symbol's end address, so lookups know
+        // when they can stop searching backwards for enclosing symbols.
+        maxEnd.resize(entries.size());
+        uint64_t m = 0;
+        for (unsigned i = 0; i < entries.size(); ++i)
+            maxEnd[i] = m = std::max(m, entries[i].end);
+
+        built = true;
+    }
+
+    /**
+     * Find the symbol which contains 'address' and starts closest to it.
+     * If several symbols tie, the earliest one in the symbol table wins.
+     * This matches a linear scan over the whole table. Returns NULL if
+     * no symbol contains this address.
+     */
+    Entry *find(uint32_t address)
+    {
+        std::vector<Entry>::iterator I =
+            std::upper_bound(entries.begin(), entries.end(), address, addressLess);
+
+        Entry *best = 0;
+        unsigned i = I - entries.begin();
+
+        while (i-- && maxEnd[i] > address) {
+            Entry &e = entries[i];
+
+            if (best && e.symbol.st_value != best->symbol.st_value)
+                break;
+            if (e.end > address)
+                best = &e;
+        }
+
+        return best;
+    }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<uint64_t> maxEnd;
+    bool built;
+
+    static bool symbolLess(const Elf::Symbol &a, const Elf::Symbol &b) {
+        return a.st_value < b.st_value;
+    }
+
+    static bool addressLess(uint32_t address, const Entry &e) {
+        return address < e.symbol.st_value;
+    }
+};
+
+#endif // ELF_SYMBOL_INDEX_H
@@ -28,9 +28,12 @@
 #include "macros.h"
 #include "bits.h"
 #include "crc.h"
+#include "tasks.h"
 
 FlashLFS FlashLFSCache::instances[SIZE];
 uint8_t FlashLFSCache::lastUsed = 0;
+uint8_t FlashLFSCache::heartbeatDivider;
+bool FlashLFSCache::gcAllowed;
 
 
 uint8_t LFS::computeCheckByte(uint8_t a, uint8_t b)
@@ -471,6 +474,7 @@ void FlashLFS::initWithVolumeVector(FlashVolume parent, FlashLFSVolumeVector::Se
      */
 
     this->parent = parent;
+    mayHaveGarbage = true;
 
     volumes.sort(si);
 
@@ -543,11 +547,41 @@ void FlashLFSCache::invalidate()
         instances[i].invalidate();
 }
 
+void FlashLFSCache::heartbeat()
+{
+    if (++heartbeatDivider >= Tasks::HEARTBEAT_HZ) {
+        heartbeatDivider = 0;
+        gcAllowed = true;
+    }
+}
+
+bool FlashLFSCache::idle()
+{
+    /*
+     * Collect garbage a little at a time while we're idle, on any cached
+     * filesystem that's been written since we last found it clean. Doing
+     * this ahead of time keeps the synchronous collector in
+     * FlashLFSObjectAllocator::allocateAndCollectGarbage() a rare fallback.
+     */
+
+    if (LIKELY(!gcAllowed))
+        return false;
+    gcAllowed = false;
+
+    for (unsigned i = 0; i < SIZE; ++i) {
+        FlashLFS &lfs = instances[i];
+        if (lfs.isValid() && lfs.mayHaveGarbage && lfs.collectIncrementalGarbage())
+            return true;
+    }
+
+    return false;
+}
+
 FlashLFSObjectAllocator::FlashLFSObjectAllocator(FlashLFS &lfs, unsigned key,
-    unsigned size, unsigned crc)
+    unsigned size, unsigned crc, FlashBlockWriter *indexWriter)
     : lfs(lfs), key(key),
       size(roundup<FlashLFSIndexRecord::SIZE_UNIT>(size)),
-      crc(crc), addr(FlashBlock::INVALID_ADDRESS)
+      crc(crc), indexWriter(indexWriter), addr(FlashBlock::INVALID_ADDRESS)
 {
     ASSERT(FlashLFSIndexRecord::isKeyAllowed(key));
     ASSERT(FlashLFSIndexRecord::isSizeAllowed(size));
@@ -563,15 +597,25 @@ bool FlashLFSObjectAllocator::allocate(unsigned volLimit)
      */
 
     FlashVolume vol = lfs.volumes.last();
-    if (vol.block.isValid() && allocInVolume(vol))
-        return true;
+    if (!(vol.block.isValid() && allocInVolume(vol)) &&
+        !(lfs.newVolume(volLimit) && allocInVolume(lfs.volumes.last())))
+        return false;
 
-    return lfs.newVolume(volLimit) && allocInVolume(lfs.volumes.last());
+    // This object may have made an older one obsolete
+    lfs.mayHaveGarbage = true;
+    return true;
 }
 
 bool FlashLFSObjectAllocator::allocateAndCollectGarbage()
 {
-    return allocate() || (lfs.collectGarbage() && allocate());
+    if (allocate())
+        return true;
+
+    // Garbage collection may delete the volume a batched index block lives in
+    if (indexWriter)
+        indexWriter->commitBlock();
+
+    return lfs.collectGarbage() && allocate();
 }
 
 bool FlashLFSObjectAllocator::allocInVolume(FlashVolume vol)
@@ -672,7 +716,8 @@ bool FlashLFSObjectAllocator::allocInVolumeRow(FlashVolume vol,
 
     ASSERT((size % FlashLFSIndexRecord::SIZE_UNIT) == 0);
 
-    FlashBlockWriter writer;
+    FlashBlockWriter localWriter;
+    FlashBlockWriter &writer = indexWriter ? *indexWriter : localWriter;
     FlashLFSIndexBlockIter iter;
     uint32_t indexBlockAddr = LFS::indexBlockAddr(vol, row);
     unsigned volBaseAddr = vol.block.address() + FlashBlock::BLOCK_SIZE;
@@ -734,8 +779,9 @@ bool FlashLFSObjectAllocator::allocInVolumeRow(FlashVolume vol,
     newRecord->init(key, size, crc);
 
     // Write to the meta-index's FlashLFSKeyFilter for this row.
+    // Use a separate writer, so a batched index block stays open.
     if (!hdr->test(row, key)) {
-        writer.beginBlock(&*hdrRef);
+        FlashBlockWriter hdrWriter(hdrRef);
         hdr->add(row, key);
     }
 
@@ -1000,6 +1046,41 @@ bool FlashLFS::collectGlobalGarbage(FlashLFS *exclude)
 }
 
 bool FlashLFS::collectLocalGarbage()
+{
+    // Synchronous collection may copy as much as it needs to, using our padding volumes
+    CopyLimit limit = { unsigned(-1), FlashLFSVolumeVector::MAX_VOLUMES };
+    return collectLocalGarbage(limit);
+}
+
+bool FlashLFS::collectIncrementalGarbage()
+{
+    /*
+     * Like collectLocalGarbage(), but copy at most INCREMENTAL_COPIES live
+     * objects, and leave the padding volumes for the synchronous collector.
+     * Scrubbing a volume may take several steps, and the volume is only
+     * deleted by the step which finds nothing live left in it.
+     *
+     * This needs no separate progress marker to be crash-safe: each copy
+     * is simply a newer version of its object, so a partially scrubbed
+     * volume just has less live data in it the next time we scan.
+     *
+     * Returns true if we copied or deleted anything. Once a step finds
+     * no work, we stop trying until this LFS is written again.
+     */
+
+    ASSERT(isValid());
+
+    CopyLimit limit = { INCREMENTAL_COPIES, FlashLFSVolumeVector::MAX_OBJ_VOLUMES };
+    bool deleted = collectLocalGarbage(limit);
+
+    if (deleted || limit.count != INCREMENTAL_COPIES)
+        return true;
+
+    mayHaveGarbage = false;
+    return false;
+}
+
+bool FlashLFS::collectLocalGarbage(CopyLimit &limit)
 {
     /*
      * Iterate through this LFS, from newest to oldest, keeping track of which
@@ -1038,7 +1119,7 @@ bool FlashLFS::collectLocalGarbage()
      * that are mostly wasted space.
      */
 
-    scrubUnderutilizedVolumes(volumesToKeep, utilization);
+    scrubUnderutilizedVolumes(volumesToKeep, utilization, limit);
 
     /*
      * Delete obsolete volumes, i.e. any volume that we haven't marked
@@ -1124,7 +1205,8 @@ bool FlashLFS::deleteGarbageVolumes(const VolumeIndexVector &volumesToKeep, unsi
     return foundGarbage;
 }
 
-void FlashLFS::scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep, const VolumeUtilizationVector &utilization)
+void FlashLFS::scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep,
+    const VolumeUtilizationVector &utilization, CopyLimit &limit)
 {
     /*
      * Given some information about the utilization level of our volumes, iterate
@@ -1149,7 +1231,7 @@ void FlashLFS::scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep, const
      * since we really don't care if the last volume is underutilized. It's a
      * work in progress anyway.
      */
-    for (int i = volumes.numSlotsInUse - 2; i > 0; --i) {
+    for (int i = volumes.numSlotsInUse - 2; i > 0 && limit.count; --i) {
 
         // Already planning on deleting this one?
         if (!volumesToKeep.test(i))
@@ -1197,13 +1279,13 @@ void FlashLFS::scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep, const
         }
 
         // Now try to scrub this particular volume. If successful, we'll mark it for deletion.
-        if (scrubVolume(i, iter, obsoleteKeys, crc))
+        if (scrubVolume(i, iter, obsoleteKeys, crc, limit))
             volumesToKeep.clear(i);
     }
 }
 
 bool FlashLFS::scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter,
-    FlashLFSIndexRecord::KeyVector_t &obsoleteKeys, uint32_t &crc)
+    FlashLFSIndexRecord::KeyVector_t &obsoleteKeys, uint32_t &crc, CopyLimit &limit)
 {
     /*
      * Scrub the volume. If we're successful, we can return true and the volume will be deleted.
@@ -1217,6 +1299,9 @@ bool FlashLFS::scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter,
      * the loop in scrubUnderutilizedVolumes().
      *
      * 'crc' must always be the CRC of the current record pointed to by 'iter'.
+     *
+     * Running out of 'limit' counts as an unsuccessful scrub; the volume is kept
+     * along with whatever we've copied so far.
      */
 
     while (iter.isInVolumeIndex(volIndex)) {
@@ -1226,8 +1311,9 @@ bool FlashLFS::scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter,
             ASSERT(obsoleteKeys.test(key) == false);
 
             // Found a key that isn't yet obsolete. Copy it!
-            if (!writeCopyOfRecord(iter.record(), crc, iter.address()))
+            if (!limit.count || !writeCopyOfRecord(iter.record(), crc, iter.address(), limit.volLimit))
                 return false;
+            limit.count--;
 
             obsoleteKeys.mark(key);
         }
@@ -1245,7 +1331,8 @@ bool FlashLFS::scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter,
     return true;
 }
 
-bool FlashLFS::writeCopyOfRecord(const FlashLFSIndexRecord *record, uint32_t crc, unsigned srcAddress)
+bool FlashLFS::writeCopyOfRecord(const FlashLFSIndexRecord *record, uint32_t crc,
+    unsigned srcAddress, unsigned volLimit)
 {
     /*
      * Try to copy an existing record to a fresh location in the LFS.
@@ -1256,8 +1343,8 @@ bool FlashLFS::writeCopyOfRecord(const FlashLFSIndexRecord *record, uint32_t crc
     unsigned dataSize = record->getSizeInBytes();
     FlashLFSObjectAllocator allocator(*this, record->getKey(), dataSize, crc);
 
-    // During garbage collection, allow use of all volumes (even our padding space)
-    if (!allocator.allocate(FlashLFSVolumeVector::MAX_VOLUMES)) {
+    // Synchronous garbage collection may use all volumes (even our padding space)
+    if (!allocator.allocate(volLimit)) {
         LOG(("LFS: Defer GC of record 0x%02x at 0x%08x due to insufficient space\n",
             record->getKey(), srcAddress));
         return false;
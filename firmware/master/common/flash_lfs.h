@@ -590,9 +590,13 @@ class FlashLFS
     static const uint32_t INVALID_LSN = -1;
 
 public:
+    // Most live objects we'll copy in one collectIncrementalGarbage() step
+    static const unsigned INCREMENTAL_COPIES = 4;
+
     FlashLFS()
         : lastSequenceNumber(INVALID_LSN),
-          parent(FlashMapBlock::invalid())
+          parent(FlashMapBlock::invalid()),
+          mayHaveGarbage(false)
     {}
 
     void init(FlashVolume parent);
@@ -609,6 +613,9 @@ public:
     // Collect only local garbage on volumes owned by this LFS
     bool collectLocalGarbage();
 
+    // Do a bounded amount of local garbage collection. Returns true if we did any work.
+    bool collectIncrementalGarbage();
+
     ALWAYS_INLINE void invalidate() {
         lastSequenceNumber = INVALID_LSN;
     }
@@ -624,16 +631,24 @@ public:
     uint32_t lastSequenceNumber;
     FlashVolume parent;
     FlashLFSVolumeVector volumes;
+    bool mayHaveGarbage;    // Written to since the last incremental GC found nothing to do
 
 private:
     typedef BitVector<FlashLFSVolumeVector::MAX_VOLUMES> VolumeIndexVector;
     typedef uint16_t VolumeUtilizationVector[FlashLFSVolumeVector::MAX_VOLUMES];
 
+    // How much work a garbage collection pass may do
+    struct CopyLimit {
+        unsigned count;     // Remaining number of objects we may copy
+        unsigned volLimit;  // Volume limit for allocating copies
+    };
+
+    bool collectLocalGarbage(CopyLimit &limit);
     void findGarbageCandidates(VolumeIndexVector &volumesToKeep, VolumeUtilizationVector &utilization);
-    void scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep, const VolumeUtilizationVector &utilization);
-    bool scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter, FlashLFSIndexRecord::KeyVector_t &obsoleteKeys, uint32_t &crc);
+    void scrubUnderutilizedVolumes(VolumeIndexVector &volumesToKeep, const VolumeUtilizationVector &utilization, CopyLimit &limit);
+    bool scrubVolume(unsigned volIndex, FlashLFSObjectIter &iter, FlashLFSIndexRecord::KeyVector_t &obsoleteKeys, uint32_t &crc, CopyLimit &limit);
     bool deleteGarbageVolumes(const VolumeIndexVector &volumesToKeep, unsigned numSlotsInUse);
-    bool writeCopyOfRecord(const FlashLFSIndexRecord *record, uint32_t crc, unsigned srcAddress);
+    bool writeCopyOfRecord(const FlashLFSIndexRecord *record, uint32_t crc, unsigned srcAddress, unsigned volLimit);
 };
 
 
@@ -653,10 +668,21 @@ public:
     static FlashLFS &get(FlashVolume parent);
     static void invalidate();
 
+    /*
+     * Idle-time garbage collection on cached filesystems. The heartbeat
+     * allows one incremental step per second, and Tasks::idle() runs it
+     * unless the caller excluded Tasks::FlashIdle. Copying live objects
+     * may allocate a volume, and so wait for an erase.
+     */
+    static void heartbeat();
+    static bool idle();
+
     static FlashLFS instances[SIZE];
 
 private:
     static uint8_t lastUsed;
+    static uint8_t heartbeatDivider;
+    static bool gcAllowed;
 };
 
 
@@ -668,7 +694,13 @@ private:
 class FlashLFSObjectAllocator
 {
 public:
-    FlashLFSObjectAllocator(FlashLFS &lfs, unsigned key, unsigned size, unsigned crc);
+    /*
+     * Normally each allocation commits its own index record. To batch several
+     * allocations into a single index block write, pass the same 'indexWriter'
+     * to each allocator. The caller commits it when the batch is complete.
+     */
+    FlashLFSObjectAllocator(FlashLFS &lfs, unsigned key, unsigned size, unsigned crc,
+        FlashBlockWriter *indexWriter = 0);
 
     // Perform the actual allocation. Writes to flash, etc.
     // By default, uses only MAX_OBJ_VOLUMES, leaving our padding available for GC use.
@@ -687,6 +719,7 @@ private:
     const unsigned key;     // IN
     const unsigned size;    // IN
     const unsigned crc;     // IN
+    FlashBlockWriter *indexWriter;  // IN, optional
     unsigned addr;          // OUT
 
     bool allocInVolume(FlashVolume vol);
@@ -24,6 +24,11 @@
  */
 
 #include "flash_preerase.h"
+#include "usbvolumemanager.h"
+#include "tasks.h"
+
+unsigned FlashBlockPreEraser::budget;
+unsigned FlashBlockPreEraser::heartbeatDivider;
 
 
 // Tell our FlashBlockRecycler not to use the erase log
@@ -50,3 +55,43 @@ bool FlashBlockPreEraser::next()
     log.commit(r);
     return true;
 }
+
+void FlashBlockPreEraser::heartbeat()
+{
+    // Unused budget doesn't accumulate past one second's worth
+    if (++heartbeatDivider >= Tasks::HEARTBEAT_HZ) {
+        heartbeatDivider = 0;
+        budget = ERASES_PER_SECOND;
+    }
+}
+
+bool FlashBlockPreEraser::idle()
+{
+    /*
+     * This is the hot path for every Tasks::idle() with nothing to do,
+     * so bail out quickly if we're out of budget. Once we've found that
+     * the reserve is full, or that we can't make any progress, give up
+     * on the rest of this second's budget so we don't keep re-checking.
+     *
+     * Don't recycle anything while an install is in progress; the volume
+     * being written is still T_INCOMPLETE, and it would look like garbage.
+     */
+
+    if (LIKELY(!budget))
+        return false;
+
+    if (UsbVolumeManager::isInstalling() ||
+        FlashEraseLog::countRecords() >= RESERVE_BLOCKS) {
+        budget = 0;
+        return false;
+    }
+
+    FlashBlockPreEraser bpe;
+    if (!bpe.next()) {
+        budget = 0;
+        return false;
+    }
+
+    budget--;
+    return true;
+}
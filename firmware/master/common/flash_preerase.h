@@ -32,17 +32,50 @@
  * Manages the process of pre-erasing blocks.
  * Callers can erase blocks as long as they have time to kill.
  * Results are immediately committed to the FlashEraseLog.
+ *
+ * Besides the explicit pre-erasing we do at shutdown, the static
+ * idle() hook keeps a small reserve of erased blocks topped up at runtime,
+ * so that allocating a new volume (an LFS volume for saved games, most
+ * importantly) doesn't have to wait for an erase. Erasing one block
+ * means two 64 kB device erases, each typically 1/2 second and at most
+ * one second, so this is rate-limited by a budget that the heartbeat
+ * refills once per second.
  */
 
 class FlashBlockPreEraser {
 public:
+    /// How many pre-erased blocks we try to keep in the erase log
+    static const unsigned RESERVE_BLOCKS = 4;
+
+    /// Maximum number of idle-time erases per second
+    static const unsigned ERASES_PER_SECOND = 1;
+
     FlashBlockPreEraser();
 
     bool next();
 
+    /// Called by the Tasks heartbeat, to refill our erase budget
+    static void heartbeat();
+
+    /**
+     * Called by Tasks::idle() when there is no other work to do.
+     * Erases at most one block, and returns 'true' if we did.
+     *
+     * The erase is synchronous, and the flash driver spins without
+     * running tasks while it completes, so this only runs from idle loops
+     * where no game needs to keep responding: the debugger, and the
+     * no-launcher fault loop. _SYS_yield() and the paint, finish, and
+     * asset loading waits all exclude Tasks::PreErase. Otherwise, the
+     * reserve is topped up at shutdown.
+     */
+    static bool idle();
+
 private:
     FlashEraseLog log;
     FlashBlockRecycler recycler;
+
+    static unsigned budget;
+    static unsigned heartbeatDivider;
 };
 
 
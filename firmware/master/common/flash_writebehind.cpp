@@ -0,0 +1,270 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Thundercracker firmware
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "flash_writebehind.h"
+#include "flash_lfs.h"
+#include "flash_blockcache.h"
+#include "flash_device.h"
+#include "svmmemory.h"
+#include "crc.h"
+#include <sifteo/abi.h>
+
+bool FlashLFSWriteBehind::enabled;
+uint8_t FlashLFSWriteBehind::numEntries;
+uint8_t FlashLFSWriteBehind::age;
+uint16_t FlashLFSWriteBehind::bytesUsed;
+FlashVolume FlashLFSWriteBehind::parent;
+FlashLFSWriteBehind::Entry FlashLFSWriteBehind::entries[MAX_ENTRIES];
+uint8_t FlashLFSWriteBehind::buffer[BUFFER_SIZE];
+int32_t FlashLFSWriteBehind::deferredError;
+FlashVolume FlashLFSWriteBehind::errorParent;
+
+
+void FlashLFSWriteBehind::setEnabled(bool enable)
+{
+    if (!enable)
+        autoFlush();
+    enabled = enable;
+}
+
+void FlashLFSWriteBehind::finish()
+{
+    flush();
+    enabled = false;
+    deferredError = 0;
+}
+
+void FlashLFSWriteBehind::autoFlush()
+{
+    /*
+     * Flush on our own schedule rather than the program's. It never sees
+     * this result directly, so keep any error for takeError(). Only the
+     * most recent one is kept.
+     */
+
+    FlashVolume vol = parent;
+    int32_t result = flush();
+
+    if (result < 0) {
+        deferredError = result;
+        errorParent = vol;
+    }
+}
+
+int32_t FlashLFSWriteBehind::takeError(FlashVolume parent)
+{
+    if (!deferredError || parent.block.code != errorParent.block.code)
+        return 0;
+
+    int32_t result = deferredError;
+    deferredError = 0;
+    return result;
+}
+
+FlashLFSWriteBehind::Entry *FlashLFSWriteBehind::find(FlashVolume parent, unsigned key)
+{
+    if (!numEntries || parent.block.code != FlashLFSWriteBehind::parent.block.code)
+        return 0;
+
+    for (unsigned i = 0; i < numEntries; ++i)
+        if (entries[i].key == key)
+            return &entries[i];
+
+    return 0;
+}
+
+void FlashLFSWriteBehind::remove(Entry *entry)
+{
+    /*
+     * Remove one entry, and close the gap it leaves in the data buffer.
+     * Entries are stored in the same order as their data, so every
+     * entry after this one moves down by the same amount.
+     */
+
+    unsigned index = entry - entries;
+    unsigned size = entry->size;
+    unsigned offset = entry->offset;
+
+    ASSERT(index < numEntries);
+    memmove(buffer + offset, buffer + offset + size, bytesUsed - offset - size);
+    bytesUsed -= size;
+
+    for (unsigned i = index + 1; i < numEntries; ++i) {
+        entries[i - 1] = entries[i];
+        entries[i - 1].offset -= size;
+    }
+    numEntries--;
+}
+
+void FlashLFSWriteBehind::clear()
+{
+    numEntries = 0;
+    bytesUsed = 0;
+    age = 0;
+}
+
+bool FlashLFSWriteBehind::write(FlashVolume parent, unsigned key,
+    const uint8_t *data, unsigned dataSize, int32_t &result)
+{
+    /*
+     * Copy the new data in before removing any older version of this key,
+     * so that a bad address leaves the buffer as it was. The new entry
+     * always goes at the end; remove() then closes up the old entry's gap.
+     */
+
+    if (!enabled || dataSize > BUFFER_SIZE)
+        return false;
+
+    // Only one parent volume at a time; normally this is the running program
+    if (numEntries && parent.block.code != FlashLFSWriteBehind::parent.block.code)
+        autoFlush();
+
+    if (numEntries == MAX_ENTRIES || bytesUsed + dataSize > BUFFER_SIZE)
+        autoFlush();
+
+    FlashBlockRef ref;
+    if (!SvmMemory::copyROData(ref, buffer + bytesUsed,
+            reinterpret_cast<SvmMemory::VirtAddr>(data), dataSize)) {
+        result = _SYS_EFAULT;
+        return true;
+    }
+
+    Entry *existing = find(parent, key);
+
+    Entry &e = entries[numEntries++];
+    e.key = key;
+    e.offset = bytesUsed;
+    e.size = dataSize;
+    bytesUsed += dataSize;
+    FlashLFSWriteBehind::parent = parent;
+
+    if (existing)
+        remove(existing);
+
+    result = dataSize;
+    return true;
+}
+
+bool FlashLFSWriteBehind::read(FlashVolume parent, unsigned key,
+    uint8_t *dest, unsigned destSize, int32_t &result)
+{
+    /*
+     * Reading from flash returns the object padded out to SIZE_UNIT with
+     * 0xFF bytes, truncated to the caller's buffer. The read only succeeds
+     * if the truncated part was all padding; otherwise the CRC check fails
+     * and we fall back to older versions of the object. Do the same here.
+     */
+
+    Entry *e = find(parent, key);
+    if (!e)
+        return false;
+
+    const uint8_t *src = buffer + e->offset;
+    unsigned size = e->size;
+    unsigned paddedSize = roundup<FlashLFSIndexRecord::SIZE_UNIT>(size);
+
+    if (destSize < paddedSize) {
+        // Truncated reads must still cover the last allocation unit
+        if (roundup<FlashLFSIndexRecord::SIZE_UNIT>(destSize) != paddedSize)
+            return false;
+        for (unsigned i = destSize; i < size; ++i)
+            if (src[i] != 0xFF)
+                return false;
+    }
+
+    unsigned count = MIN(size, destSize);
+    result = MIN(paddedSize, destSize);
+
+    memcpy(dest, src, count);
+    memset(dest + count, 0xFF, result - count);
+    return true;
+}
+
+void FlashLFSWriteBehind::discard(FlashVolume parent, unsigned key)
+{
+    Entry *e = find(parent, key);
+    if (e)
+        remove(e);
+}
+
+int32_t FlashLFSWriteBehind::flush()
+{
+    /*
+     * Allocate and write each buffered object. All of the allocators share
+     * one index block writer, so consecutive records in the same index
+     * block are committed with a single write after their data is in place.
+     */
+
+    if (!numEntries)
+        return 0;
+
+    // If our volume was deleted out from under us, there's nowhere to write.
+    if (FlashVolume::typeIsRecyclable(parent.getType())) {
+        clear();
+        return _SYS_ENOENT;
+    }
+
+    FlashLFS &lfs = FlashLFSCache::get(parent);
+    FlashBlockWriter indexWriter;
+    int32_t result = 0;
+
+    for (unsigned i = 0; i < numEntries; ++i) {
+        const Entry &e = entries[i];
+        const uint8_t *data = buffer + e.offset;
+
+        CrcStream cs;
+        cs.reset();
+        cs.addBytes(data, e.size);
+        uint32_t crc = cs.get(FlashLFSIndexRecord::SIZE_UNIT);
+
+        FlashLFSObjectAllocator allocator(lfs, e.key, e.size, crc, &indexWriter);
+        if (!allocator.allocateAndCollectGarbage()) {
+            result = _SYS_ENOSPC;
+            continue;
+        }
+
+        FlashDevice::write(allocator.address(), data, e.size);
+        FlashBlock::invalidate(allocator.address(), allocator.address() + e.size);
+    }
+
+    indexWriter.commitBlock();
+    clear();
+    return result;
+}
+
+void FlashLFSWriteBehind::heartbeat()
+{
+    if (numEntries && age < FLUSH_DELAY)
+        age++;
+}
+
+bool FlashLFSWriteBehind::idle()
+{
+    if (LIKELY(age < FLUSH_DELAY))
+        return false;
+
+    autoFlush();
+    return true;
+}
@@ -0,0 +1,141 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Thundercracker firmware
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Optional write-behind buffering for LFS object writes.
+ *
+ * Normally every _SYS_fs_objectWrite() allocates and commits its object
+ * synchronously. Programs that opt in via _SYS_fs_setWriteBehind() have
+ * their small writes held in RAM instead. Repeated writes to the same key
+ * replace each other in the buffer, and when we do flush, all buffered
+ * objects share a single index block commit where possible.
+ *
+ * The buffer is flushed explicitly with _SYS_fs_flush(), a short while
+ * after the first buffered write once the system is idle, before any
+ * exec or exit, and at shutdown. Reads from the running program see
+ * buffered objects, so the buffer is invisible other than its timing.
+ * Like a power failure during a synchronous write, anything still
+ * buffered if power is lost will read back as the previous version.
+ *
+ * If a flush the program didn't ask for fails, we hold on to the error
+ * and report it from the program's next _SYS_fs_flush() or object write.
+ */
+
+#ifndef FLASH_WRITEBEHIND_H_
+#define FLASH_WRITEBEHIND_H_
+
+#include "macros.h"
+#include "flash_volume.h"
+#include "tasks.h"
+
+
+class FlashLFSWriteBehind
+{
+public:
+    /// Bytes of object data we can hold. Larger objects are written through.
+    static const unsigned BUFFER_SIZE = 512;
+    static const unsigned MAX_ENTRIES = 16;
+
+    /// Heartbeats after the first buffered write before an idle flush
+    static const unsigned FLUSH_DELAY = Tasks::HEARTBEAT_HZ;
+
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    /// Enable or disable buffering. Disabling flushes anything pending.
+    static void setEnabled(bool enable);
+
+    /**
+     * Flush and disable buffering, for a program which is exiting. Any
+     * errors are dropped, since there's nobody left to report them to.
+     */
+    static void finish();
+
+    /**
+     * Try to buffer a write from userspace memory. Returns false if the
+     * caller should write through instead. Otherwise, 'result' holds the
+     * syscall's return value. On a bad address it's _SYS_EFAULT, and the
+     * buffer is unchanged.
+     */
+    static bool write(FlashVolume parent, unsigned key,
+        const uint8_t *data, unsigned dataSize, int32_t &result);
+
+    /**
+     * Look for a buffered copy of 'key'. Returns true and sets 'result'
+     * if the read was satisfied from the buffer, following the same
+     * truncation rules as reading the object back from flash.
+     */
+    static bool read(FlashVolume parent, unsigned key,
+        uint8_t *buffer, unsigned bufferSize, int32_t &result);
+
+    /// Forget any buffered copy of 'key', which is about to be written through
+    static void discard(FlashVolume parent, unsigned key);
+
+    /// Write everything to flash. Returns 0 or a negative _SYS error code.
+    static int32_t flush();
+
+    /**
+     * Return and forget the error from an earlier automatic flush of
+     * objects belonging to 'parent'. Returns 0 if there was none.
+     */
+    static int32_t takeError(FlashVolume parent);
+
+    /// Called by the Tasks heartbeat, to age the buffer
+    static void heartbeat();
+
+    /**
+     * Called by Tasks::idle(), unless the caller excluded Tasks::FlashIdle.
+     * A flush may need a new volume, and so wait for an erase. Returns
+     * true if we did any work.
+     */
+    static bool idle();
+
+private:
+    struct Entry {
+        uint8_t key;
+        uint16_t offset;
+        uint16_t size;
+    };
+
+    static bool enabled;
+    static uint8_t numEntries;
+    static uint8_t age;
+    static uint16_t bytesUsed;
+    static FlashVolume parent;
+    static Entry entries[MAX_ENTRIES];
+    static uint8_t buffer[BUFFER_SIZE];
+
+    static int32_t deferredError;
+    static FlashVolume errorParent;
+
+    static void autoFlush();
+    static Entry *find(FlashVolume parent, unsigned key);
+    static void remove(Entry *entry);
+    static void clear();
+};
+
+
+#endif
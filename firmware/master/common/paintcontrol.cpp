@@ -171,7 +171,8 @@ void PaintControl::waitForPaint(CubeSlot *cube, uint32_t excludedTasks)
         if (now > paintTimestamp + fpsHigh && pendingFrames <= fpMax)
             break;
 
-        Tasks::idle(excludedTasks);
+        // Never stall a frame behind a flash erase
+        Tasks::idle(excludedTasks | Tasks::eraseLatencyTasks());
     }
 
     /*
@@ -440,8 +441,21 @@ bool PaintControl::vramFlushed(CubeSlot *cube)
             // Should never have SYNC_ACK set when in CONTINUOUS mode.
             ASSERT(!vf.test(_SYS_VF_CONTINUOUS));
 
+            bool uncond = (vbuf->flags & _SYS_VBF_UNCOND_TOGGLE) != 0;
             setToggle(cube, vbuf, vf, now);
 
+            /*
+             * If this produces a toggle edge, the previous frame has been
+             * acknowledged and it's safe to pick a new window. Unconditional
+             * toggles make no such promise.
+             */
+            if (vf.pending()) {
+                if (uncond)
+                    window.beginUntrackedFrame(vbuf);
+                else
+                    window.beginFrame(vbuf);
+            }
+
         } else {
             /*
              * We're getting ahead of the cube. We'd like to trigger now, but
@@ -468,7 +482,8 @@ bool PaintControl::vramFlushed(CubeSlot *cube)
 bool PaintControl::allowContinuous(CubeSlot *cube)
 {
     // Conserve cube CPU time during asset loading; don't use continuous rendering.
-    return 0 == (cube->bit() & AssetLoader::getActiveCubes());
+    // Prefetching doesn't count, it only uses leftover radio bandwidth anyway.
+    return 0 == (cube->bit() & AssetLoader::getActiveCubes() & ~AssetLoader::getPrefetchCubes());
 }
 
 void PaintControl::enterContinuous(CubeSlot *cube, _SYSVideoBuffer *vbuf,
@@ -485,6 +500,9 @@ void PaintControl::enterContinuous(CubeSlot *cube, _SYSVideoBuffer *vbuf,
     // For now, we may be async even if the ACK byte does not indicate continuous rendering
     asyncTimestamp = timestamp;
 
+    // We can't predict which VRAM updates each of these frames will see
+    window.beginUntrackedFrame(vbuf);
+
     if (allowed) {
         flags.set(_SYS_VF_CONTINUOUS);
     } else {
@@ -567,3 +585,219 @@ bool VRAMFlags::apply(_SYSVideoBuffer *vbuf)
 
     return false;
 }
+
+void PaintWindow::beginFrame(_SYSVideoBuffer *vbuf)
+{
+    /*
+     * Pick the window for a frame we're about to trigger. At this point
+     * VRAM has been fully flushed, so the VideoBuffer matches the cube,
+     * and every word we've sent since the last tracked frame was
+     * accounted for in dirtyLines.
+     */
+
+    if (!(vbuf->flags & _SYS_VBF_AUTO_WINDOW)) {
+        // Not enabled, or recently disabled. Put back the default window.
+        if (shrunk)
+            setLines(vbuf, LCD_LINES);
+        tracking = false;
+        return;
+    }
+
+    uint8_t mode = VRAM::peekb(*vbuf, offsetof(_SYSVideoRAM, mode));
+    uint8_t flags = VRAM::peekb(*vbuf, offsetof(_SYSVideoRAM, flags)) & GLOBAL_FLAGS;
+
+    unsigned numLines;
+    if (tracking && mode == lastMode && flags == lastFlags) {
+        // Must draw at least one line to get a frame ACK
+        numLines = MAX(1, dirtyLines);
+    } else {
+        numLines = LCD_LINES;
+    }
+
+    setLines(vbuf, numLines);
+
+    lastMode = mode;
+    lastFlags = flags;
+    captureSprites(vbuf);
+    dirtyLines = 0;
+    tracking = isModeSupported(mode);
+}
+
+void PaintWindow::beginUntrackedFrame(_SYSVideoBuffer *vbuf)
+{
+    // Growing the window is always safe, so we can do this at any time.
+    if (shrunk)
+        setLines(vbuf, LCD_LINES);
+    tracking = false;
+}
+
+void PaintWindow::setLines(_SYSVideoBuffer *vbuf, unsigned numLines)
+{
+    ASSERT(numLines >= 1 && numLines <= LCD_LINES);
+
+    // The first_line/num_lines word comes before flags, so the codec
+    // always delivers it ahead of the toggle bit that starts the frame.
+    const uint16_t addr = offsetof(_SYSVideoRAM, first_line) / 2;
+    STATIC_ASSERT(offsetof(_SYSVideoRAM, first_line) < offsetof(_SYSVideoRAM, flags));
+
+    // Lock flags = 0, don't mark the "needs paint" flag.
+    VRAM::poke(*vbuf, addr, numLines << 8, 0);
+    VRAM::unlock(*vbuf);
+
+    shrunk = numLines != LCD_LINES;
+}
+
+void PaintWindow::captureSprites(const _SYSVideoBuffer *vbuf)
+{
+    for (unsigned i = 0; i != _SYS_VRAM_SPRITES; ++i) {
+        sprMaskY[i] = vbuf->vram.spr[i].mask_y;
+        sprPosY[i] = vbuf->vram.spr[i].pos_y;
+    }
+}
+
+bool PaintWindow::isModeSupported(uint8_t mode)
+{
+    switch (mode & _SYS_VM_MASK) {
+        case _SYS_VM_BG0:
+        case _SYS_VM_BG0_BG1:
+        case _SYS_VM_BG0_SPR_BG1:
+        case _SYS_VM_BG2:
+            return true;
+        default:
+            return false;
+    }
+}
+
+unsigned PaintWindow::linesCovering(unsigned top, unsigned height, unsigned wrap)
+{
+    /*
+     * How many lines, starting at the top of the display, do we need
+     * in order to cover 'height' lines starting at 'top', on a layer
+     * which wraps around every 'wrap' lines?
+     */
+
+    ASSERT(top < wrap);
+    ASSERT(wrap >= LCD_LINES);
+
+    if (height == 0)
+        return 0;
+
+    unsigned bottom = top + height - 1;
+
+    if (bottom >= wrap) {
+        if (top < LCD_LINES)
+            return LCD_LINES;
+        bottom -= wrap;
+    } else if (top >= LCD_LINES) {
+        return 0;
+    }
+
+    return MIN(bottom, LCD_LINES - 1) + 1;
+}
+
+unsigned PaintWindow::spriteLines(int8_t maskY, int8_t posY)
+{
+    // Sprite sizes and positions are both stored negated, wrapping at 8 bits.
+    return linesCovering(uint8_t(-posY), uint8_t(-maskY), 256);
+}
+
+void PaintWindow::markWord(const _SYSVideoBuffer *vbuf, uint16_t addr)
+{
+    /*
+     * Account for one VRAM word on its way to the cube. Only called while
+     * tracking, so lastMode is one of the isModeSupported() modes.
+     *
+     * We have access to the new value of this word, and to the current
+     * values of everything else, but not to the old value of this word.
+     * Anything that can move pixels around requires either a shadow copy
+     * (sprites) or a full redraw (panning, BG1 bitmap, affine transform).
+     */
+
+    const _SYSVideoRAM &vram = vbuf->vram;
+    const uint8_t mode = lastMode & _SYS_VM_MASK;
+
+    const unsigned bg0Words = _SYS_VRAM_BG0_WIDTH * _SYS_VRAM_BG0_WIDTH;
+    const unsigned bg1TileFirst = _SYS_VA_BG1_TILES / 2;
+    const unsigned bg1TileLast = bg1TileFirst + _SYS_VRAM_BG1_TILES - 1;
+    const unsigned sprFirst = _SYS_VA_SPR / 2;
+    const unsigned sprLast = sprFirst + _SYS_VRAM_SPRITES * sizeof(_SYSSpriteInfo) / 2 - 1;
+    const unsigned windowAddr = _SYS_VA_FIRST_LINE / 2;
+    const unsigned flagsAddr = _SYS_VA_FLAGS / 2;
+
+    // Owned by us, and checked when the next frame begins.
+    if (addr == windowAddr || addr == flagsAddr)
+        return;
+
+    if (mode == _SYS_VM_BG2) {
+        const unsigned bg2Words = _SYS_VRAM_BG2_WIDTH * _SYS_VRAM_BG2_WIDTH;
+
+        if (addr < bg2Words) {
+            /*
+             * We can handle transforms with no rotation or shear, where the
+             * Y accumulator is monotonic and never wraps past the border.
+             */
+
+            const _SYSAffine &a = vram.bg2_affine;
+            int32_t cy = a.cy;
+            int32_t yEnd = cy + int32_t(a.yy) * int32_t(LCD_LINES - 1);
+
+            if (a.xy == 0 && a.yy > 0 && yEnd < 0x8000) {
+                int32_t rowEnd = int32_t((addr / _SYS_VRAM_BG2_WIDTH) + 1) << (3 + 8);
+                int32_t lines = (rowEnd - cy + a.yy - 1) / a.yy;
+                if (lines > 0)
+                    markLines(lines);
+                return;
+            }
+        }
+
+        markLines(LCD_LINES);
+        return;
+    }
+
+    // All remaining modes include BG0
+
+    if (addr < bg0Words) {
+        unsigned panY = vram.bg0_y;
+        unsigned wrap = _SYS_VRAM_BG0_WIDTH * 8;
+        unsigned row = (addr / _SYS_VRAM_BG0_WIDTH) * 8;
+
+        if (panY < wrap) {
+            markLines(linesCovering((row + wrap - panY) % wrap, 8, wrap));
+            return;
+        }
+    }
+
+    if (mode != _SYS_VM_BG0 && addr >= bg1TileFirst && addr <= bg1TileLast) {
+        // Find this tile's row in the BG1 allocation bitmap
+
+        unsigned index = addr - bg1TileFirst;
+        for (unsigned y = 0; y != _SYS_VRAM_BG1_WIDTH; ++y) {
+            unsigned count = Intrinsic::POPCOUNT(vram.bg1_bitmap[y]);
+            if (index < count) {
+                unsigned top = uint8_t((y << 3) - vram.bg1_y);
+                markLines(linesCovering(top, 8, 256));
+                return;
+            }
+            index -= count;
+        }
+
+        // Not mapped to any location; invisible.
+        return;
+    }
+
+    if (mode == _SYS_VM_BG0_SPR_BG1 && addr >= sprFirst && addr <= sprLast) {
+        // Redraw both the old and the new location
+
+        unsigned id = (addr - sprFirst) / (sizeof(_SYSSpriteInfo) / 2);
+        const _SYSSpriteInfo &spr = vram.spr[id];
+
+        markLines(spriteLines(sprMaskY[id], sprPosY[id]));
+        markLines(spriteLines(spr.mask_y, spr.pos_y));
+
+        sprMaskY[id] = spr.mask_y;
+        sprPosY[id] = spr.pos_y;
+        return;
+    }
+
+    markLines(LCD_LINES);
+}
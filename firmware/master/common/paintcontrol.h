@@ -59,10 +59,80 @@ struct VRAMFlags {
             clear(flags);
     }
 
+    // Will apply() send any changes?
+    bool pending() const { return vf != vfPrev; }
+
     bool apply(_SYSVideoBuffer *vbuf);
 };
 
 
+/**
+ * Automatic drawing window, for VideoBuffers with _SYS_VBF_AUTO_WINDOW set.
+ *
+ * We look at every VRAM word as the codec sends it to the cube, and keep a
+ * conservative count of scanlines, starting at the top of the display, which
+ * may no longer match what's on the LCD. When PaintControl triggers a new
+ * frame, the window is shrunk to cover only those lines.
+ *
+ * The cube's renderer always begins drawing at the top of each layer, and it
+ * uses 'first_line' only to position its output on the LCD. A window starting
+ * anywhere but line zero would require adjusting every layer's panning too,
+ * and we'd rather not touch VRAM that userspace can see, other than the
+ * window itself. So we only ever reduce 'num_lines'.
+ *
+ * Any time we can't prove that a partial frame is safe, we go back to
+ * drawing the full screen.
+ */
+
+class PaintWindow {
+ public:
+    // Next frame must be drawn in full (Any context)
+    void invalidate() {
+        tracking = false;
+    }
+
+    // Codec is sending one word to the cube (ISR context)
+    ALWAYS_INLINE void wordEncoded(const _SYSVideoBuffer *vbuf, uint16_t addr) {
+        if (tracking && dirtyLines < LCD_LINES)
+            markWord(vbuf, addr);
+    }
+
+    // About to send a toggle edge which begins a new frame
+    void beginFrame(_SYSVideoBuffer *vbuf);
+
+    // About to render in a way that we can't track, like CONTINUOUS mode
+    void beginUntrackedFrame(_SYSVideoBuffer *vbuf);
+
+ private:
+    static const unsigned LCD_LINES = 128;
+
+    // Flag bits that affect the contents of every scanline
+    static const uint8_t GLOBAL_FLAGS = _SYS_VF_A21 | _SYS_VF_XY_SWAP |
+                                        _SYS_VF_X_FLIP | _SYS_VF_Y_FLIP;
+
+    bool tracking;                      // Is dirtyLines meaningful?
+    bool shrunk;                        // Have we left a partial window in VRAM?
+    uint8_t dirtyLines;                 // Lines from the top needing a redraw
+    uint8_t lastMode;                   // Mode for the last tracked frame
+    uint8_t lastFlags;                  // GLOBAL_FLAGS for the last tracked frame
+    int8_t sprMaskY[_SYS_VRAM_SPRITES]; // Shadow copy of sprite Y state on the cube
+    int8_t sprPosY[_SYS_VRAM_SPRITES];
+
+    static bool isModeSupported(uint8_t mode);
+    static unsigned linesCovering(unsigned top, unsigned height, unsigned wrap);
+    static unsigned spriteLines(int8_t maskY, int8_t posY);
+
+    void markWord(const _SYSVideoBuffer *vbuf, uint16_t addr);
+    void markLines(unsigned count) {
+        if (count > dirtyLines)
+            dirtyLines = MIN(count, LCD_LINES);
+    }
+
+    void captureSprites(const _SYSVideoBuffer *vbuf);
+    void setLines(_SYSVideoBuffer *vbuf, unsigned numLines);
+};
+
+
 /**
  * Paint controller for one cube. This manages frame rate control, frame
  * triggering, and tracking rendering-finished state.
@@ -85,10 +155,15 @@ class PaintControl {
     void ackFrames(CubeSlot *cube, int32_t count);
     bool vramFlushed(CubeSlot *cube);
 
+    ALWAYS_INLINE PaintWindow &getWindow() {
+        return window;
+    }
+
  private:
     SysTime::Ticks paintTimestamp;      // Last user call to _SYS_paint()
     SysTime::Ticks asyncTimestamp;      // TOGGLE, TRIGGER_ON_FLUSH, entering CONTINUOUS mode
     int32_t pendingFrames;
+    PaintWindow window;
 
     static bool allowContinuous(CubeSlot *cube);
     void enterContinuous(CubeSlot *cube, _SYSVideoBuffer *vbuf,
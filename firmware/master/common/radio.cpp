@@ -39,6 +39,8 @@
 uint8_t RadioManager::currentProducer;
 bool RadioManager::enabled;
 uint8_t RadioManager::nextPID;
+uint8_t RadioManager::burstProducer = RadioManager::DUMMY_ID;
+uint8_t RadioManager::burstCount;
 uint32_t RadioManager::schedule[RadioManager::PID_COUNT];
 uint32_t RadioManager::nextSchedule[RadioManager::PID_COUNT];
 _SYSPseudoRandomState RadioManager::prngISR;
@@ -102,6 +104,9 @@ void RadioManager::produce(PacketTransmission &tx)
     const uint32_t activeMask = CubeSlots::sysConnected | Intrinsic::LZ(CONNECTOR_ID);
     const SysTime::Ticks now = SysTime::ticks();
 
+    if (burstProducer != DUMMY_ID && produceBurst(tx, now))
+        return;
+
     for (;;) {
 
         /*
@@ -201,6 +206,8 @@ void RadioManager::produce(PacketTransmission &tx)
             nextSchedule[thisPID] |= producerBit;
             nextPID = (thisPID + 1) & PID_MASK;
             currentProducer = producer;
+            burstCount = 0;
+            updateBurst(producer, tx);
             return;
         }
 
@@ -209,6 +216,61 @@ void RadioManager::produce(PacketTransmission &tx)
     }
 }
 
+bool RadioManager::produceBurst(PacketTransmission &tx, SysTime::Ticks now)
+{
+    /*
+     * The last producer asked to keep the radio. If nobody else could
+     * possibly want it, give that producer another packet without going
+     * through the round-robin schedule. Returns false if the burst is over.
+     */
+
+    unsigned producer = burstProducer;
+    burstProducer = DUMMY_ID;
+
+    ASSERT(producer < CONNECTOR_ID);
+    uint32_t producerBit = Intrinsic::LZ(producer);
+
+    if (burstCount >= MAX_BURST_PACKETS || !(CubeSlots::sysConnected & producerBit))
+        return false;
+
+    // Are all other cubes asleep?
+    uint32_t others = CubeSlots::sysConnected & ~producerBit;
+    while (others) {
+        unsigned id = Intrinsic::CLZ(others);
+        others ^= Intrinsic::LZ(id);
+        if (!CubeSlot::getInstance(id).isNapping(now))
+            return false;
+    }
+
+    if (!dispatchProduce(producer, tx, now))
+        return false;
+
+    /*
+     * Move the producer to the queue for its new PID, and take it out of
+     * the current round-robin cycle. It just had its turn.
+     */
+
+    unsigned thisPID = nextPID;
+    for (unsigned i = 0; i < PID_COUNT; ++i) {
+        schedule[i] &= ~producerBit;
+        nextSchedule[i] &= ~producerBit;
+    }
+    nextSchedule[thisPID] |= producerBit;
+    nextPID = (thisPID + 1) & PID_MASK;
+    currentProducer = producer;
+
+    burstCount++;
+    updateBurst(producer, tx);
+    return true;
+}
+
+ALWAYS_INLINE void RadioManager::updateBurst(unsigned producer, const PacketTransmission &tx)
+{
+    // Only cubes can burst; the CubeConnector always wants the radio.
+    if (tx.burst && producer < CONNECTOR_ID)
+        burstProducer = producer;
+}
+
 void RadioManager::ackWithPacket(const PacketBuffer &packet, unsigned retries)
 {
 //    dispatchAcknowledge(currentProducer, packet, retries);
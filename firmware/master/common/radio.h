@@ -129,6 +129,7 @@ struct PacketTransmission {
     const RadioAddress *dest;
 
     bool noAck;
+    bool burst;     // Producer has more to send right away, and would like to keep the radio
     uint8_t numHardwareRetries;
     uint8_t numSoftwareRetries;
     uint8_t txPower;
@@ -147,6 +148,7 @@ struct PacketTransmission {
 
     ALWAYS_INLINE void init() {
         noAck = 0;
+        burst = 0;
         numHardwareRetries = DEFAULT_HARDWARE_RETRIES;
         numSoftwareRetries = DEFAULT_SOFTWARE_RETRIES;
         txPower = DEFAULT_TX_POWER;
@@ -275,6 +277,24 @@ class RadioManager {
 
     static bool enabled;
 
+    /*
+     * Burst mode. A producer which is streaming bulk data (the asset
+     * loader) can ask to keep the radio for its next packet, by setting
+     * 'burst' on its PacketTransmission. We grant this for a limited number
+     * of consecutive packets, and only while every other cube is napping.
+     * The CubeConnector and everyone else get their normal round-robin
+     * turn when the burst ends.
+     *
+     * A burst never causes a PID collision: the same receiver sees
+     * consecutive PIDs, and we move it to the right schedule queue after.
+     *
+     * Accessed ONLY in interrupt context.
+     */
+
+    static const unsigned MAX_BURST_PACKETS = 8;
+    static uint8_t burstProducer;
+    static uint8_t burstCount;
+
     static const unsigned CHANNEL_HOP_THRESHOLD = 5 * PacketTransmission::DEFAULT_HARDWARE_RETRIES;
 
     // ID for the CubeConnector. Must not collide with any CubeSlot ID.
@@ -299,6 +319,9 @@ class RadioManager {
     
     // Dispatch to a paritcular producer, by ID
     static ALWAYS_INLINE bool dispatchProduce(unsigned id, PacketTransmission &tx, SysTime::Ticks now);
+
+    static bool produceBurst(PacketTransmission &tx, SysTime::Ticks now);
+    static ALWAYS_INLINE void updateBurst(unsigned producer, const PacketTransmission &tx);
 };
 
 #endif
@@ -32,6 +32,7 @@
 #include "cubeslots.h"
 #include "cubeconnector.h"
 #include "flash_preerase.h"
+#include "flash_writebehind.h"
 #include "idletimeout.h"
 
 #ifndef SIFTEO_SIMULATOR
@@ -47,6 +48,9 @@ void ShutdownManager::shutdown()
 {
     LOG(("SHUTDOWN: Beginning shutdown sequence\n"));
 
+    // Don't leave any saved game data behind in RAM
+    FlashLFSWriteBehind::flush();
+
     // First round of shut down. We'll appear to be off.
     LED::set(NULL);
     CubeSlots::setCubeRange(0, 0);
@@ -177,6 +177,7 @@ namespace Debugger {
         M_DETACH            = 0x07000000,  // [] -> []
         M_SET_BREAKPOINTS   = 0x08000000,  // arg=bitmap, [addresses] -> []
         M_STEP              = 0x09000000,  // [] -> []
+        M_SET_WATCHPOINTS   = 0x0A000000,  // arg=bitmap, [address, type|length ...] -> [bitmap]
     };
 
     /*
@@ -218,6 +219,27 @@ namespace Debugger {
     const uint32_t NUM_BREAKPOINTS = 8;
     const uint32_t ALL_BREAKPOINT_BITS = 0x00ff0000;
 
+    /*
+     * Data watchpoints are set much like breakpoints, but each slot takes
+     * two words: a RAM address, and a length in bytes OR'ed with one of the
+     * WatchTypes below. A type of W_NONE disables the slot. The reply is a
+     * bitmap of the slots that were accepted.
+     *
+     * After a watchpoint stops the target, M_IS_STOPPED replies with two
+     * extra words: the type of access, and the address it was made to.
+     */
+    const uint32_t NUM_WATCHPOINTS = 4;
+    const uint32_t ALL_WATCHPOINT_BITS = 0x00f00000;
+    const uint32_t WATCH_LENGTH_MASK = 0x0000ffff;
+
+    enum WatchTypes {
+        W_NONE      = 0x00000000,
+        W_WRITE     = 0x00010000,
+        W_READ      = 0x00020000,
+        W_ACCESS    = 0x00030000,
+        W_TYPE_MASK = 0x00030000,
+    };
+
     /*
      * UNIX-style signal names, used to keep track of the reason why the
      * debugger has stopped the process.
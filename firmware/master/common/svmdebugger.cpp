@@ -87,6 +87,7 @@ bool SvmDebugger::signal(Svm::Debugger::Signals sig)
 
     // Any signal (including breakpoints) will clear our single-step breakpoint
     instance.setStepBreakpoint(0);
+    instance.watchHitType = W_NONE;
 
     // Make sure the debugger event loop will run, and tell it to stop/run.
     instance.stopped = sig;
@@ -145,6 +146,7 @@ void SvmDebugger::handleMessage(SvmDebugPipe::DebuggerMsg &msg)
         case M_DETACH:              return msgDetach(msg);
         case M_SET_BREAKPOINTS:     return msgSetBreakpoints(msg);
         case M_STEP:                return msgStep(msg);
+        case M_SET_WATCHPOINTS:     return msgSetWatchpoints(msg);
     }
 
     LOG((LOG_PREFIX "Unhandled command 0x%08x\n", msg.cmd[0]));
@@ -299,6 +301,11 @@ void SvmDebugger::msgIsStopped(SvmDebugPipe::DebuggerMsg &msg)
 {
     msg.replyWords = 1;
     msg.reply[0] = stopped;
+
+    if (stopped && watchHitType != W_NONE) {
+        msg.reply[msg.replyWords++] = watchHitType;
+        msg.reply[msg.replyWords++] = watchHitAddr;
+    }
 }
 
 void SvmDebugger::msgDetach(SvmDebugPipe::DebuggerMsg &msg)
@@ -306,6 +313,7 @@ void SvmDebugger::msgDetach(SvmDebugPipe::DebuggerMsg &msg)
     // Clear all breakpoints
     memset(breakpoints, 0, sizeof breakpoints);
     breakpointsChanged();
+    watchpointMap = 0;
 
     // Run!
     attached = false;
@@ -472,3 +480,109 @@ void SvmDebugger::msgStep(SvmDebugPipe::DebuggerMsg &msg)
     // All other 16-bit native instructions don't modify control flow.
     return setStepBreakpoint(pc + 2);
 }
+
+void SvmDebugger::msgSetWatchpoints(SvmDebugPipe::DebuggerMsg &msg)
+{
+    /*
+     * Change any number of data watchpoints, specifying the affected
+     * slots using a bitmap. Each watchpoint is translated to a physical
+     * RAM range up front, so the check on each load and store is cheap.
+     *
+     * Watchpoints are only checked by the simulator's SvmCpu. Hardware
+     * could use the DWT comparators, but for now it accepts no
+     * watchpoints, so the debugger knows to report an error.
+     */
+
+    uint32_t bitmap = (msg.cmd[0] & M_ARG_MASK) << BITMAP_SHIFT;
+    uint32_t accepted = 0;
+    uint32_t word = 1;
+
+    while (bitmap && word + 1 < msg.cmdWords) {
+        unsigned i = Intrinsic::CLZ(bitmap);
+        bitmap &= ~Intrinsic::LZ(i);
+
+        if (i >= NUM_WATCHPOINTS)
+            break;
+
+        SvmMemory::VirtAddr va = msg.cmd[word++];
+        uint32_t arg = msg.cmd[word++];
+        uint32_t length = arg & WATCH_LENGTH_MASK;
+        uint32_t type = arg & W_TYPE_MASK;
+        Watchpoint &wp = watchpoints[i];
+
+        watchpointMap &= ~Intrinsic::LZ(i);
+        if (type == W_NONE) {
+            accepted |= argBit(i);
+            continue;
+        }
+
+        #ifdef SIFTEO_SIMULATOR
+            SvmMemory::PhysAddr pa;
+            if (length && SvmMemory::mapRAM(va, length, pa)) {
+                wp.begin = reinterpret_cast<uintptr_t>(pa);
+                wp.end = wp.begin + length;
+                wp.type = type;
+                watchpointMap |= Intrinsic::LZ(i);
+                accepted |= argBit(i);
+            }
+        #else
+            (void) va;
+            (void) length;
+            (void) wp;
+        #endif
+    }
+
+    // Changing watchpoints always forgets about the last hit
+    watchResumePC = 0;
+
+    msg.replyWords = 1;
+    msg.reply[0] = accepted;
+}
+
+#ifdef SIFTEO_SIMULATOR
+
+bool SvmDebugger::isWatched(uintptr_t pc, uintptr_t addr, unsigned bytes,
+    Svm::Debugger::WatchTypes type)
+{
+    if (pc == instance.watchResumePC) {
+        instance.watchResumePC = 0;
+        return false;
+    }
+
+    uint32_t bitmap = instance.watchpointMap;
+    while (bitmap) {
+        unsigned i = Intrinsic::CLZ(bitmap);
+        bitmap &= ~Intrinsic::LZ(i);
+        Watchpoint &wp = instance.watchpoints[i];
+
+        if ((wp.type & type) && addr < wp.end && addr + bytes > wp.begin) {
+            instance.watchResumePC = pc;
+            instance.watchHitType = type;
+            instance.watchHitAddr = SvmMemory::physToVirtRAM(addr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SvmDebugger::watchpoint()
+{
+    /*
+     * Like SvmRuntime::breakpoint(), we're in exception context with the
+     * PC pointing at the instruction to report. The access hasn't happened
+     * yet; GDB expects this on ARM, and will step over it by itself.
+     */
+
+    uint32_t type = instance.watchHitType;
+    SvmMemory::VirtAddr addr = instance.watchHitAddr;
+
+    if (signal(S_TRAP)) {
+        // signal() forgets the previous hit, so record this one again.
+        instance.watchHitType = type;
+        instance.watchHitAddr = addr;
+        messageLoop();
+    }
+}
+
+#endif  // SIFTEO_SIMULATOR
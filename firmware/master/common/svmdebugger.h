@@ -50,6 +50,23 @@ public:
     /// When paging in a flash block, we may need to patch it to apply breakpoints.
     static void patchFlashBlock(uint32_t blockAddr, uint8_t *data);
 
+#ifdef SIFTEO_SIMULATOR
+    /// Are any data watchpoints armed? This is the only cost that
+    /// SvmCpu pays on each load or store when no watchpoints are in use.
+    static ALWAYS_INLINE bool watchpointsArmed() {
+        return instance.watchpointMap != 0;
+    }
+
+    /// Would this access, made by the instruction at 'pc', trigger a
+    /// watchpoint? Accesses are host addresses, as seen by SvmCpu.
+    static bool isWatched(uintptr_t pc, uintptr_t addr, unsigned bytes,
+        Svm::Debugger::WatchTypes type);
+
+    /// Stop on a watchpoint, after isWatched() said we should. The PC
+    /// must already point back at the instruction that made the access.
+    static void watchpoint();
+#endif
+
 private:
     SvmDebugger() {}
     static SvmDebugger instance;
@@ -68,6 +85,19 @@ private:
     uint32_t breakpointMap;
     uint32_t breakpoints[NUM_TOTAL_BREAKPOINTS];
 
+    // Watchpoints, as physical RAM ranges. After a hit we let the same
+    // instruction through once when it resumes, so that continuing from
+    // a watchpoint doesn't immediately stop on it again.
+    struct Watchpoint {
+        uintptr_t begin, end;
+        uint32_t type;
+    };
+    uint32_t watchpointMap;
+    Watchpoint watchpoints[Svm::Debugger::NUM_WATCHPOINTS];
+    uintptr_t watchResumePC;
+    uint32_t watchHitType;
+    SvmMemory::VirtAddr watchHitAddr;
+
     void messageLoopWork();
     void handleMessage(SvmDebugPipe::DebuggerMsg &msg);
 
@@ -80,6 +110,7 @@ private:
     void msgDetach(SvmDebugPipe::DebuggerMsg &msg);
     void msgSetBreakpoints(SvmDebugPipe::DebuggerMsg &msg);
     void msgStep(SvmDebugPipe::DebuggerMsg &msg);
+    void msgSetWatchpoints(SvmDebugPipe::DebuggerMsg &msg);
 
     void setUserReg(uint32_t r, uint32_t value);
     uint32_t getUserReg(uint32_t r);
@@ -28,6 +28,7 @@
 #include "elfprogram.h"
 #include "flash_blockcache.h"
 #include "flash_volume.h"
+#include "flash_writebehind.h"
 #include "svm.h"
 #include "svmmemory.h"
 #include "svmfastlz.h"
@@ -114,6 +115,9 @@ bool SvmLoader::loadRWData(const Elf::Program &program)
 
 bool SvmLoader::prepareToExec(const Elf::Program &program, SvmRuntime::StackInfo &stack)
 {
+    // Finish the previous program's buffered writes. Each program must opt in.
+    FlashLFSWriteBehind::finish();
+
     // Resync userspace clock with system clock
     SvmClock::init();
 
@@ -257,6 +261,8 @@ FlashVolume SvmLoader::volumeForVA(SvmMemory::VirtAddr va)
 
 void SvmLoader::exit(bool fault)
 {
+    FlashLFSWriteBehind::finish();
+
     switch (runLevel) {
 
     default:
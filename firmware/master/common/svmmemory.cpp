@@ -31,6 +31,10 @@ using namespace Svm;
 uint8_t SvmMemory::userRAM[RAM_SIZE_IN_BYTES] __attribute__ ((aligned(4)));
 FlashMapSpan SvmMemory::flashSeg[NUM_FLASH_SEGMENTS];
 
+#ifdef SIFTEO_SIMULATOR
+uint64_t SvmMemory::bytesAccessed;
+#endif
+
 
 bool SvmMemory::mapRAM(VirtAddr va, uint32_t length, PhysAddr &pa)
 {
@@ -58,7 +62,13 @@ bool SvmMemory::mapRAM(VirtAddr va, uint32_t length, PhysAddr &pa)
     // Check the extent of this region.
     // Note that with length==0, the address (VIRTUAL_RAM_BASE + RAM_SIZE_IN_BYTES) is valid.
     // This calculation must work securely for any possible 32-bit length value.
-    return length <= (RAM_SIZE_IN_BYTES - offset);
+    if (length > (RAM_SIZE_IN_BYTES - offset))
+        return false;
+
+#ifdef SIFTEO_SIMULATOR
+    bytesAccessed += length;
+#endif
+    return true;
 }
 
 bool SvmMemory::checkROData(VirtAddr va, uint32_t length)
@@ -131,8 +141,14 @@ bool SvmMemory::copyROData(FlashBlockRef &ref,
     }
 
     STATIC_ASSERT(arraysize(flashSeg) == 2);
-    return flashSeg[0].copyBytes(ref, src - SEGMENT_0_VA, dest, length) ||
-           flashSeg[1].copyBytes(ref, src - SEGMENT_1_VA, dest, length);
+    if (!flashSeg[0].copyBytes(ref, src - SEGMENT_0_VA, dest, length) &&
+        !flashSeg[1].copyBytes(ref, src - SEGMENT_1_VA, dest, length))
+        return false;
+
+#ifdef SIFTEO_SIMULATOR
+    bytesAccessed += length;
+#endif
+    return true;
 }
 
 bool SvmMemory::strlcpyROData(FlashBlockRef &ref, char *dest, VirtAddr src, uint32_t destSize)
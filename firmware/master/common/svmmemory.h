@@ -263,6 +263,20 @@ public:
     static ALWAYS_INLINE VirtAddr physToVirtRAM(Svm::reg_t pa) {
         return physToVirtRAM(reinterpret_cast<PhysAddr>(pa));
     }
+
+    /**
+     * Virtual to Physical translation for a range of RAM, for debuggers.
+     * Unlike mapRAM(), this doesn't count towards any statistics, so it's
+     * safe to call from outside the SVM thread. Only accepts virtual
+     * addresses.
+     */
+    static ALWAYS_INLINE bool debugMapRAM(VirtAddr va, uint32_t length, PhysAddr &pa) {
+        uint32_t offset = (uint32_t)va - VIRTUAL_RAM_BASE;
+        if (offset > RAM_SIZE_IN_BYTES || length > RAM_SIZE_IN_BYTES - offset)
+            return false;
+        pa = userRAM + offset;
+        return true;
+    }
     
     /**
      * Convert a flash block address to a VA in any valid segment.
@@ -305,6 +319,14 @@ public:
         return unsigned(-1);
     }
 
+#ifdef SIFTEO_SIMULATOR
+    /**
+     * Running total of bytes validated by mapRAM() or copied by
+     * copyROData(). Used only in simulation, for syscall statistics.
+     */
+    static uint64_t bytesAccessed;
+#endif
+
     /**
      * Quick predicates to check a physical address. Used only in simulation.
      */
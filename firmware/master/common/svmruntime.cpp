@@ -133,6 +133,13 @@ void SvmRuntime::fault(FaultCode code)
 
 void SvmRuntime::call(reg_t addr)
 {
+#ifdef SIFTEO_SIMULATOR
+    if (UNLIKELY(SvmDebugger::watchpointsArmed()) &&
+        watchSVCAccess(SvmCpu::reg(REG_SP) - sizeof(CallFrame), sizeof(CallFrame),
+            Svm::Debugger::W_WRITE))
+        return;
+#endif
+
     // Allocate a CallFrame for this function
     adjustSP(-(int)(sizeof(CallFrame) / sizeof(uint32_t)));
     CallFrame *fp = reinterpret_cast<CallFrame*>(SvmCpu::reg(REG_SP));
@@ -448,11 +455,15 @@ void SvmRuntime::syscall(unsigned num)
             reinterpret_cast<void*>(SvmCpu::reg(7))));
     });
 
+    onSyscallEnter(num);
+
     uint64_t result = fn(SvmCpu::reg(0), SvmCpu::reg(1),
                          SvmCpu::reg(2), SvmCpu::reg(3),
                          SvmCpu::reg(4), SvmCpu::reg(5),
                          SvmCpu::reg(6), SvmCpu::reg(7));
 
+    onSyscallExit(num);
+
     uint32_t result0 = result;
     uint32_t result1 = result >> 32;
 
@@ -465,6 +476,20 @@ void SvmRuntime::syscall(unsigned num)
     SvmCpu::setReg(1, result1);
 }
 
+#ifdef SIFTEO_SIMULATOR
+
+const char *SvmRuntime::getSyscallName(unsigned num)
+{
+    return num < arraysize(SyscallNames) ? SyscallNames[num] : NULL;
+}
+
+unsigned SvmRuntime::getNumSyscalls()
+{
+    return arraysize(SyscallNames);
+}
+
+#endif
+
 ALWAYS_INLINE void SvmRuntime::tailSyscall(unsigned num)
 {
     /*
@@ -564,10 +589,16 @@ ALWAYS_INLINE void SvmRuntime::longLDRSP(unsigned reg, unsigned offset)
     ASSERT((va & 3) == 0);
     ASSERT(reg < 8);
 
-    if (SvmMemory::mapRAM(va, sizeof(uint32_t), pa))
-        SvmCpu::setReg07(reg, *reinterpret_cast<uint32_t*>(pa));
-    else
-        SvmRuntime::fault(F_LONG_STACK_LOAD);
+    if (!SvmMemory::mapRAM(va, sizeof(uint32_t), pa))
+        return SvmRuntime::fault(F_LONG_STACK_LOAD);
+
+#ifdef SIFTEO_SIMULATOR
+    if (UNLIKELY(SvmDebugger::watchpointsArmed()) &&
+        watchSVCAccess(reinterpret_cast<reg_t>(pa), sizeof(uint32_t), Svm::Debugger::W_READ))
+        return;
+#endif
+
+    SvmCpu::setReg07(reg, *reinterpret_cast<uint32_t*>(pa));
 }
 
 ALWAYS_INLINE void SvmRuntime::longSTRSP(unsigned reg, unsigned offset)
@@ -578,10 +609,16 @@ ALWAYS_INLINE void SvmRuntime::longSTRSP(unsigned reg, unsigned offset)
     ASSERT((va & 3) == 0);
     ASSERT(reg < 8);
 
-    if (SvmMemory::mapRAM(va, sizeof(uint32_t), pa))
-        *reinterpret_cast<uint32_t*>(pa) = SvmCpu::reg07(reg);
-    else
-        SvmRuntime::fault(F_LONG_STACK_STORE);
+    if (!SvmMemory::mapRAM(va, sizeof(uint32_t), pa))
+        return SvmRuntime::fault(F_LONG_STACK_STORE);
+
+#ifdef SIFTEO_SIMULATOR
+    if (UNLIKELY(SvmDebugger::watchpointsArmed()) &&
+        watchSVCAccess(reinterpret_cast<reg_t>(pa), sizeof(uint32_t), Svm::Debugger::W_WRITE))
+        return;
+#endif
+
+    *reinterpret_cast<uint32_t*>(pa) = SvmCpu::reg07(reg);
 }
 
 void SvmRuntime::breakpoint()
@@ -602,3 +639,26 @@ void SvmRuntime::breakpoint()
     SvmDebugger::signal(Svm::Debugger::S_TRAP);
     SvmDebugger::messageLoop();
 }
+
+#ifdef SIFTEO_SIMULATOR
+
+bool SvmRuntime::watchSVCAccess(reg_t addr, unsigned bytes, Svm::Debugger::WatchTypes type)
+{
+    /*
+     * SvmCpu only checks watchpoints on the loads and stores it emulates.
+     * The SVCs which touch the stack on the program's behalf (long stack
+     * loads and stores, and call frames) check here. Like breakpoint(),
+     * back the PC up to the SVC and stop there without doing anything.
+     * Returns 'true' if the caller should abort the operation.
+     */
+
+    reg_t pc = SvmCpu::reg(REG_PC) - 2;
+    if (!SvmDebugger::isWatched(pc, addr, bytes, type))
+        return false;
+
+    SvmCpu::setReg(REG_PC, pc);
+    SvmDebugger::watchpoint();
+    return true;
+}
+
+#endif
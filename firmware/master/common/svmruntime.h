@@ -148,6 +148,15 @@ public:
         SvmCpu::setReg(7, r7);
     }
 
+#ifdef SIFTEO_SIMULATOR
+    /**
+     * Look up the name of a syscall, for statistics and debugging.
+     * Returns NULL if there is no such syscall.
+     */
+    static const char *getSyscallName(unsigned num);
+    static unsigned getNumSyscalls();
+#endif
+
 private:
     enum ReturnActions {
         RET_BRANCH          = 1 << 0,
@@ -200,11 +209,16 @@ private:
     static void breakpoint();
 
 #ifdef SIFTEO_SIMULATOR
+    static bool watchSVCAccess(reg_t addr, unsigned bytes, Svm::Debugger::WatchTypes type);
     static SvmMemory::PhysAddr topOfStackPA;
     static SvmMemory::PhysAddr stackLowWaterMark;
     static void onStackModification(SvmMemory::PhysAddr sp);
+    static void onSyscallEnter(unsigned num);
+    static void onSyscallExit(unsigned num);
 #else
     static void onStackModification(SvmMemory::PhysAddr sp) {}
+    static void onSyscallEnter(unsigned num) {}
+    static void onSyscallExit(unsigned num) {}
 #endif
 };
 
@@ -101,6 +101,32 @@ void _SYS_asset_loadStart(_SYSAssetLoader *loader,
     ASSERT(AssetLoader::getUserLoader() == loader);
 }
 
+void _SYS_asset_loadPrefetch(_SYSAssetLoader *loader,
+    const struct _SYSAssetConfiguration *cfg, unsigned cfgSize, _SYSCubeIDVector cv)
+{
+    if (!isAligned(loader))
+        return SvmRuntime::fault(F_SYSCALL_ADDR_ALIGN);
+    if (!SvmMemory::mapRAM(loader))
+        return SvmRuntime::fault(F_SYSCALL_ADDRESS);
+
+    if (!isAligned(cfg))
+        return SvmRuntime::fault(F_SYSCALL_ADDR_ALIGN);
+    if (!SvmMemory::mapRAM(cfg, mulsat16x16(cfgSize, sizeof *cfg)))
+        return SvmRuntime::fault(F_SYSCALL_ADDRESS);
+    if (!AssetUtil::isValidConfig(cfg, cfgSize))
+        return SvmRuntime::fault(F_BAD_ASSET_CONFIG);
+
+    _SYSAssetLoader *prevLoader = AssetLoader::getUserLoader();
+    if (prevLoader && prevLoader != loader)
+        return SvmRuntime::fault(F_BAD_ASSET_LOADER);
+
+    cv = CubeSlots::truncateVector(cv);
+
+    AssetLoader::prefetch(loader, cfg, cfgSize, cv);
+
+    ASSERT(AssetLoader::getUserLoader() == loader);
+}
+
 void _SYS_asset_loadFinish(_SYSAssetLoader *loader)
 {
     if (!isAligned(loader))
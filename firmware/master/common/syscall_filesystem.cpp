@@ -36,6 +36,7 @@
 #include "macros.h"
 #include "flash_volume.h"
 #include "flash_lfs.h"
+#include "flash_writebehind.h"
 #include "svmmemory.h"
 #include "svmruntime.h"
 #include "svmloader.h"
@@ -184,6 +185,11 @@ int32_t _SYS_fs_objectRead(unsigned key, uint8_t *buffer,
         return _SYS_EFAULT;
     }
 
+    // Objects still in the write-behind buffer are newer than anything in flash
+    int32_t result;
+    if (FlashLFSWriteBehind::read(parentVol, key, buffer, bufferSize, result))
+        return result;
+
     /*
      * Search for the requested object in the index.
      *
@@ -230,6 +236,21 @@ int32_t _SYS_fs_objectWrite(unsigned key, const uint8_t *data, unsigned dataSize
         return _SYS_EINVAL;
     }
 
+    /*
+     * If an automatic flush of this volume's buffered writes failed, report
+     * that now instead. This write isn't attempted, so it can be retried.
+     */
+    int32_t result = FlashLFSWriteBehind::takeError(parentVol);
+    if (result < 0)
+        return result;
+
+    // If the program opted in, small writes may be buffered instead.
+    if (FlashLFSWriteBehind::write(parentVol, key, data, dataSize, result)) {
+        if (result == _SYS_EFAULT)
+            SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return result;
+    }
+
     /*
      * Do the CRC early; we need to catch faults on 'data' before we create
      * the new FS object. We'll ask for the CRC to be padded out to the
@@ -250,6 +271,9 @@ int32_t _SYS_fs_objectWrite(unsigned key, const uint8_t *data, unsigned dataSize
      * written data to the filesystem which matches our above CRC.
      */
 
+    // This write supersedes any buffered copy of the same object
+    FlashLFSWriteBehind::discard(parentVol, key);
+
     FlashLFS &lfs = FlashLFSCache::get(parentVol);
     FlashLFSObjectAllocator allocator(lfs, key, dataSize, crc);
 
@@ -303,6 +327,19 @@ int32_t _SYS_fs_objectWrite(unsigned key, const uint8_t *data, unsigned dataSize
     return dataSize;
 }
 
+void _SYS_fs_setWriteBehind(uint32_t enable)
+{
+    FlashLFSWriteBehind::setEnabled(enable != 0);
+}
+
+int32_t _SYS_fs_flush()
+{
+    // Report a failure from this flush first, then any earlier one
+    int32_t result = FlashLFSWriteBehind::flush();
+    int32_t earlier = FlashLFSWriteBehind::takeError(SvmLoader::getRunningVolume());
+    return result < 0 ? result : earlier;
+}
+
 uint32_t _SYS_fs_runningVolume()
 {
     // Return a _SYSVolumeHandle for the currently executing volume
@@ -66,7 +66,12 @@ void _SYS_exit(void)
 
 void _SYS_yield(void)
 {
-    Tasks::idle();
+    /*
+     * A pre-erase keeps the flash busy for about a second, and nothing else
+     * (including audio) can run while we wait for it. Games yield while
+     * they still need to stay responsive, so leave that for later.
+     */
+    Tasks::idle(Intrinsic::LZ(Tasks::PreErase));
     SvmRuntime::dispatchEventsOnReturn();
 }
 
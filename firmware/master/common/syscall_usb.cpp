@@ -33,7 +33,9 @@
 #include "macros.h"
 #include "usbprotocol.h"
 
-#ifndef SIFTEO_SIMULATOR
+#ifdef SIFTEO_SIMULATOR
+#include "mc_datapipe.h"
+#else
 #include "usb/usbdevice.h"
 #include "usb/usbhardware.h"
 #include "powermanager.h"
@@ -44,7 +46,7 @@ extern "C" {
 uint32_t _SYS_usb_isConnected()
 {
 #ifdef SIFTEO_SIMULATOR
-    return false;
+    return SimUSB::isConnected();
 #else
     return (PowerManager::state() == PowerManager::UsbPwr);
 #endif
@@ -70,9 +72,6 @@ uint32_t _SYS_usb_counters(_SYSUsbCounters *buffer, uint32_t bufferSize)
         return 0;
     }
 
-#ifdef SIFTEO_SIMULATOR
-    return 0;
-#else
     const _SYSUsbCounters *counters = USBProtocol::getCounters();
 
     unsigned actualSize = MIN(sizeof *counters, bufferSize);
@@ -80,7 +79,6 @@ uint32_t _SYS_usb_counters(_SYSUsbCounters *buffer, uint32_t bufferSize)
     memcpy(buffer, counters, actualSize);
 
     return actualSize;
-#endif
 }
 
 } // extern "C"
@@ -0,0 +1,218 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Thundercracker firmware
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Batched floating point syscalls.
+ *
+ * Userspace has no FPU, so every float operation is a syscall. These do
+ * the work of several such syscalls at once: small vector and matrix
+ * operations for physics code, polynomial evaluation, and the fused
+ * expressions that slinky generates from straight-line float arithmetic.
+ *
+ * Each operation is written out in the same order the equivalent SDK
+ * code would perform it, so that results match bit for bit.
+ */
+
+#include <math.h>
+#include <sifteo/abi.h>
+#include "svmmemory.h"
+#include "svmruntime.h"
+
+static ALWAYS_INLINE float toFloat(uint32_t bits)
+{
+    return reinterpret_cast<float&>(bits);
+}
+
+static ALWAYS_INLINE uint32_t fromFloat(float f)
+{
+    return reinterpret_cast<uint32_t&>(f);
+}
+
+static ALWAYS_INLINE uint64_t fromFloat2(float x, float y)
+{
+    return fromFloat(x) | (uint64_t)fromFloat(y) << 32;
+}
+
+extern "C" {
+
+uint32_t _SYS_vec2_dotf(uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by)
+{
+    float r = toFloat(ax) * toFloat(bx) + toFloat(ay) * toFloat(by);
+    return fromFloat(r);
+}
+
+uint32_t _SYS_vec3_dotf(uint32_t ax, uint32_t ay, uint32_t az, uint32_t bx, uint32_t by, uint32_t bz)
+{
+    float r = toFloat(ax) * toFloat(bx) + toFloat(ay) * toFloat(by) + toFloat(az) * toFloat(bz);
+    return fromFloat(r);
+}
+
+void _SYS_vec3_crossf(_SYSFloat3 *out, uint32_t ax, uint32_t ay, uint32_t az, uint32_t bx, uint32_t by, uint32_t bz)
+{
+    if (!SvmMemory::mapRAM(out))
+        return SvmRuntime::fault(F_SYSCALL_ADDRESS);
+
+    float fAX = toFloat(ax), fAY = toFloat(ay), fAZ = toFloat(az);
+    float fBX = toFloat(bx), fBY = toFloat(by), fBZ = toFloat(bz);
+
+    out->x = fAY * fBZ - fAZ * fBY;
+    out->y = fAZ * fBX - fAX * fBZ;
+    out->z = fAX * fBY - fAY * fBX;
+}
+
+uint64_t _SYS_vec2_normalizef(uint32_t x, uint32_t y)
+{
+    float fX = toFloat(x), fY = toFloat(y);
+    float len = sqrtf(fX * fX + fY * fY);
+    return fromFloat2(fX / len, fY / len);
+}
+
+void _SYS_vec3_normalizef(_SYSFloat3 *v)
+{
+    if (!SvmMemory::mapRAM(v))
+        return SvmRuntime::fault(F_SYSCALL_ADDRESS);
+
+    float len = sqrtf(v->x * v->x + v->y * v->y + v->z * v->z);
+    v->x = v->x / len;
+    v->y = v->y / len;
+    v->z = v->z / len;
+}
+
+uint64_t _SYS_mat2_transformf(const _SYSAffine2 *m, uint32_t x, uint32_t y)
+{
+    _SYSAffine2 lm;
+    if (!SvmMemory::copyROData(lm, m)) {
+        SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return 0;
+    }
+
+    float fX = toFloat(x), fY = toFloat(y);
+    return fromFloat2(lm.xx * fX + lm.yx * fY + lm.cx,
+                      lm.xy * fX + lm.yy * fY + lm.cy);
+}
+
+void _SYS_mat3_transformf(_SYSFloat3 *v, const float *m)
+{
+    float lm[9];
+    FlashBlockRef ref;
+
+    if (!SvmMemory::mapRAM(v) ||
+        !SvmMemory::copyROData(ref, reinterpret_cast<SvmMemory::PhysAddr>(lm),
+            reinterpret_cast<SvmMemory::VirtAddr>(m), sizeof lm))
+        return SvmRuntime::fault(F_SYSCALL_ADDRESS);
+
+    float x = v->x, y = v->y, z = v->z;
+    v->x = lm[0] * x + lm[3] * y + lm[6] * z;
+    v->y = lm[1] * x + lm[4] * y + lm[7] * z;
+    v->z = lm[2] * x + lm[5] * y + lm[8] * z;
+}
+
+uint32_t _SYS_polyf(uint32_t x, const float *coeff, uint32_t count)
+{
+    /*
+     * Evaluate coeff[0] + coeff[1]*x + coeff[2]*x^2 + ... using
+     * Horner's rule, starting from the highest-order coefficient.
+     */
+
+    float lc[_SYS_POLY_MAX_COEFF];
+    FlashBlockRef ref;
+
+    if (count == 0 || count > _SYS_POLY_MAX_COEFF) {
+        SvmRuntime::fault(F_SYSCALL_PARAM);
+        return 0;
+    }
+    if (!SvmMemory::copyROData(ref, reinterpret_cast<SvmMemory::PhysAddr>(lc),
+            reinterpret_cast<SvmMemory::VirtAddr>(coeff), count * sizeof lc[0])) {
+        SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return 0;
+    }
+
+    float fX = toFloat(x);
+    float r = lc[--count];
+    while (count--)
+        r = r * fX + lc[count];
+
+    return fromFloat(r);
+}
+
+uint32_t _SYS_fexprf(const uint8_t *program, uint32_t length, const float *inputs, uint32_t numInputs)
+{
+    /*
+     * Fused float expression. See the _SYS_FEXPR_* definitions in abi/types.h.
+     *
+     * Programs are small, so copy the whole thing out along with the inputs.
+     * Register indices are checked as we go; an instruction may only read
+     * registers that have already been written.
+     */
+
+    float regs[_SYS_FEXPR_MAX_REGS];
+    uint8_t code[_SYS_FEXPR_MAX_REGS * _SYS_FEXPR_INSN_BYTES];
+    FlashBlockRef ref;
+
+    unsigned numInsns = length / _SYS_FEXPR_INSN_BYTES;
+    if (numInsns == 0 || length % _SYS_FEXPR_INSN_BYTES
+        || numInputs > _SYS_FEXPR_MAX_REGS - numInsns
+        || numInsns > _SYS_FEXPR_MAX_REGS) {
+        SvmRuntime::fault(F_SYSCALL_PARAM);
+        return 0;
+    }
+
+    if (!SvmMemory::copyROData(ref, reinterpret_cast<SvmMemory::PhysAddr>(code),
+            reinterpret_cast<SvmMemory::VirtAddr>(program), length) ||
+        !SvmMemory::copyROData(ref, reinterpret_cast<SvmMemory::PhysAddr>(regs),
+            reinterpret_cast<SvmMemory::VirtAddr>(inputs), numInputs * sizeof regs[0])) {
+        SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return 0;
+    }
+
+    unsigned dest = numInputs;
+    const uint8_t *pc = code;
+
+    while (numInsns--) {
+        unsigned op = pc[0], a = pc[1], b = pc[2];
+        pc += _SYS_FEXPR_INSN_BYTES;
+
+        if (a >= dest || b >= dest) {
+            SvmRuntime::fault(F_SYSCALL_PARAM);
+            return 0;
+        }
+
+        float fA = regs[a], fB = regs[b];
+        switch (op) {
+            case _SYS_FEXPR_ADD:    regs[dest] = fA + fB; break;
+            case _SYS_FEXPR_SUB:    regs[dest] = fA - fB; break;
+            case _SYS_FEXPR_MUL:    regs[dest] = fA * fB; break;
+            case _SYS_FEXPR_DIV:    regs[dest] = fA / fB; break;
+            default:
+                SvmRuntime::fault(F_SYSCALL_PARAM);
+                return 0;
+        }
+        dest++;
+    }
+
+    return fromFloat(regs[dest - 1]);
+}
+
+}  // extern "C"
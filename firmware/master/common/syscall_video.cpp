@@ -32,6 +32,54 @@
 #include "svmruntime.h"
 #include "vram.h"
 
+
+/*
+ * Accumulates a stream of packed bits, LSB-first, and writes them to
+ * VRAM a word at a time. Only words with some bits covered are touched,
+ * and words that are fully covered don't need to be read first.
+ */
+class VRAMBitWriter {
+public:
+    VRAMBitWriter(_SYSVideoBuffer &vbuf, uint32_t dstBit)
+        : vbuf(vbuf), addr(dstBit >> 4), shift(dstBit & 15), value(0), mask(0) {}
+
+    void put(uint8_t byte, unsigned bits) {
+        uint32_t bitMask = (1 << bits) - 1;
+        value |= uint32_t(byte & bitMask) << shift;
+        mask |= bitMask << shift;
+        shift += bits;
+
+        if (shift >= 16) {
+            writeWord();
+            value >>= 16;
+            mask >>= 16;
+            shift -= 16;
+            addr++;
+        }
+    }
+
+    void flush() {
+        if (mask)
+            writeWord();
+    }
+
+private:
+    _SYSVideoBuffer &vbuf;
+    uint16_t addr;
+    unsigned shift;
+    uint32_t value;
+    uint32_t mask;
+
+    void writeWord() {
+        VRAM::truncateWordAddr(addr);
+        if ((mask & 0xFFFF) == 0xFFFF)
+            VRAM::poke(vbuf, addr, value);
+        else
+            VRAM::pokeMasked(vbuf, addr, value, mask);
+    }
+};
+
+
 extern "C" {
 
 void _SYS_vbuf_init(_SYSVideoBuffer *vbuf)
@@ -116,6 +164,77 @@ void _SYS_vbuf_xorb(_SYSVideoBuffer *vbuf, uint16_t addr, uint8_t byte)
     VRAM::xorb(*vbuf, addr, byte);
 }
 
+void _SYS_vbuf_writeMasked(_SYSVideoBuffer *vbuf, uint16_t addr, uint16_t word, uint16_t mask)
+{
+    if (!isAligned(vbuf))
+        return SvmRuntime::fault(F_SYSCALL_ADDR_ALIGN);
+
+    if (!SvmMemory::mapRAM(vbuf)) {
+        SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return;
+    }
+
+    VRAM::truncateWordAddr(addr);
+    VRAM::pokeMasked(*vbuf, addr, word, mask);
+}
+
+void _SYS_vbuf_bitblt(_SYSVideoBuffer *vbuf, uint32_t dstBit, const uint8_t *src,
+                      uint32_t bits, uint32_t lines, uint32_t srcStride, uint32_t dstStride)
+{
+    /*
+     * Copy 'lines' rows of packed bits from 'src' to VRAM. Both are packed
+     * LSB-first, the same way framebuffer modes pack their pixels. Each row
+     * is 'bits' long; rows are 'srcStride' bytes apart in the source, and
+     * 'dstStride' bits apart in VRAM. Destination addresses wrap.
+     *
+     * This replaces a peek and a poke per destination byte, for drawing
+     * bitmaps at any pixel offset in FB32, FB64, FB128, and STAMP modes.
+     */
+
+    if (!isAligned(vbuf))
+        return SvmRuntime::fault(F_SYSCALL_ADDR_ALIGN);
+
+    if (!SvmMemory::mapRAM(vbuf)) {
+        SvmRuntime::fault(F_SYSCALL_ADDRESS);
+        return;
+    }
+
+    if (bits > _SYS_VRAM_BYTES * 8) {
+        SvmRuntime::fault(F_SYSCALL_PARAM);
+        return;
+    }
+
+    FlashBlockRef ref;
+    SvmMemory::VirtAddr lineVA = reinterpret_cast<SvmMemory::VirtAddr>(src);
+
+    while (lines--) {
+        VRAMBitWriter writer(*vbuf, dstBit);
+        SvmMemory::VirtAddr srcVA = lineVA;
+        uint32_t remaining = bits;
+
+        while (remaining) {
+            SvmMemory::PhysAddr srcPA;
+            uint32_t chunk = (remaining + 7) / 8;
+            if (!SvmMemory::mapROData(ref, srcVA, chunk, srcPA)) {
+                SvmRuntime::fault(F_SYSCALL_ADDRESS);
+                return;
+            }
+            srcVA += chunk;
+
+            while (chunk--) {
+                unsigned n = MIN(remaining, 8u);
+                writer.put(*srcPA, n);
+                srcPA++;
+                remaining -= n;
+            }
+        }
+
+        writer.flush();
+        lineVA += srcStride;
+        dstBit += dstStride;
+    }
+}
+
 uint32_t _SYS_vbuf_peek(const _SYSVideoBuffer *vbuf, uint16_t addr)
 {
     if (!isAligned(vbuf)) {
@@ -37,12 +37,17 @@
 #include "batterylevel.h"
 #include "volume.h"
 #include "btprotocol.h"
+#include "flash_preerase.h"
+#include "flash_writebehind.h"
+#include "flash_lfs.h"
 
 #ifdef SIFTEO_SIMULATOR
 #   include "mc_timing.h"
 #   include "system_mc.h"
 #   include "system.h"
 #   include "batterylevel.h"
+#   include "mc_datapipe.h"
+#   include "usbprotocol.h"
 #else
 #   include "nrf8001/nrf8001.h"
 #   include "usb/usbdevice.h"
@@ -74,6 +79,11 @@ ALWAYS_INLINE void Tasks::taskInvoke(unsigned id)
         #if (BOARD == BOARD_TEST_JIG && !defined(BOOTLOADER))
         case Tasks::TestJig:            return TestJig::task();
         #endif
+    #else
+        // Siftulator's stand-ins for the USB and Bluetooth drivers
+        case Tasks::UsbOUT:             return SimUSB::handleOUTData();
+        case Tasks::UsbIN:              return USBProtocol::inTask();
+        case Tasks::BluetoothDriver:    return SimBluetooth::task();
     #endif
 
     #if !defined(BOOTLOADER) && !BOARD_EQUALS(BOARD_TEST_JIG)
@@ -124,6 +134,9 @@ void Tasks::heartbeatTask()
 
     Radio::heartbeat();
     AssetLoader::heartbeat();
+    FlashBlockPreEraser::heartbeat();
+    FlashLFSWriteBehind::heartbeat();
+    FlashLFSCache::heartbeat();
 
 #endif
 
@@ -216,10 +229,29 @@ void Tasks::idle(uint32_t exclude)
      * This is the correct way to block the main thread of execution while
      * waiting for a condition, as it avoids unnecessary WFIs when the
      * caller is waiting on something which requires Tasks to execute.
+     *
+     * With no tasks pending, we may instead spend the time flushing
+     * buffered object writes, collecting LFS garbage, or pre-erasing flash
+     * blocks. Any of these may wait for a block erase, so callers which
+     * can't tolerate that latency exclude eraseLatencyTasks(). The FlashIdle
+     * and PreErase pseudo-tasks gate them.
      */
 
-    if (!work(exclude))
-        waitForInterrupt();
+    if (work(exclude))
+        return;
+
+#if !defined(BOOTLOADER) && !BOARD_EQUALS(BOARD_TEST_JIG)
+    if (!(exclude & Intrinsic::LZ(FlashIdle))) {
+        if (FlashLFSWriteBehind::idle())
+            return;
+        if (FlashLFSCache::idle())
+            return;
+    }
+    if (!(exclude & Intrinsic::LZ(PreErase)) && FlashBlockPreEraser::idle())
+        return;
+#endif
+
+    waitForInterrupt();
 }
 
 void Tasks::heartbeatISR()
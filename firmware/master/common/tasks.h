@@ -73,7 +73,9 @@ public:
         UsbIN,
         Profiler,
         TestJig,
-        FactoryTest
+        FactoryTest,
+        PreErase,       // Never triggered; only used to exclude idle-time pre-erasing
+        FlashIdle       // Never triggered; only used to exclude idle-time flushes and LFS GC
     };
 
     static void init() {
@@ -93,6 +95,14 @@ public:
     /// Block an idle caller. Runs pending tasks OR waits for a hardware event
     static void idle(uint32_t exclude=0);
 
+    /*
+     * Idle-time flash work which may have to wait for a block erase.
+     * Waits which are on the critical path of a frame exclude these.
+     */
+    static ALWAYS_INLINE uint32_t eraseLatencyTasks() {
+        return Intrinsic::LZ(PreErase) | Intrinsic::LZ(FlashIdle);
+    }
+
     /*
      * Heartbeat ISR handler, called at HEARTBEAT_HZ by a hardware timer.
      * This triggers the Heartbeat task, and acts as a watchdog for Tasks::work().
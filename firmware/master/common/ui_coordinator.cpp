@@ -221,7 +221,7 @@ bool UICoordinator::isTouching()
 
 void UICoordinator::idle()
 {
-    Tasks::idle(excludedTasks);
+    Tasks::idle(excludedTasks | Tasks::eraseLatencyTasks());
 }
 
 bool UICoordinator::pollForAttach()
@@ -29,7 +29,9 @@
 #include "macros.h"
 #include "event.h"
 
-#ifndef SIFTEO_SIMULATOR
+#ifdef SIFTEO_SIMULATOR
+#include "mc_datapipe.h"
+#else
 #include "usb/usbdevice.h"
 #include "hardware.h"
 #include "factorytest.h"
@@ -92,7 +94,12 @@ void USBProtocol::requestUserINPacket()
      * Should only be called in task or syscall context.
      */
 
-#ifndef SIFTEO_SIMULATOR
+#ifdef SIFTEO_SIMULATOR
+    // Wait for the simulated link; Tasks::UsbIN calls us again when it's idle.
+    if (!SimUSB::isReadyToSend()) {
+        return;
+    }
+#else
     // ensure someone's likely to be there listening to us
     if (SysTime::ticks() - UsbDevice::lastINActivity() > SysTime::msTicks(250)) {
         return;
@@ -117,7 +124,9 @@ void USBProtocol::requestUserINPacket()
 
         // timeout here should leave some headroom for system watchdog,
         // which is currently 3 seconds.
-#ifndef SIFTEO_SIMULATOR
+#ifdef SIFTEO_SIMULATOR
+        SimUSB::write(buf, length + sizeof pkt->type);
+#else
         UsbDevice::write(buf, pkt->length + sizeof pkt->type, 1000);
 #endif
         return Event::setBasePending(Event::PID_BASE_USB_WRITE_AVAILABLE);
@@ -30,6 +30,7 @@
 #include "flash_volumeheader.h"
 #include "flash_syslfs.h"
 #include "flash_stack.h"
+#include "crc.h"
 
 #ifndef SIFTEO_SIMULATOR
 #include "usb/usbdevice.h"
@@ -184,6 +185,10 @@ void UsbVolumeManager::onUsbData(const USBProtocolMsg &m)
         flashDeviceRead(m, reply);
         break;
 
+    case FlashDeviceBlockInfo:
+        flashDeviceBlockInfo(m, reply);
+        break;
+
     case BaseSysInfo:
         baseSysInfo(m, reply);
         break;
@@ -439,6 +444,79 @@ void UsbVolumeManager::flashDeviceRead(const USBProtocolMsg &m, USBProtocolMsg &
     reply.len += length;
 }
 
+void UsbVolumeManager::flashDeviceBlockInfo(const USBProtocolMsg &m, USBProtocolMsg &reply)
+{
+    /*
+     * Describe a range of erase blocks: whether any volume still refers to
+     * them, and a CRC of the allocated ones. Blocks outside every volume are
+     * either erased already, or orphans the recycler will erase before they're
+     * reused, so a backup may treat them as erased without reading them.
+     */
+
+    if (m.payloadLen() < sizeof(FlashDeviceBlockInfoRequest))
+        return;
+
+    const FlashDeviceBlockInfoRequest *payload = m.castPayload<FlashDeviceBlockInfoRequest>();
+    const unsigned numBlocks = FlashDevice::CAPACITY / FlashDevice::ERASE_BLOCK_SIZE;
+    STATIC_ASSERT(FlashMapBlock::BLOCK_SIZE % FlashDevice::ERASE_BLOCK_SIZE == 0);
+    STATIC_ASSERT(sizeof(FlashDeviceBlockInfoReply) <= USBProtocolMsg::MAX_PAYLOAD_BYTES);
+
+    unsigned first = payload->firstBlock;
+    unsigned count = first > numBlocks ? 0 : numBlocks - first;
+    count = MIN(count, payload->count);
+    count = MIN(count, FlashDeviceBlockInfoReply::MAX_BLOCKS);
+
+    reply.header |= FlashDeviceBlockInfo;
+    FlashDeviceBlockInfoReply *r = reply.zeroCopyAppend<FlashDeviceBlockInfoReply>();
+    r->firstBlock = first;
+    r->count = count;
+    r->allocated = 0;
+    memset(r->crc, 0, sizeof r->crc);
+
+    // Every map block reachable from any volume, even a deleted one
+    FlashMapBlock::Set inUse;
+    inUse.clear();
+
+    FlashVolumeIter vi;
+    FlashVolume vol;
+
+    vi.begin();
+    while (vi.next(vol)) {
+        FlashBlockRef ref;
+        FlashVolumeHeader *hdr = FlashVolumeHeader::get(ref, vol.block);
+        ASSERT(hdr->isHeaderValid());
+
+        unsigned numMapEntries = hdr->numMapEntries();
+        const FlashMap *map = hdr->getMap();
+
+        for (unsigned I = 0; I != numMapEntries; ++I) {
+            FlashMapBlock block = map->blocks[I];
+            if (block.isValid())
+                block.mark(inUse);
+        }
+    }
+
+    for (unsigned i = 0; i != count; ++i) {
+        uint32_t address = (first + i) * FlashDevice::ERASE_BLOCK_SIZE;
+        if (!inUse.test(address / FlashMapBlock::BLOCK_SIZE))
+            continue;
+
+        r->allocated |= 1 << i;
+
+        CrcStream crc;
+        crc.reset();
+
+        for (unsigned offset = 0; offset != FlashDevice::ERASE_BLOCK_SIZE;
+            offset += FlashDevice::PAGE_SIZE) {
+            uint32_t buf[FlashDevice::PAGE_SIZE / sizeof(uint32_t)];
+            FlashDevice::read(address + offset, reinterpret_cast<uint8_t*>(buf), sizeof buf);
+            crc.addBytes(reinterpret_cast<uint8_t*>(buf), sizeof buf);
+        }
+
+        r->crc[i] = crc.get();
+    }
+}
+
 void UsbVolumeManager::baseSysInfo(const USBProtocolMsg &m, USBProtocolMsg &reply)
 {
     reply.header |= BaseSysInfo;
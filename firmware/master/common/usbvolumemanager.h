@@ -58,7 +58,8 @@ public:
         WriteLFSObjectHeader,
         WriteLFSObjectHeaderFail,
         WriteLFSObjectPayload,
-        DeleteLFSChildren
+        DeleteLFSChildren,
+        FlashDeviceBlockInfo
     };
 
     struct VolumeOverviewReply {
@@ -104,6 +105,27 @@ public:
         uint32_t length;
     };
 
+    struct FlashDeviceBlockInfoRequest {
+        uint32_t firstBlock;
+        uint32_t count;
+    };
+
+    /*
+     * Summarizes a range of FlashDevice erase blocks, so a backup can skip
+     * blocks that no volume refers to, and blocks it already has a copy of.
+     * Bit N of 'allocated' covers block firstBlock+N, and crc[N] is the
+     * Crc32 of its contents. Unallocated blocks aren't read, and have a
+     * CRC of zero.
+     */
+    struct FlashDeviceBlockInfoReply {
+        static const unsigned MAX_BLOCKS = 12;
+
+        uint16_t firstBlock;
+        uint16_t count;
+        uint32_t allocated;
+        uint32_t crc[MAX_BLOCKS];
+    };
+
     struct SysInfoReply {
         uint8_t baseUniqueID[SysInfo::UniqueIdNumBytes];
         uint8_t baseHwRevision;
@@ -122,6 +144,12 @@ public:
 
     static void onUsbData(const USBProtocolMsg &m);
 
+    /// Is a volume install in progress? Its volume is still T_INCOMPLETE.
+    static bool isInstalling() {
+        return writer.volume.isValid() &&
+            writer.volume.getType() == FlashVolume::T_INCOMPLETE;
+    }
+
 private:
     static const unsigned SYSLFS_VOLUME_BLOCK_CODE = 0;
 
@@ -142,6 +170,7 @@ private:
     static ALWAYS_INLINE void pairCube(const USBProtocolMsg &m, USBProtocolMsg &reply);
     static ALWAYS_INLINE void pairingSlotDetail(const USBProtocolMsg &m, USBProtocolMsg &reply);
     static ALWAYS_INLINE void flashDeviceRead(const USBProtocolMsg &m, USBProtocolMsg &reply);
+    static ALWAYS_INLINE void flashDeviceBlockInfo(const USBProtocolMsg &m, USBProtocolMsg &reply);
     static ALWAYS_INLINE void baseSysInfo(const USBProtocolMsg &m, USBProtocolMsg &reply);
     static ALWAYS_INLINE void beginLFSObjectWrite(const USBProtocolMsg &m, USBProtocolMsg &reply);
     static ALWAYS_INLINE void lfsPayloadWrite(const USBProtocolMsg &m);
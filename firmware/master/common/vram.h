@@ -109,6 +109,15 @@ struct VRAM {
         }
     }
 
+    // Like poke(), but only changes the bits that are set in 'mask'.
+    static void pokeMasked(_SYSVideoBuffer &vbuf, uint16_t addr, uint16_t word,
+        uint16_t mask, uint32_t lockFlags = DEFAULT_LOCK_FLAGS)
+    {
+        ASSERT(addr < _SYS_VRAM_WORDS);
+        uint16_t old = vbuf.vram.words[addr];
+        poke(vbuf, addr, (old & ~mask) | (word & mask), lockFlags);
+    }
+
     static void pokeb(_SYSVideoBuffer &vbuf, uint16_t addr, uint8_t byte,
         uint32_t lockFlags = DEFAULT_LOCK_FLAGS)
     {
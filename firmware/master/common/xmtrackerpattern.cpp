@@ -73,6 +73,16 @@ bool XmTrackerPattern::loadPattern(uint16_t i)
 
     noteOffset = 0;
     offset = 0;
+
+    /*
+     * Unpacked patterns have a fixed stride, so we can fetch an entire
+     * row at once. Double-check the size before trusting the song's flag.
+     */
+    unpacked = (song->flags & _SYS_XM_UNPACKED)
+        && song->nChannels <= _SYS_AUDIO_MAX_CHANNELS
+        && pattern.dataSize == pattern.nRows * song->nChannels * kNoteBytes;
+    cachedRow = -1;
+
     return true;
 }
 
@@ -108,6 +118,9 @@ void XmTrackerPattern::getNote(uint16_t row, uint8_t channel, struct XmTrackerNo
         return;
     }
 
+    if (unpacked)
+        return getUnpackedNote(row, channel, note);
+
     uint32_t noteIndex = row * song->nChannels + channel;
 
     if (noteIndex < noteOffset) {
@@ -146,7 +159,37 @@ void XmTrackerPattern::nextNote(struct XmTrackerNote &note)
         return;
     }
 
-    uint8_t *buf = noteData;
+    offset += decodeNote(noteData, note);
+    noteOffset++;
+}
+
+void XmTrackerPattern::getUnpackedNote(uint16_t row, uint8_t channel, struct XmTrackerNote &note)
+{
+    /*
+     * The player asks for every channel of a row in order, so one
+     * flash read gets us all the notes in that row.
+     */
+    if (row != cachedRow) {
+        unsigned stride = song->nChannels * kNoteBytes;
+        SvmMemory::VirtAddr va = pattern.pData + row * stride;
+        if (!SvmMemory::copyROData(ref, rowData, va, stride)) {
+            LOG((LGPFX"Error: Could not copy %p (length %u)!\n",
+                     (void *)va, stride));
+            ASSERT(false);
+            resetNote(note);
+            return;
+        }
+        cachedRow = row;
+    }
+
+    decodeNote(rowData + channel * kNoteBytes, note);
+}
+
+unsigned XmTrackerPattern::decodeNote(const uint8_t *buf, struct XmTrackerNote &note)
+{
+    // Decode and clean up one note. Returns the number of bytes consumed.
+    unsigned length;
+
     if (*buf & 0x80) {
         uint8_t enc = *(buf++);
         // encoded note
@@ -156,7 +199,7 @@ void XmTrackerPattern::nextNote(struct XmTrackerNote &note)
         note.effectType =       enc & (1 << 3) ? *(buf++) : kNoEffect;
         note.effectParam =      enc & (1 << 4) ? *(buf++) : kNoParam;
         // If enc & 0x60 > 0 the pattern is likely corrupt, but follow Postel's Law.
-        offset += Intrinsic::POPCOUNT(enc & 0x9F);
+        length = Intrinsic::POPCOUNT(enc & 0x9F);
     } else {
         // unencoded note
         note.note =             *(buf++);
@@ -164,9 +207,8 @@ void XmTrackerPattern::nextNote(struct XmTrackerNote &note)
         note.volumeColumnByte = *(buf++);
         note.effectType =       *(buf++);
         note.effectParam =      *(buf++);
-        offset += 5;
+        length = kNoteBytes;
     }
-    noteOffset++;
 
     // If the effect parameter is set but the effect was not, it was intended to be an arpeggio (effect 0)
     if (note.effectType == kNoEffect && note.effectParam != kNoParam) {
@@ -206,4 +248,6 @@ void XmTrackerPattern::nextNote(struct XmTrackerNote &note)
         ASSERT(note.note);
         note.note = kNoNote;
     }
+
+    return length;
 }
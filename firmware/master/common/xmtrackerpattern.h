@@ -40,7 +40,7 @@ struct XmTrackerNote {
 
 class XmTrackerPattern {
 public:
-    XmTrackerPattern() : song(0) { memset(&pattern, 0, sizeof(pattern)); }
+    XmTrackerPattern() : song(0), unpacked(false) { memset(&pattern, 0, sizeof(pattern)); }
     uint16_t nRows() { return pattern.nRows; }
     void releaseRef() { ref.release(); }
 
@@ -64,7 +64,11 @@ public:
     static const uint8_t kNoParam = 0xFF;
     static const uint8_t kNoVolume = 0x55;
 private:
+    static const unsigned kNoteBytes = 5;   // Size of an unencoded note
+
     void nextNote(struct XmTrackerNote &note); // Pattern iterator
+    void getUnpackedNote(uint16_t row, uint8_t channel, struct XmTrackerNote &note);
+    unsigned decodeNote(const uint8_t *buf, struct XmTrackerNote &note);
 
     _SYSXMSong *song;
 
@@ -73,6 +77,14 @@ private:
 
     uint32_t noteOffset; // Index of next note within pattern
     uintptr_t offset;    // Offset of next note within pattern
+
+    /*
+     * Row cache, for songs with _SYS_XM_UNPACKED patterns. Includes
+     * one byte of slack, in case a malformed note claims to be encoded.
+     */
+    bool unpacked;
+    uint16_t cachedRow;
+    uint8_t rowData[_SYS_AUDIO_MAX_CHANNELS * kNoteBytes + 1];
 };
 
 #endif // XMTRACKERPATTERN_H_
@@ -0,0 +1,108 @@
+/*
+ * Sifteo SDK Example.
+ *
+ * Runs the same small particle simulation twice, once with Float2 vectors
+ * and once with Q16.16 fixed-point Fix16Vec2 vectors, and shows how long
+ * a frame of each one takes.
+ *
+ * Every floating point operation is a system call, so the float version
+ * pays for each add and multiply. The fixed-point version only uses
+ * integer instructions, plus the integer sine table for rotation.
+ */
+
+#include <sifteo.h>
+using namespace Sifteo;
+
+static Metadata M = Metadata()
+    .title("Fixed Point Benchmark")
+    .package("com.sifteo.sdk.fixedbench", "1.0")
+    .cubeRange(1);
+
+static const unsigned numParticles = 64;
+static const unsigned numFrames = 120;
+
+
+template <typename TScalar, typename TVec>
+struct Particles {
+    TVec pos[numParticles];
+    TVec vel[numParticles];
+
+    void init()
+    {
+        // Same seed for both versions, so they do the same work
+        Random r(1234);
+
+        for (unsigned i = 0; i < numParticles; ++i) {
+            pos[i] = vec<TScalar>(r.uniform(0, LCD_width), r.uniform(0, LCD_height));
+            vel[i] = vec<TScalar>(r.uniform(-2, 2), r.uniform(-2, 2));
+        }
+    }
+
+    void step(TScalar angle, TScalar speed)
+    {
+        const TScalar s = tsin(angle);
+        const TScalar c = tcos(angle);
+        const TScalar low = 0;
+        const TScalar high = LCD_width;
+
+        for (unsigned i = 0; i < numParticles; ++i) {
+            // Rotate the velocity, and keep the speed constant
+            TVec v = vel[i];
+            v = vec(v.x * c - v.y * s, v.x * s + v.y * c);
+            v = v * (speed / v.len());
+
+            // Move, and bounce off the edges of the screen
+            TVec p = pos[i] + v;
+            if (p.x < low || p.x > high)
+                v.x = -v.x;
+            if (p.y < low || p.y > high)
+                v.y = -v.y;
+
+            pos[i] = p;
+            vel[i] = v;
+        }
+    }
+};
+
+template <typename TScalar, typename TVec>
+TimeDelta benchmark(Particles<TScalar, TVec> &particles)
+{
+    particles.init();
+
+    SystemTime startTime = SystemTime::now();
+
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+        particles.step(0.05f, 1.5f);
+
+    return SystemTime::now() - startTime;
+}
+
+static void showResult(VideoBuffer &vid, int row, const char *label, TimeDelta elapsed)
+{
+    int usPerFrame = elapsed.nanoseconds() / (1000 * numFrames);
+
+    String<32> message;
+    message << label << Fixed(usPerFrame, 6) << " us";
+    LOG("%s\n", message.c_str());
+    vid.bg0rom.text(vec(0, row), message);
+}
+
+void main()
+{
+    static VideoBuffer vid;
+    vid.attach(0);
+    vid.initMode(BG0_ROM);
+
+    vid.bg0rom.text(vec(0,0), "Per frame:");
+    System::paint();
+
+    static Particles<float, Float2> floatParticles;
+    static Particles<Fix16, Fix16Vec2> fixedParticles;
+
+    showResult(vid, 2, "Float ", benchmark(floatParticles));
+    showResult(vid, 3, "Fix16 ", benchmark(fixedParticles));
+
+    // Kill time (efficiently)
+    while (1)
+        System::paint();
+}
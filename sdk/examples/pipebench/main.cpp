@@ -0,0 +1,109 @@
+/*
+ * Sifteo SDK Example.
+ *
+ * Throughput benchmark for the USB and Bluetooth data pipes. We keep our
+ * send queues full of sequence-numbered packets, and count and discard
+ * every packet we receive. Both directions use the zero-copy queue APIs,
+ * reserve()/commit() for sending and peek()/pop() for receiving.
+ *
+ * In Siftulator, run with --usb-pipe and/or --bt-pipe, and connect
+ * pipe-bench.py to the same ports. The script checks the sequence numbers
+ * and reports throughput in each direction.
+ */
+
+#include <sifteo.h>
+using namespace Sifteo;
+
+static Metadata M = Metadata()
+    .title("Pipe Benchmark")
+    .package("com.sifteo.sdk.pipebench", "1.0")
+    .cubeRange(1);
+
+static UsbPipe<16,16> usbPipe;
+static BluetoothPipe<16,16> btPipe;
+
+static UsbCounters usbCounters;
+static BluetoothCounters btCounters;
+
+static VideoBuffer vid;
+
+
+template <typename TPacket, typename TPipe>
+static void pump(TPipe &pipe, uint32_t &sequence)
+{
+    while (pipe.readAvailable()) {
+        // We only want the counters, so there's no need to look inside.
+        pipe.receiveQueue.pop();
+    }
+
+    while (pipe.writeAvailable()) {
+        TPacket &packet = pipe.sendQueue.reserve();
+
+        packet.setType(0);
+        packet.resize(packet.capacity());
+        uint8_t *bytes = packet.bytes();
+        bytes[0] = sequence;
+        bytes[1] = sequence >> 8;
+        bytes[2] = sequence >> 16;
+        bytes[3] = sequence >> 24;
+        sequence++;
+
+        pipe.sendQueue.commit();
+    }
+}
+
+template <typename TCounters>
+static void showCounters(int row, const char *label, TCounters &counters)
+{
+    counters.capture();
+
+    String<17> tx, rx;
+    tx << label << " TX " << counters.sentBytes();
+    rx << label << " RX " << counters.receivedBytes();
+    vid.bg0rom.text(vec(0, row), tx);
+    vid.bg0rom.text(vec(0, row + 1), rx);
+
+    LOG("%s: tx=%d bytes/s rx=%d bytes/s dropped=%d\n", label,
+        counters.sentBytes(), counters.receivedBytes(),
+        counters.userPacketsDropped());
+
+    counters.reset();
+}
+
+void main()
+{
+    vid.initMode(BG0_ROM);
+    vid.attach(0);
+    vid.bg0rom.text(vec(0,0), " Pipe Benchmark ", vid.bg0rom.WHITE_ON_TEAL);
+
+    bool haveBluetooth = Bluetooth::isAvailable();
+
+    usbPipe.attach();
+    usbCounters.reset();
+    if (haveBluetooth) {
+        btPipe.attach();
+        btCounters.reset();
+    }
+
+    uint32_t usbSequence = 0;
+    uint32_t btSequence = 0;
+    SystemTime nextReport = SystemTime::now() + TimeDelta(1.0f);
+
+    while (1) {
+        pump<UsbPacket>(usbPipe, usbSequence);
+        if (haveBluetooth)
+            pump<BluetoothPacket>(btPipe, btSequence);
+
+        if (SystemTime::now() < nextReport) {
+            System::yield();
+            continue;
+        }
+
+        // Once per second, show how many bytes moved in each direction
+        nextReport = nextReport + TimeDelta(1.0f);
+        showCounters(2, "USB", usbCounters);
+        if (haveBluetooth)
+            showCounters(5, "BT ", btCounters);
+        System::paint();
+    }
+}
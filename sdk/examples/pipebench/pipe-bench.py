@@ -0,0 +1,109 @@
+#!/usr/bin/env python
+
+#
+# Host side of the pipebench example, for use with Siftulator's socket-bridged
+# data pipes. Start Siftulator with "--usb-pipe PORT" and/or "--bt-pipe PORT",
+# then point this script at the same ports:
+#
+#   siftulator --headless --usb-pipe 2405 --bt-pipe 2406 pipebench.elf &
+#   python pipe-bench.py --usb 2405 --bt 2406 --seconds 10
+#
+# We send packets as fast as the simulated link will take them, and count
+# the packets coming back. Every device-to-host packet carries a sequence
+# number, so we can tell if any were lost or reordered. Exits nonzero on a
+# sequence error, so this can be used as a load test in CI.
+#
+# On the socket, each packet is a length byte followed by the packet data.
+#
+
+import socket, select, struct, sys, time
+from optparse import OptionParser
+
+USER_SUBSYS = 7
+
+class Link:
+    def __init__(self, name, port, header, maxPacket):
+        self.name = name
+        self.header = bytearray(header)
+        self.sock = socket.create_connection(('localhost', port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock.setblocking(0)
+
+        payload = bytearray(maxPacket - len(self.header))
+        packet = self.header + payload
+        self.txFrame = bytes(bytearray([len(packet)]) + packet)
+        self.txPending = b''
+        self.rxBuffer = bytearray()
+
+        self.txPackets = self.rxPackets = 0
+        self.txBytes = self.rxBytes = 0
+        self.nextSequence = None
+        self.errors = 0
+
+    def write(self):
+        if not self.txPending:
+            self.txPending = self.txFrame * 16
+        sent = self.sock.send(self.txPending)
+        self.txPending = self.txPending[sent:]
+        self.txBytes += sent
+
+    def read(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise IOError("%s pipe closed" % self.name)
+        self.rxBuffer.extend(bytearray(data))
+
+        while self.rxBuffer and len(self.rxBuffer) > self.rxBuffer[0]:
+            length = self.rxBuffer[0]
+            packet = self.rxBuffer[1:1 + length]
+            del self.rxBuffer[:1 + length]
+            self.packet(packet)
+
+    def packet(self, packet):
+        self.rxPackets += 1
+        self.rxBytes += len(packet)
+
+        payload = packet[len(self.header):]
+        if len(payload) < 4:
+            return
+        seq = struct.unpack('<I', bytes(payload[:4]))[0]
+        if self.nextSequence is not None and seq != self.nextSequence:
+            self.errors += 1
+            sys.stderr.write("%s: expected sequence %d, got %d\n" %
+                (self.name, self.nextSequence, seq))
+        self.nextSequence = (seq + 1) & 0xffffffff
+
+    def report(self, seconds):
+        print("%s: sent %.0f bytes/s, received %.0f bytes/s (%d packets), %d sequence errors" % (
+            self.name, self.txBytes / seconds, self.rxBytes / seconds,
+            self.rxPackets, self.errors))
+
+
+parser = OptionParser()
+parser.add_option("--usb", type="int", help="USB pipe port")
+parser.add_option("--bt", type="int", help="Bluetooth pipe port")
+parser.add_option("--seconds", type="float", default=10.0)
+(options, args) = parser.parse_args()
+
+links = []
+if options.usb:
+    links.append(Link("USB", options.usb, [0, 0, 0, USER_SUBSYS << 4], 64))
+if options.bt:
+    links.append(Link("Bluetooth", options.bt, [1], 20))
+if not links:
+    parser.error("No ports specified")
+
+start = time.time()
+while time.time() - start < options.seconds:
+    socks = dict((l.sock, l) for l in links)
+    r, w, x = select.select(socks.keys(), socks.keys(), [], 0.1)
+    for s in r:
+        socks[s].read()
+    for s in w:
+        socks[s].write()
+
+elapsed = time.time() - start
+for l in links:
+    l.report(elapsed)
+
+sys.exit(sum(l.errors for l in links) and 1 or 0)
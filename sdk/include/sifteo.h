@@ -36,6 +36,7 @@
 #include <sifteo/cube.h>
 #include <sifteo/event.h>
 #include <sifteo/filesystem.h>
+#include <sifteo/fixed.h>
 #include <sifteo/limits.h>
 #include <sifteo/macros.h>
 #include <sifteo/math.h>
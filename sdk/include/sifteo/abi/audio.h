@@ -94,6 +94,17 @@ struct _SYSXMInstrument {
     uint16_t volumeFadeout;         /// TODO
 };
 
+/*
+ * Flags for _SYSXMSong.
+ *
+ * _SYS_XM_UNPACKED means every note in every pattern is stored in the
+ * uncompressed 5-byte XM form, with "missing" fields replaced by values
+ * that decode identically. Each row is then a fixed-size span which the
+ * player can fetch all at once. This is still a valid packed XM pattern,
+ * so players that don't know about this flag can ignore it.
+ */
+#define _SYS_XM_UNPACKED        (1 << 0)
+
 struct _SYSXMSong {
     uint32_t patternOrderTable;     /// Flash address for the song's list of patterns to play
     uint16_t patternOrderTableSize; /// Size of patternOrderTable in bytes (1..256)
@@ -107,6 +118,7 @@ struct _SYSXMSong {
     uint32_t instruments;           /// Flash address for the instruments of the song
     
     uint8_t frequencyTable;         /// Which frequency table the track uses (0: Amiga, 1: Linear)
+    uint8_t flags;                  /// _SYS_XM_* flags
     uint16_t tempo;                 /// Default playback speed (ticks)
     uint16_t bpm;                   /// Default beats per minute (notes)
 };
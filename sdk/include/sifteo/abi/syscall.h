@@ -153,6 +153,19 @@ int32_t _SYS_tcosi(uint32_t a) _SC(181);
 uint32_t _SYS_tsinf(uint32_t a) _SC(182);
 uint32_t _SYS_tcosf(uint32_t a) _SC(183);
 
+// Batched floating point math. Each call replaces several of the compiler
+// floating point syscalls above. Float arguments and results are passed as
+// their bit patterns; two-element results are packed as (x | y << 32).
+uint32_t _SYS_vec2_dotf(uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by) _SC(199);
+uint32_t _SYS_vec3_dotf(uint32_t ax, uint32_t ay, uint32_t az, uint32_t bx, uint32_t by, uint32_t bz) _SC(200);
+void _SYS_vec3_crossf(struct _SYSFloat3 *out, uint32_t ax, uint32_t ay, uint32_t az, uint32_t bx, uint32_t by, uint32_t bz) _SC(201);
+uint64_t _SYS_vec2_normalizef(uint32_t x, uint32_t y) _SC(202);
+void _SYS_vec3_normalizef(struct _SYSFloat3 *v) _SC(203);
+uint64_t _SYS_mat2_transformf(const struct _SYSAffine2 *m, uint32_t x, uint32_t y) _SC(204);
+void _SYS_mat3_transformf(struct _SYSFloat3 *v, const float *m) _SC(205);
+uint32_t _SYS_polyf(uint32_t x, const float *coeff, uint32_t count) _SC(206);
+uint32_t _SYS_fexprf(const uint8_t *program, uint32_t length, const float *inputs, uint32_t numInputs) _SC(207);
+
 void _SYS_memset8(uint8_t *dest, uint8_t value, uint32_t count) _SC(44);
 void _SYS_memset16(uint16_t *dest, uint16_t value, uint32_t count) _SC(110);
 void _SYS_memset32(uint32_t *dest, uint32_t value, uint32_t count) _SC(49);
@@ -229,6 +242,7 @@ void _SYS_asset_loadFinish(struct _SYSAssetLoader *loader) _SC(146);
 uint32_t _SYS_asset_findInCache(struct _SYSAssetGroup *group, _SYSCubeIDVector cv) _SC(58);
 void _SYS_asset_bindSlots(_SYSVolumeHandle volume, unsigned numSlots) _SC(147);
 void _SYS_asset_loadCancel(struct _SYSAssetLoader *loader, _SYSCubeIDVector cv) _SC(148);
+void _SYS_asset_loadPrefetch(struct _SYSAssetLoader *loader, const struct _SYSAssetConfiguration *cfg, unsigned cfgSize, _SYSCubeIDVector cv) _SC(210);
 
 // Video buffers
 void _SYS_setVideoBuffer(_SYSCubeID cid, struct _SYSVideoBuffer *vbuf) _SC(61);
@@ -238,6 +252,8 @@ void _SYS_vbuf_unlock(struct _SYSVideoBuffer *vbuf) _SC(150);
 void _SYS_vbuf_poke(struct _SYSVideoBuffer *vbuf, uint16_t addr, uint16_t word) _SC(18);
 void _SYS_vbuf_pokeb(struct _SYSVideoBuffer *vbuf, uint16_t addr, uint8_t byte) _SC(31);
 void _SYS_vbuf_xorb(struct _SYSVideoBuffer *vbuf, uint16_t addr, uint8_t byte) _SC(29);
+void _SYS_vbuf_writeMasked(struct _SYSVideoBuffer *vbuf, uint16_t addr, uint16_t word, uint16_t mask) _SC(211);
+void _SYS_vbuf_bitblt(struct _SYSVideoBuffer *vbuf, uint32_t dstBit, const uint8_t *src, uint32_t bits, uint32_t lines, uint32_t srcStride, uint32_t dstStride) _SC(212);
 uint32_t _SYS_vbuf_peek(const struct _SYSVideoBuffer *vbuf, uint16_t addr) _SC(151);
 uint32_t _SYS_vbuf_peekb(const struct _SYSVideoBuffer *vbuf, uint16_t addr) _SC(34);
 void _SYS_vbuf_fill(struct _SYSVideoBuffer *vbuf, uint16_t addr, uint16_t word, uint16_t count) _SC(22);
@@ -274,6 +290,8 @@ int32_t _SYS_fs_objectWrite(unsigned key, const uint8_t *data, unsigned dataSize
 uint32_t _SYS_fs_runningVolume() _SC(168);
 uint32_t _SYS_fs_previousVolume() _SC(171);
 uint32_t _SYS_fs_info(_SYSFilesystemInfo *buffer, uint32_t bufferSize) _SC(172);
+void _SYS_fs_setWriteBehind(uint32_t enable) _SC(208);
+int32_t _SYS_fs_flush() _SC(209);
 
 // Bluetooth
 uint32_t _SYS_bt_isAvailable() _SC(188);
@@ -86,6 +86,41 @@ struct _SYSInt3 {
     int32_t x, y, z;
 };
 
+struct _SYSFloat3 {
+    float x, y, z;
+};
+
+/*
+ * Batched floating point math
+ *
+ * _SYSAffine2 has the same layout as Sifteo::AffineMatrix. Matrices for
+ * _SYS_mat3_transformf() are nine floats in column-major order.
+ *
+ * _SYS_fexprf() evaluates a straight-line expression on single-precision
+ * floats. Registers 0 through numInputs-1 are loaded from the inputs array,
+ * then each 3-byte instruction (opcode, register A, register B) writes its
+ * result to the next free register. The result of the last instruction is
+ * returned. Operations happen in program order with normal float rounding,
+ * so results are identical to issuing the operations one by one. Slinky
+ * generates these programs automatically from chains of float arithmetic.
+ */
+
+struct _SYSAffine2 {
+    float cx, cy;
+    float xx, xy;
+    float yx, yy;
+};
+
+#define _SYS_POLY_MAX_COEFF         16      // Max coefficients for _SYS_polyf()
+
+#define _SYS_FEXPR_MAX_REGS         32      // Max inputs plus instructions
+#define _SYS_FEXPR_INSN_BYTES       3       // Size of one instruction
+
+#define _SYS_FEXPR_ADD              0       // A + B
+#define _SYS_FEXPR_SUB              1       // A - B
+#define _SYS_FEXPR_MUL              2       // A * B
+#define _SYS_FEXPR_DIV              3       // A / B
+
 union _SYSByte4 {
     struct {
         int8_t x, y, z, w;
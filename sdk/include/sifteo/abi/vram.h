@@ -259,9 +259,19 @@ union _SYSVideoRAM {
  * without making any VRAM changes.
  *
  * This flag is set automatically by _SYS_vbuf_lock().
+ *
+ * Automatic Windowing
+ * -------------------
+ *
+ * If AUTO_WINDOW is set, the system owns the first_line and num_lines
+ * bytes in VRAM. Whenever it can prove that a frame only affects scanlines
+ * near the top of the display, it shrinks num_lines so that the cube only
+ * redraws those lines. Otherwise it uses the full screen. Clearing this
+ * flag restores the default full-screen window at the next paint.
  */
 
 #define _SYS_VBF_NEED_PAINT     (1 << 0)        // Request a paint operation
+#define _SYS_VBF_AUTO_WINDOW    (1 << 1)        // System manages first_line/num_lines
 // All other bits are reserved for system use.
 
 struct _SYSVideoBuffer {
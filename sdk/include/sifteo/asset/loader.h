@@ -322,6 +322,45 @@ struct AssetLoader {
         _SYS_asset_loadStart(*this, &configuration.begin()->sys, configuration.count(), cubes);
     }
 
+    /**
+     * @brief Hint that an AssetConfiguration will probably be started soon
+     *
+     * This lets the system get a head start on an upcoming start(), for
+     * example by prefetching the next level's assets while the current
+     * level is still being played. Prefetching happens in the background,
+     * using only radio bandwidth that isn't needed for anything else, and it
+     * does not show up in busyCubes(), progress, or asset-done events.
+     *
+     * A prefetch never erases an AssetSlot, and never changes the contents
+     * of any tiles which are already in use. If the whole configuration
+     * doesn't fit in the free space on a cube, nothing is prefetched on
+     * that cube.
+     *
+     * When you later call start() with this configuration, any groups that
+     * were already prefetched are found in the cache, and don't need to be
+     * sent again. If you start() a different configuration instead, or
+     * call cancel() or finish(), the prefetch is dropped.
+     *
+     * Each prefetched group is installed in its AssetSlot as soon as it
+     * finishes loading, not when you call start(). Groups from a dropped
+     * prefetch stay in the cache and use slot space, just like groups from
+     * any other load. A later start() of a different configuration may
+     * therefore need to erase that slot sooner than it otherwise would.
+     *
+     * Cubes which are already busy with a start() are not affected. A new
+     * prefetch replaces any earlier prefetch on the same cubes.
+     *
+     * Like start(), the AssetConfiguration is referred to by address,
+     * and it must stay in scope until you call start() or finish().
+     */
+    template < typename T >
+    void prefetch(T& configuration, _SYSCubeIDVector cubes = -1)
+    {
+        STATIC_ASSERT(CUBE_ALLOCATION <= _SYS_NUM_CUBE_SLOTS);
+        cubes &= 0xFFFFFFFF << (32 - CUBE_ALLOCATION);
+        _SYS_asset_loadPrefetch(*this, &configuration.begin()->sys, configuration.count(), cubes);
+    }
+
     /**
      * @brief Measures progress on a single cube, as an integer
      *
@@ -69,6 +69,9 @@ namespace Sifteo {
  * a write, future reads will continue to return the last successfully-written
  * version of an object.
  *
+ * Games which save several small objects at once can opt in to write-behind
+ * buffering with setWriteBehind(). See its documentation for details.
+ *
  * Object sizes must be at least one byte, and no more than MAX_SIZE bytes.
  */
 
@@ -161,6 +164,10 @@ public:
      * If power fails during a write, by design subsequent reads will
      * return the last successfully-saved version of that object.
      *
+     * With setWriteBehind() enabled, this may also report that an earlier
+     * buffered write failed to save. In that case, this write is not
+     * performed and may be retried.
+     *
      * @return size of the data written, or < 0 on failure. The following
      * results indicate a specific failure mode:
      *
@@ -178,6 +185,45 @@ public:
         return write(0, 0);
     }
 
+    /**
+     * @brief Enable or disable write-behind buffering of small writes
+     *
+     * With write-behind enabled, small objects written by this game are
+     * held in RAM for a short time before being saved to flash. Writing the
+     * same object again while it's still buffered replaces the buffered
+     * copy, and buffered objects are saved together. This reduces both the
+     * time spent in write() and the wear on flash memory.
+     *
+     * Reads from this game always return the newest data, buffered or not.
+     * The buffer is saved automatically when the system is idle, when the
+     * game exits, and at shutdown. Call flush() to save it immediately.
+     *
+     * If power fails, any objects which were still buffered will read back
+     * as their previous versions. Write-behind is disabled by default, and
+     * disabling it flushes the buffer.
+     *
+     * If an automatic save fails, the error is reported once, by this
+     * game's next write() or flush(). Objects which weren't saved read
+     * back as their previous versions, so write them again.
+     */
+    static void setWriteBehind(bool enable) {
+        _SYS_fs_setWriteBehind(enable);
+    }
+
+    /**
+     * @brief Save any objects buffered by setWriteBehind() to flash now
+     *
+     * @return zero on success, or < 0 if any object couldn't be saved,
+     * either now or during an earlier automatic save which hasn't been
+     * reported yet. The following results indicate a specific failure mode:
+     *
+     *  * _SYS_ENOENT - This game's volume no longer exists
+     *  * _SYS_ENOSPC - No space left on device
+     */
+    static int flush() {
+        return _SYS_fs_flush();
+    }
+
     /**
      * @brief Template wrapper for read() of fixed-size objects.
      *
@@ -0,0 +1,423 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo SDK
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+#ifdef NOT_USERSPACE
+#   error This is a userspace-only header, not allowed by the current build.
+#endif
+
+#include <sifteo/abi.h>
+#include <sifteo/macros.h>
+#include <sifteo/math.h>
+
+namespace Sifteo {
+
+/**
+ * @addtogroup math
+ * @{
+ */
+
+/**
+ * @brief Wider integer types and limits, used internally by FixedPoint.
+ */
+
+template <typename T> struct FixedPointTraits {};
+
+template <> struct FixedPointTraits<int8_t> {
+    typedef int32_t Wide;
+    static int8_t minimum() { return -0x80; }
+    static int8_t maximum() { return 0x7F; }
+};
+
+template <> struct FixedPointTraits<int16_t> {
+    typedef int32_t Wide;
+    static int16_t minimum() { return -0x8000; }
+    static int16_t maximum() { return 0x7FFF; }
+};
+
+template <> struct FixedPointTraits<int32_t> {
+    typedef int64_t Wide;
+    static int32_t minimum() { return -0x7FFFFFFF - 1; }
+    static int32_t maximum() { return 0x7FFFFFFF; }
+};
+
+/**
+ * @brief A signed fixed-point number.
+ *
+ * The value is stored in an integer of type T, with the low F bits to the
+ * right of the binary point. So, FixedPoint<int32_t, 16> is a Q16.16 number,
+ * and FixedPoint<int16_t, 8> is Q8.8. At most 16 fractional bits are supported.
+ *
+ * Fixed-point arithmetic uses only integer instructions. On Sifteo
+ * hardware, every floating point operation is a system call, so fixed
+ * point math is much faster wherever its limited range and precision are
+ * acceptable.
+ *
+ * If SATURATE is true, results which overflow are clamped to the largest
+ * or smallest representable value instead of wrapping around. This is
+ * somewhat slower, since it needs wider intermediate results.
+ *
+ * Conversions from int, float, and double are implicit. When the value is
+ * a compile-time constant, as in "Fix16 half = 0.5f", the conversion is
+ * folded into a constant by the compiler and no floating point math
+ * happens at runtime. Conversion back to int or float is explicit, with
+ * toInt(), round(), and toFloat().
+ *
+ * Fixed-point numbers may be used in Vector2 and Vector3. See the
+ * Fix16Vec2 and related typedefs.
+ */
+
+template <typename T, unsigned F, bool SATURATE = false>
+struct FixedPoint {
+    typedef typename FixedPointTraits<T>::Wide Wide;
+
+    T raw;  ///< Underlying integer representation, scaled by 2^F
+
+    /// Create an uninitialized fixed-point number
+    FixedPoint() {}
+
+    /// Convert from an integer
+    FixedPoint(int i) : raw(shlRaw(i, F)) {}
+
+    /// Convert from an unsigned integer
+    FixedPoint(unsigned i) : raw(shlRaw(i, F)) {}
+
+    /// Convert from a single-precision float, rounding to nearest
+    FixedPoint(float f) : raw(fromFloat(f * float(one()) + (f < 0 ? -0.5f : 0.5f))) {}
+
+    /// Convert from a double-precision float, rounding to nearest
+    FixedPoint(double f) : raw(fromFloat(f * double(one()) + (f < 0 ? -0.5 : 0.5))) {}
+
+    /// Create a fixed-point number from its raw integer representation
+    static FixedPoint fromRaw(T r) {
+        FixedPoint result;
+        result.raw = r;
+        return result;
+    }
+
+    /**
+     * @brief Create a fixed-point number from an integer ratio, num/den.
+     *
+     * This is computed with integer math only. For constant arguments,
+     * it's evaluated at compile time.
+     */
+    static FixedPoint fromRatio(int num, int den) {
+        return fromRaw(fromWide((Wide(num) << F) / den));
+    }
+
+    /// Convert to an integer, rounding toward negative infinity
+    int toInt() const {
+        return raw >> F;
+    }
+
+    /// Convert to an integer, rounding to nearest
+    int round() const {
+        // Round up if the highest fractional bit is set
+        return (raw >> F) + ((raw >> (F - 1)) & 1);
+    }
+
+    /// Convert to a single-precision float
+    float toFloat() const {
+        return raw * (1.0f / one());
+    }
+
+    /// Convert to another fixed-point format
+    template <typename R, unsigned G, bool S> FixedPoint<R, G, S> convert() const {
+        typedef FixedPoint<R, G, S> Result;
+        const unsigned up = G > F ? G - F : 0;
+        const unsigned down = F > G ? F - G : 0;
+        return Result::fromRaw(Result::fromWide(
+            (typename Result::Wide(raw) << up) >> down));
+    }
+
+    /// The value 1.0, in raw form
+    static T one() {
+        return T(1) << F;
+    }
+
+    /// The smallest representable value
+    static FixedPoint minimum() {
+        return fromRaw(FixedPointTraits<T>::minimum());
+    }
+
+    /// The largest representable value
+    static FixedPoint maximum() {
+        return fromRaw(FixedPointTraits<T>::maximum());
+    }
+
+    /// Narrow a wide intermediate result, saturating if necessary
+    static T fromWide(Wide w) {
+        STATIC_ASSERT(F >= 1 && F <= 16 && F < sizeof(T) * 8);
+        if (SATURATE) {
+            if (w < Wide(FixedPointTraits<T>::minimum()))
+                return FixedPointTraits<T>::minimum();
+            if (w > Wide(FixedPointTraits<T>::maximum()))
+                return FixedPointTraits<T>::maximum();
+        }
+        return T(w);
+    }
+
+    /*
+     * Without saturation, the raw operations below can stay in T's own
+     * width. On Sifteo hardware, 64-bit multiplies and shifts are system
+     * calls, so this matters for 32-bit fixed-point types.
+     */
+
+    /// Convert a rounded float, saturating if necessary
+    template <typename FP> static T fromFloat(FP f) {
+        if (SATURATE)
+            return fromWide(Wide(f));
+        return T(int32_t(f));
+    }
+
+    /// Raw add, returning a + b
+    static T addRaw(T a, T b) {
+        if (SATURATE)
+            return fromWide(Wide(a) + Wide(b));
+        return T(uint32_t(a) + uint32_t(b));
+    }
+
+    /// Raw subtract, returning a - b
+    static T subRaw(T a, T b) {
+        if (SATURATE)
+            return fromWide(Wide(a) - Wide(b));
+        return T(uint32_t(a) - uint32_t(b));
+    }
+
+    /// Raw scale by an integer, returning a * k
+    static T scaleRaw(T a, int k) {
+        if (SATURATE)
+            return fromWide(Wide(a) * Wide(k));
+        return T(uint32_t(a) * uint32_t(k));
+    }
+
+    /// Raw left shift, returning a << shift
+    static T shlRaw(int32_t a, unsigned shift) {
+        if (SATURATE)
+            return fromWide(Wide(a) << shift);
+        return T(uint32_t(a) << shift);
+    }
+
+    /// Raw multiply, returning (a * b) >> F
+    static T mulRaw(T a, T b) {
+        if (SATURATE || sizeof(T) < sizeof(int32_t))
+            return fromWide((Wide(a) * Wide(b)) >> F);
+
+        /*
+         * Build the product from 32-bit partial products. The low partial
+         * product is unsigned, and the rest are exact, so this rounds
+         * just like the wide version.
+         */
+
+        const uint32_t mask = (uint32_t(1) << F) - 1;
+        int32_t aH = int32_t(a) >> F, bH = int32_t(b) >> F;
+        uint32_t aL = uint32_t(a) & mask, bL = uint32_t(b) & mask;
+
+        return T((uint32_t(aH * bH) << F)
+            + uint32_t(aH * int32_t(bL)) + uint32_t(int32_t(aL) * bH)
+            + ((aL * bL) >> F));
+    }
+
+    /// Raw divide, returning (a << F) / b
+    static T divRaw(T a, T b) {
+        return fromWide((Wide(a) << F) / b);
+    }
+
+    FixedPoint operator- () const {
+        return fromRaw(subRaw(0, raw));
+    }
+
+    FixedPoint operator+= (FixedPoint b) { raw = addRaw(raw, b.raw); return *this; }
+    FixedPoint operator-= (FixedPoint b) { raw = subRaw(raw, b.raw); return *this; }
+    FixedPoint operator*= (FixedPoint b) { raw = mulRaw(raw, b.raw); return *this; }
+    FixedPoint operator/= (FixedPoint b) { raw = divRaw(raw, b.raw); return *this; }
+    FixedPoint operator*= (int k) { raw = scaleRaw(raw, k); return *this; }
+    FixedPoint operator/= (int k) { raw /= k; return *this; }
+
+    FixedPoint operator<< (unsigned shift) const { return fromRaw(shlRaw(raw, shift)); }
+    FixedPoint operator>> (unsigned shift) const { return fromRaw(raw >> shift); }
+
+    friend FixedPoint operator+ (FixedPoint a, FixedPoint b) { return fromRaw(addRaw(a.raw, b.raw)); }
+    friend FixedPoint operator- (FixedPoint a, FixedPoint b) { return fromRaw(subRaw(a.raw, b.raw)); }
+    friend FixedPoint operator* (FixedPoint a, FixedPoint b) { return fromRaw(mulRaw(a.raw, b.raw)); }
+    friend FixedPoint operator/ (FixedPoint a, FixedPoint b) { return fromRaw(divRaw(a.raw, b.raw)); }
+
+    // Scaling by an integer doesn't need a fixed-point multiply or divide
+    friend FixedPoint operator* (FixedPoint a, int k) { return fromRaw(scaleRaw(a.raw, k)); }
+    friend FixedPoint operator* (int k, FixedPoint a) { return fromRaw(scaleRaw(a.raw, k)); }
+    friend FixedPoint operator/ (FixedPoint a, int k) { return fromRaw(a.raw / k); }
+
+    // Floating point operands are converted, rather than matching the int versions
+    friend FixedPoint operator* (FixedPoint a, float k) { return a * FixedPoint(k); }
+    friend FixedPoint operator* (float k, FixedPoint a) { return a * FixedPoint(k); }
+    friend FixedPoint operator/ (FixedPoint a, float k) { return a / FixedPoint(k); }
+    friend FixedPoint operator* (FixedPoint a, double k) { return a * FixedPoint(k); }
+    friend FixedPoint operator* (double k, FixedPoint a) { return a * FixedPoint(k); }
+    friend FixedPoint operator/ (FixedPoint a, double k) { return a / FixedPoint(k); }
+
+    friend bool operator== (FixedPoint a, FixedPoint b) { return a.raw == b.raw; }
+    friend bool operator!= (FixedPoint a, FixedPoint b) { return a.raw != b.raw; }
+    friend bool operator<  (FixedPoint a, FixedPoint b) { return a.raw <  b.raw; }
+    friend bool operator<= (FixedPoint a, FixedPoint b) { return a.raw <= b.raw; }
+    friend bool operator>  (FixedPoint a, FixedPoint b) { return a.raw >  b.raw; }
+    friend bool operator>= (FixedPoint a, FixedPoint b) { return a.raw >= b.raw; }
+};
+
+typedef FixedPoint<int32_t, 16>         Fix16;      ///< Q16.16 fixed-point number
+typedef FixedPoint<int16_t, 8>          Fix8;       ///< Q8.8 fixed-point number
+typedef FixedPoint<int32_t, 16, true>   SatFix16;   ///< Saturating Q16.16 fixed-point number
+typedef FixedPoint<int16_t, 8, true>    SatFix8;    ///< Saturating Q8.8 fixed-point number
+
+typedef Vector2<Fix16>                 Fix16Vec2;  ///< Typedef for a 2-vector of Q16.16 numbers
+typedef Vector3<Fix16>                 Fix16Vec3;  ///< Typedef for a 3-vector of Q16.16 numbers
+typedef Vector2<Fix8>                  Fix8Vec2;   ///< Typedef for a 2-vector of Q8.8 numbers
+typedef Vector3<Fix8>                  Fix8Vec3;   ///< Typedef for a 3-vector of Q8.8 numbers
+
+/**
+ * @brief Fixed-point square root
+ *
+ * Uses an integer-only bit-by-bit square root. Negative inputs return zero.
+ * For 32-bit types this needs 64-bit intermediate values.
+ */
+
+template <typename T, unsigned F, bool S>
+inline FixedPoint<T, F, S> sqrt(FixedPoint<T, F, S> x)
+{
+    typedef typename FixedPoint<T, F, S>::Wide Wide;
+
+    if (x.raw <= 0)
+        return FixedPoint<T, F, S>::fromRaw(0);
+
+    // sqrt(raw / 2^F) * 2^F == sqrt(raw << F)
+    Wide n = Wide(x.raw) << F;
+    Wide bit = Wide(1) << (sizeof(Wide) * 8 - 2);
+    Wide result = 0;
+
+    while (bit > n)
+        bit >>= 2;
+
+    while (bit) {
+        if (n >= result + bit) {
+            n -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return FixedPoint<T, F, S>::fromRaw(T(result));
+}
+
+/**
+ * @brief Convert a fixed-point angle in radians to tsini() units.
+ *
+ * There are 8192 units per full circle.
+ */
+
+template <typename T, unsigned F, bool S>
+inline int fixedAngleToTrig(FixedPoint<T, F, S> angle)
+{
+    // 8192 / (2 * pi), in Q16.16
+    const Fix16 scale = Fix16::fromRaw(85445659);
+    Fix16 a = Fix16::fromRaw(int32_t(angle.raw) << (16 - F));
+    return (a * scale).toInt();
+}
+
+/**
+ * @brief Fixed-point sine, with the angle in radians.
+ *
+ * This is built on the integer lookup table used by tsini(), and never
+ * uses floating point. Accuracy is comparable to tsin().
+ */
+
+template <typename T, unsigned F, bool S>
+inline FixedPoint<T, F, S> tsin(FixedPoint<T, F, S> angle)
+{
+    return FixedPoint<T, F, S>::fromRaw(T(tsini(fixedAngleToTrig(angle)) >> (16 - F)));
+}
+
+/**
+ * @brief Fixed-point cosine, with the angle in radians.
+ *
+ * This is built on the integer lookup table used by tcosi(), and never
+ * uses floating point. Accuracy is comparable to tcos().
+ */
+
+template <typename T, unsigned F, bool S>
+inline FixedPoint<T, F, S> tcos(FixedPoint<T, F, S> angle)
+{
+    return FixedPoint<T, F, S>::fromRaw(T(tcosi(fixedAngleToTrig(angle)) >> (16 - F)));
+}
+
+/*
+ * Fixed-point vector scaling. These are more specific than the
+ * generic int and float promotions in math.h, which produce Int2 and
+ * Float2 results.
+ */
+
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*(FixedPoint<T,F,S> k, Vector2<FixedPoint<T,F,S> > v) { return vec(k*v.x, k*v.y); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*(Vector2<FixedPoint<T,F,S> > v, FixedPoint<T,F,S> k) { return vec(k*v.x, k*v.y); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator/(Vector2<FixedPoint<T,F,S> > v, FixedPoint<T,F,S> k) { return vec(v.x/k, v.y/k); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*(int k, Vector2<FixedPoint<T,F,S> > v) { return vec(k*v.x, k*v.y); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*(Vector2<FixedPoint<T,F,S> > v, int k) { return vec(k*v.x, k*v.y); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator/(Vector2<FixedPoint<T,F,S> > v, int k) { return vec(v.x/k, v.y/k); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*=(Vector2<FixedPoint<T,F,S> > &u, FixedPoint<T,F,S> k) { return vec(u.x*=k, u.y*=k); }
+template <typename T, unsigned F, bool S> inline Vector2<FixedPoint<T,F,S> > operator*=(Vector2<FixedPoint<T,F,S> > &u, int k) { return vec(u.x*=k, u.y*=k); }
+
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*(FixedPoint<T,F,S> k, Vector3<FixedPoint<T,F,S> > v) { return vec(k*v.x, k*v.y, k*v.z); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*(Vector3<FixedPoint<T,F,S> > v, FixedPoint<T,F,S> k) { return vec(k*v.x, k*v.y, k*v.z); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator/(Vector3<FixedPoint<T,F,S> > v, FixedPoint<T,F,S> k) { return vec(v.x/k, v.y/k, v.z/k); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*(int k, Vector3<FixedPoint<T,F,S> > v) { return vec(k*v.x, k*v.y, k*v.z); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*(Vector3<FixedPoint<T,F,S> > v, int k) { return vec(k*v.x, k*v.y, k*v.z); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator/(Vector3<FixedPoint<T,F,S> > v, int k) { return vec(v.x/k, v.y/k, v.z/k); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*=(Vector3<FixedPoint<T,F,S> > &u, FixedPoint<T,F,S> k) { return vec(u.x*=k, u.y*=k, u.z*=k); }
+template <typename T, unsigned F, bool S> inline Vector3<FixedPoint<T,F,S> > operator*=(Vector3<FixedPoint<T,F,S> > &u, int k) { return vec(u.x*=k, u.y*=k, u.z*=k); }
+
+/**
+ * @brief Convert a fixed-point vector to a Float2
+ */
+
+template <typename T, unsigned F, bool S>
+inline Float2 toFloat(Vector2<FixedPoint<T,F,S> > v)
+{
+    return vec(v.x.toFloat(), v.y.toFloat());
+}
+
+/**
+ * @brief Convert a fixed-point vector to an Int2, rounding toward negative infinity
+ */
+
+template <typename T, unsigned F, bool S>
+inline Int2 toInt(Vector2<FixedPoint<T,F,S> > v)
+{
+    return vec(v.x.toInt(), v.y.toInt());
+}
+
+/**
+ * @} endgroup math
+ */
+
+}   // namespace Sifteo
@@ -344,6 +344,21 @@ float inline tcos(float x)
     return reinterpret_cast<float&>(r);
 }
 
+/**
+ * @brief Evaluate a polynomial
+ *
+ * Returns coeff[0] + coeff[1]*x + coeff[2]*x^2 + ..., for 'count'
+ * coefficients. This is evaluated in a single system call, which is
+ * much faster than evaluating the same polynomial one multiply and add
+ * at a time. At most 16 coefficients are allowed.
+ */
+
+inline float poly(float x, const float *coeff, unsigned count)
+{
+    uint32_t r = _SYS_polyf(reinterpret_cast<uint32_t&>(x), coeff, count);
+    return reinterpret_cast<float&>(r);
+}
+
 /**
  * @brief Integer sine table lookup
  *
@@ -665,6 +680,20 @@ template <typename T> inline T dot(Vector2<T> u, Vector2<T> v) {
     return u.x * v.x + u.y * v.y;
 }
 
+/// Vector dot-product, specialized for floats to use a single system call
+template <> inline float dot<float>(Float2 u, Float2 v) {
+    uint32_t r = _SYS_vec2_dotf(reinterpret_cast<uint32_t&>(u.x), reinterpret_cast<uint32_t&>(u.y),
+                                reinterpret_cast<uint32_t&>(v.x), reinterpret_cast<uint32_t&>(v.y));
+    return reinterpret_cast<float&>(r);
+}
+
+/// Float vector normalization, specialized to use a single system call
+template <> inline Float2 Float2::normalize() const {
+    uint64_t r = _SYS_vec2_normalizef(reinterpret_cast<const uint32_t&>(x),
+                                      reinterpret_cast<const uint32_t&>(y));
+    return reinterpret_cast<Float2&>(r);
+}
+
 /// Convert polar to cartesian
 template <typename T> inline Vector2<T> polar(T angle, T magnitude) {
     Vector2<T> result;
@@ -864,6 +893,21 @@ template <typename T> inline T dot(Vector3<T> u, Vector3<T> v) {
     return u.x * v.x + u.y * v.y + u.z * v.z;
 }
 
+/// Vector dot-product, specialized for floats to use a single system call
+template <> inline float dot<float>(Float3 u, Float3 v) {
+    uint32_t r = _SYS_vec3_dotf(reinterpret_cast<uint32_t&>(u.x), reinterpret_cast<uint32_t&>(u.y),
+                                reinterpret_cast<uint32_t&>(u.z), reinterpret_cast<uint32_t&>(v.x),
+                                reinterpret_cast<uint32_t&>(v.y), reinterpret_cast<uint32_t&>(v.z));
+    return reinterpret_cast<float&>(r);
+}
+
+/// Float vector normalization, specialized to use a single system call
+template <> inline Float3 Float3::normalize() const {
+    Float3 r = *this;
+    _SYS_vec3_normalizef(reinterpret_cast<_SYSFloat3*>(&r));
+    return r;
+}
+
 /// Vector cross-product
 template <typename T> inline T cross(T u, T v) {
     return vec(u.y * v.z - u.z * v.y,
@@ -871,6 +915,16 @@ template <typename T> inline T cross(T u, T v) {
                u.x * v.y - u.y * v.x);
 }
 
+/// Float vector cross-product, using a single system call
+inline Float3 cross(Float3 u, Float3 v) {
+    Float3 r;
+    _SYS_vec3_crossf(reinterpret_cast<_SYSFloat3*>(&r),
+                     reinterpret_cast<uint32_t&>(u.x), reinterpret_cast<uint32_t&>(u.y),
+                     reinterpret_cast<uint32_t&>(u.z), reinterpret_cast<uint32_t&>(v.x),
+                     reinterpret_cast<uint32_t&>(v.y), reinterpret_cast<uint32_t&>(v.z));
+    return r;
+}
+
 // Vector operations
 template <typename T> inline Vector3<T> operator-(Vector3<T> u) { return vec<T>(-u.x, -u.y, -u.z); }
 template <typename T> inline Vector3<T> operator+=(Vector3<T> &u, Vector3<T> v) { return vec<T>(u.x+=v.x, u.y+=v.y, u.z+=v.z); }
@@ -1122,6 +1176,14 @@ struct AffineMatrix {
     void scale(float s) {
         *this *= scaling(s);
     }
+
+    /// Apply this matrix to a point, in a single system call
+    Float2 transform(Float2 v) const {
+        uint64_t r = _SYS_mat2_transformf(reinterpret_cast<const _SYSAffine2*>(this),
+                                          reinterpret_cast<uint32_t&>(v.x),
+                                          reinterpret_cast<uint32_t&>(v.y));
+        return reinterpret_cast<Float2&>(r);
+    }
 };
 
 /**
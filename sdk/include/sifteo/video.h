@@ -209,6 +209,30 @@ struct VideoBuffer {
         setWindow(0, LCD_height);
     }
 
+    /**
+     * @brief Let the system choose a drawing window automatically.
+     *
+     * When enabled, each frame redraws only the scanlines the system can
+     * prove have changed since the previous frame, starting at the top of
+     * the display. Small updates, like a status bar or a score counter near
+     * the top of the screen, become much cheaper to render. Anything the
+     * system can't reason about, such as panning or a mode change, falls
+     * back to a full-screen frame.
+     *
+     * While this is enabled, the system owns the drawing window. Calls to
+     * setWindow() will be overridden. Disabling automatic windowing restores
+     * the default full-screen window at the next paint.
+     *
+     * Must be called after attach(), since attaching resets this flag.
+     */
+    void setAutoWindow(bool enabled = true) {
+        if (enabled)
+            __sync_fetch_and_or(&sys.vbuf.flags, _SYS_VBF_AUTO_WINDOW);
+        else
+            __sync_fetch_and_and(&sys.vbuf.flags, ~_SYS_VBF_AUTO_WINDOW);
+        touch();
+    }
+
     /**
      * @brief Like setWindow(), but change only the first line.
      */
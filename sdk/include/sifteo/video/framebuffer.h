@@ -115,17 +115,23 @@ struct FBDrawable {
     {
         ASSERT(pos.x <= tWidth && pos.y <= tHeight);
 
-        const unsigned pixelsPerByte = 8 / tBitsPerPixel;
-        const unsigned bytesPerLine = tWidth / pixelsPerByte;
-        const unsigned xByte = pos.x / pixelsPerByte;
-        const unsigned xBit = (pos.x % pixelsPerByte) * tBitsPerPixel;
-        const unsigned byteAddr = xByte + pos.y * bytesPerLine;
-        const unsigned pixelMask = ((1 << tBitsPerPixel) - 1) << xBit;
-
-        uint8_t byte = _SYS_vbuf_peekb(&sys.vbuf, byteAddr);
-        byte &= ~pixelMask;
-        byte |= colorIndex << xBit;
-        _SYS_vbuf_pokeb(&sys.vbuf, byteAddr, byte);
+        // Lines needn't be a whole number of words (STAMP widths are only even)
+        const unsigned bit = bitAddr(pos);
+        const unsigned pixelMask = (1 << tBitsPerPixel) - 1;
+
+        _SYS_vbuf_writeMasked(&sys.vbuf, bit >> 4,
+            colorIndex << (bit & 15), pixelMask << (bit & 15));
+    }
+
+    /**
+     * @brief Return the VRAM address of a pixel, in bits.
+     *
+     * Pixels are packed LSB-first, so this is also the address of the
+     * pixel's least significant bit.
+     */
+    static unsigned bitAddr(UInt2 pos)
+    {
+        return (pos.x + pos.y * tWidth) * tBitsPerPixel;
     }
 
     /**
@@ -158,14 +164,13 @@ struct FBDrawable {
         ASSERT(pos.x <= tWidth && width <= tWidth &&
             (pos.x + width) <= tWidth && pos.y < tHeight);
 
-        const unsigned pixelsPerWord = 16 / tBitsPerPixel;
-        const unsigned wordsPerLine = tWidth / pixelsPerWord;
         const unsigned colorWord = expand16(colorIndex);
 
         // Calculate a base address in words, and
         // left/right boundaries relative to that in bits.
-        unsigned addr = pos.x / pixelsPerWord + pos.y * wordsPerLine;
-        int start = (pos.x % pixelsPerWord) * tBitsPerPixel;
+        unsigned bit = bitAddr(pos);
+        unsigned addr = bit >> 4;
+        int start = bit & 15;
         int end = start + width * tBitsPerPixel;
 
         while (end > 0) {
@@ -183,10 +188,7 @@ struct FBDrawable {
                 // One partial word. (The first, last or only word)
 
                 unsigned mask = bitRange<uint16_t>(start, end);
-                unsigned word = _SYS_vbuf_peek(&sys.vbuf, addr);
-                word &= ~mask;
-                word |= colorWord & mask;
-                _SYS_vbuf_poke(&sys.vbuf, addr, word);
+                _SYS_vbuf_writeMasked(&sys.vbuf, addr, colorWord, mask);
                 addr++;
                 start -= 16;
                 end -= 16;
@@ -228,47 +230,8 @@ struct FBDrawable {
         ASSERT(pos.x <= tWidth && width <= tWidth &&
             (pos.x + width) <= tWidth && pos.y < tHeight);
 
-        const unsigned pixelsPerByte = 8 / tBitsPerPixel;
-        const unsigned bytesPerLine = tWidth / pixelsPerByte;
-
-        // Base address in bits
-        unsigned addr = pos.x / pixelsPerByte + pos.y * bytesPerLine;
-
-        // Bitmap alignment
-        unsigned shift = (pos.x % pixelsPerByte) * tBitsPerPixel;
-        unsigned invShift = 8 - shift;
-
-        // Initial mask range, in bits, relative to the base address
-        int start = shift;
-        int end = start + width * tBitsPerPixel;
-
-        while (end > 0) {
-            // One source byte at a time, splatted to either one or two
-            // destination bytes in VRAM.
-
-            uint8_t source = *data;
-            data++;
-
-            // First byte
-            unsigned mask = (0xFF << shift) & bitRange<uint16_t>(start, end);
-            unsigned byte = _SYS_vbuf_peekb(&sys.vbuf, addr);
-            byte &= ~mask;
-            byte |= (source << shift) & mask;
-            _SYS_vbuf_pokeb(&sys.vbuf, addr, byte);
-
-            addr++;
-            start -= 8;
-            end -= 8;
-
-            // Optional second byte
-            if (shift) {
-                unsigned mask = (0xFF >> invShift) & bitRange<uint16_t>(start, end);
-                unsigned byte = _SYS_vbuf_peekb(&sys.vbuf, addr);
-                byte &= ~mask;
-                byte |= (source >> invShift) & mask;
-                _SYS_vbuf_pokeb(&sys.vbuf, addr, byte);
-            }
-        }
+        _SYS_vbuf_bitblt(&sys.vbuf, bitAddr(pos), data,
+            width * tBitsPerPixel, 1, 0, 0);
     }
 
     /**
@@ -285,12 +248,11 @@ struct FBDrawable {
      */
     void bitmap(UInt2 topLeft, UInt2 size, const uint8_t *data, unsigned stride)
     {
-        while (size.y) {
-            bitmapSpan(topLeft, size.x, data);
-            size.y--;
-            topLeft.y++;
-            data += stride;
-        }
+        ASSERT(topLeft.x <= tWidth && size.x <= tWidth &&
+            (topLeft.x + size.x) <= tWidth && (topLeft.y + size.y) <= tHeight);
+
+        _SYS_vbuf_bitblt(&sys.vbuf, bitAddr(topLeft), data,
+            size.x * tBitsPerPixel, size.y, stride, tWidth * tBitsPerPixel);
     }
 
     /**
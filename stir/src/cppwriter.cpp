@@ -573,6 +573,7 @@ void CPPSourceWriter::writeTracker(const Tracker &tracker)
     indent << "/* nInstruments          */ " << (uint32_t)song.nInstruments << ",\n" <<
     indent << "/* instruments           */ reinterpret_cast<uintptr_t>(" << tracker.getName() << "_instruments),\n" <<
     indent << "/* frequencyTable        */ " << (uint32_t)song.frequencyTable << ",\n" <<
+    indent << "/* flags                 */ " << (uint32_t)song.flags << ",\n" <<
     indent << "/* tempo                 */ " << song.tempo << ",\n" <<
     indent << "/* bpm                   */ " << song.bpm << ",\n" <<
     "}};\n\n";
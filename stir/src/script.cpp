@@ -157,7 +157,7 @@ bool Script::run(const char *filename)
         for (std::set<Tracker*>::iterator i = trackers.begin(); i != trackers.end(); i++) {
             Tracker *tracker = *i;
 
-            if(!tracker->loader.load(tracker->getFile().c_str(), log)) {
+            if(!tracker->loader.load(tracker->getFile().c_str(), log, tracker->isUnpacked())) {
                 return false;
             }
 
@@ -812,6 +812,12 @@ Tracker::Tracker(lua_State *L)
         loopType = _SYS_LOOP_UNDEF;
     }
 
+    if (Script::argMatch(L, "unpacked")) {
+        unpacked = lua_toboolean(L, -1);
+    } else {
+        unpacked = false;
+    }
+
     Script::argEnd(L);
 }
 
@@ -447,6 +447,11 @@ public:
         return loader.size;
     }
 
+    // Store patterns as fixed-size rows instead of compressing them?
+    bool isUnpacked() const {
+        return unpacked;
+    }
+
     // Returns the type of looping, as a _SYS_LOOP_* constant
     _SYSAudioLoopType getLoopType() const {
         return loopType;
@@ -469,6 +474,7 @@ private:
     XmTrackerLoader loader;
 
     _SYSAudioLoopType loopType;
+    bool unpacked;
 };
 
 };  // namespace Stir
@@ -44,10 +44,11 @@ std::vector<std::vector<uint8_t> > XmTrackerLoader::globalSampleDatas;
  *
  * Returns success or failure.
  */
-bool XmTrackerLoader::load(const char *pFilename, Logger &pLog)
+bool XmTrackerLoader::load(const char *pFilename, Logger &pLog, bool pUnpacked)
 {
     filename = pFilename;
     log = &pLog;
+    unpacked = pUnpacked;
 
     // If this instance already contains module data, clean it up first.
     if (patterns.size()) init();
@@ -130,6 +131,7 @@ bool XmTrackerLoader::readSong()
     song.frequencyTable = get16();
     song.tempo = get16();
     song.bpm = get16();
+    song.flags = unpacked ? _SYS_XM_UNPACKED : 0;
 
     // FILE: Pattern order table
     for (unsigned i = 0; i < song.patternOrderTableSize; i++) {
@@ -180,6 +182,9 @@ bool XmTrackerLoader::readNextPattern()
     std::vector<uint8_t> patternData(pattern.dataSize);
     getbuf(&patternData[0], pattern.dataSize);
 
+    if (unpacked && !unpackPattern(pattern, patternData))
+        return false;
+
     size += sizeof(pattern);
     patterns.push_back(pattern);
     size += patternData.size();
@@ -188,6 +193,79 @@ bool XmTrackerLoader::readNextPattern()
     return true;
 }
 
+/*
+ * Rewrite a pattern so that every note uses the uncompressed 5-byte form.
+ *
+ * Fields that are missing from a compressed note are replaced with values
+ * that the firmware decodes identically, so the result is still a valid
+ * XM pattern. Empty patterns (no data at all) are left alone.
+ */
+bool XmTrackerLoader::unpackPattern(_SYSXMPattern &pattern, std::vector<uint8_t> &data)
+{
+    static const unsigned kNoteBytes = 5;
+    static const uint8_t missing[kNoteBytes] = {
+        0x00,   // note -> no note
+        0x00,   // instrument -> no instrument
+        0x55,   // volume -> no volume
+        0xFF,   // effect type -> no effect
+        0xFF,   // effect param -> no param
+    };
+
+    if (data.empty())
+        return true;
+
+    unsigned numNotes = pattern.nRows * song.nChannels;
+    if (numNotes * kNoteBytes > 0xFFFF) {
+        log->error("%s: Pattern is too large to unpack", filename);
+        return false;
+    }
+
+    std::vector<uint8_t> result;
+    result.reserve(numNotes * kNoteBytes);
+    unsigned offset = 0;
+
+    for (unsigned i = 0; i < numNotes; i++) {
+        uint8_t note[kNoteBytes];
+
+        if (offset >= data.size()) {
+            log->error("%s: Pattern data is truncated", filename);
+            return false;
+        }
+
+        if (data[offset] & 0x80) {
+            uint8_t enc = data[offset++];
+            for (unsigned j = 0; j < kNoteBytes; j++) {
+                if (!(enc & (1 << j))) {
+                    note[j] = missing[j];
+                } else if (offset < data.size()) {
+                    note[j] = data[offset++];
+                } else {
+                    log->error("%s: Pattern data is truncated", filename);
+                    return false;
+                }
+            }
+        } else {
+            if (offset + kNoteBytes > data.size()) {
+                log->error("%s: Pattern data is truncated", filename);
+                return false;
+            }
+            memcpy(note, &data[offset], kNoteBytes);
+            offset += kNoteBytes;
+        }
+
+        // The first byte must not look like an encoding byte. Such notes
+        // are out of range, and the firmware would discard them anyway.
+        if (note[0] & 0x80)
+            note[0] = missing[0];
+
+        result.insert(result.end(), note, note + kNoteBytes);
+    }
+
+    data.swap(result);
+    pattern.dataSize = data.size();
+    return true;
+}
+
 /*
  * Read an instrument's data from the module.
  *
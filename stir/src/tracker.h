@@ -41,8 +41,8 @@ class Tracker;
 
 class XmTrackerLoader {
 public:
-    XmTrackerLoader() : log(0), size(0) {}
-    bool load(const char *filename, Logger &pLog);
+    XmTrackerLoader() : log(0), size(0), unpacked(false) {}
+    bool load(const char *filename, Logger &pLog, bool pUnpacked = false);
     static void deduplicate(std::set<Tracker*> trackers, Logger &log);
 
 private:
@@ -56,6 +56,7 @@ private:
 
     bool readNextPattern();
     bool savePatterns();
+    bool unpackPattern(_SYSXMPattern &pattern, std::vector<uint8_t> &data);
 
     void emulatePingPongLoops(_SYSAudioModule &sample, std::vector<uint8_t> &pcmData);
 
@@ -102,6 +103,7 @@ private:
     _SYSXMSong song;
     uint32_t size;
     uint32_t fileSize;
+    bool unpacked;
     
     std::vector<std::vector<uint8_t> > patternDatas;
     std::vector<_SYSXMPattern> patterns;
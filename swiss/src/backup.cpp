@@ -24,6 +24,7 @@
  */
 
 #include "backup.h"
+#include "basedevice.h"
 #include "usbprotocol.h"
 #include "progressbar.h"
 #include "swisserror.h"
@@ -40,97 +41,275 @@
 
 int Backup::run(int argc, char **argv, IODevice &_dev)
 {
-    if (argc != 2) {
+    const char *path = NULL;
+    const char *sincePath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--since") && i + 1 < argc) {
+            sincePath = argv[++i];
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "incorrect args\n");
+            return EINVAL;
+        }
+    }
+
+    if (!path) {
         fprintf(stderr, "incorrect args\n");
         return EINVAL;
     }
 
     Backup m(_dev);
-    return m.backup(argv[1]);
+    return m.backup(path, sincePath);
 }
 
-Backup::Backup(IODevice &_dev) : dev(_dev) {}
+Backup::Backup(IODevice &_dev) : dev(_dev), since(0) {}
 
-int Backup::backup(const char *path)
+int Backup::backup(const char *path, const char *sincePath)
 {
+    if (sincePath) {
+        if (!strcmp(sincePath, path)) {
+            fprintf(stderr, "--since needs a different file than the new backup\n");
+            return EINVAL;
+        }
+        if (!openSince(sincePath))
+            return ENOENT;
+    }
+
     FILE *f = fopen(path, "wb");
     if (!f) {
         fprintf(stderr, "could not open %s: %s\n", path, strerror(errno));
+        if (since)
+            fclose(since);
         return ENOENT;
     }
 
-    if (!dev.open(IODevice::SIFTEO_VID, IODevice::BASE_PID)) {
-        return ENODEV;
+    bool success = dev.open(IODevice::SIFTEO_VID, IODevice::BASE_PID);
+    if (success) {
+        success = queryBlockInfo() &&
+                  copyUnchangedBlocks(f) &&
+                  writeFileHeader(f) &&
+                  writeFlashContents(f);
     }
 
-    requestProgress = 0;
-    replyProgress = 0;
-
-    bool success = writeFileHeader(f) && writeFlashContents(f);
     fclose(f);
+    if (since)
+        fclose(since);
 
     if (!success) {
         unlink(path);
-        return EIO;
+        return dev.isOpen() ? EIO : ENODEV;
     }
 
     return EOK;
 }
 
+bool Backup::openSince(const char *path)
+{
+    /*
+     * An earlier backup, which we can copy unchanged blocks from.
+     * It may itself be sparse, in which case its header tells us
+     * which blocks were left out.
+     */
+
+    since = fopen(path, "rb");
+    if (!since) {
+        fprintf(stderr, "could not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (fread(&sinceHeader, sizeof sinceHeader, 1, since) != 1 ||
+        sinceHeader.magic != 0x534c467974666953LLU ||
+        sinceHeader.mc_capacity != DEVICE_SIZE ||
+        sinceHeader.mc_blockSize != BLOCK_SIZE ||
+        sinceHeader.cube_count != 0) {
+        fprintf(stderr, "%s is not a backup of a Sifteo Base filesystem\n", path);
+        fclose(since);
+        since = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool Backup::queryBlockInfo()
+{
+    /*
+     * Ask the base which erase blocks are in use, and for a CRC of each one.
+     * Older firmware doesn't know this request, and answers with an empty
+     * reply of a different type. In that case, read everything.
+     */
+
+    for (unsigned i = 0; i < NUM_BLOCKS; ++i) {
+        blocks[i].allocated = true;
+        blocks[i].needsRead = true;
+        blocks[i].crc = 0;
+    }
+
+    const unsigned perRequest = UsbVolumeManager::FlashDeviceBlockInfoReply::MAX_BLOCKS;
+    unsigned nextBlock = 0;
+    unsigned pending = 0;
+    bool supported;
+
+    // Probe with a single request, so an old base has nothing else queued
+    sendBlockInfoRequest(nextBlock);
+    nextBlock += perRequest;
+    if (!readBlockInfoReply(supported))
+        return false;
+
+    if (!supported) {
+        if (since) {
+            fprintf(stderr, "base firmware can't compare blocks, ignoring --since\n");
+            fclose(since);
+            since = 0;
+        }
+        return true;
+    }
+
+    while (nextBlock < NUM_BLOCKS || pending) {
+        while (nextBlock < NUM_BLOCKS && pending < MAX_IN_FLIGHT) {
+            if (!sendBlockInfoRequest(nextBlock))
+                return false;
+            nextBlock += perRequest;
+            pending++;
+        }
+
+        if (!readBlockInfoReply(supported) || !supported) {
+            fprintf(stderr, "unexpected response\n");
+            return false;
+        }
+        pending--;
+    }
+
+    return true;
+}
+
+bool Backup::sendBlockInfoRequest(unsigned firstBlock)
+{
+    USBProtocolMsg m(USBProtocol::Installer);
+    m.header |= UsbVolumeManager::FlashDeviceBlockInfo;
+    UsbVolumeManager::FlashDeviceBlockInfoRequest *req =
+        m.zeroCopyAppend<UsbVolumeManager::FlashDeviceBlockInfoRequest>();
+
+    req->firstBlock = firstBlock;
+    req->count = UsbVolumeManager::FlashDeviceBlockInfoReply::MAX_BLOCKS;
+
+    return dev.writePacket(m.bytes, m.len) >= 0;
+}
+
+bool Backup::readBlockInfoReply(bool &supported)
+{
+    USBProtocolMsg m(USBProtocol::Installer);
+    m.header |= UsbVolumeManager::FlashDeviceBlockInfo;
+    BaseDevice base(dev);
+
+    // Anything but our reply type means the request wasn't understood
+    supported = base.waitForReply(m.header, m);
+    if (!supported)
+        return true;
+
+    const UsbVolumeManager::FlashDeviceBlockInfoReply *r =
+        m.castPayload<UsbVolumeManager::FlashDeviceBlockInfoReply>();
+    if (m.payloadLen() < sizeof *r || r->firstBlock + r->count > NUM_BLOCKS) {
+        supported = false;
+        return true;
+    }
+
+    for (unsigned i = 0; i < r->count; ++i) {
+        BlockInfo &b = blocks[r->firstBlock + i];
+        b.allocated = (r->allocated >> i) & 1;
+        b.needsRead = b.allocated;
+        b.crc = r->crc[i];
+    }
+
+    return true;
+}
+
+bool Backup::copyUnchangedBlocks(FILE *f)
+{
+    /*
+     * With --since, any allocated block whose CRC matches the earlier
+     * backup comes from that file instead of over USB.
+     */
+
+    if (!since)
+        return true;
+
+    std::vector<uint8_t> buffer(BLOCK_SIZE);
+
+    for (unsigned i = 0; i < NUM_BLOCKS; ++i) {
+        BlockInfo &b = blocks[i];
+        if (!b.allocated)
+            continue;
+
+        if (isMarked(sinceHeader.mc_erasedBlocks, i)) {
+            memset(&buffer[0], 0xFF, BLOCK_SIZE);
+        } else if (fseek(since, PAGE_SIZE + i * BLOCK_SIZE, SEEK_SET) ||
+                   fread(&buffer[0], BLOCK_SIZE, 1, since) != 1) {
+            continue;
+        }
+
+        if (crc32(&buffer[0], BLOCK_SIZE) != b.crc)
+            continue;
+
+        if (fseek(f, PAGE_SIZE + i * BLOCK_SIZE, SEEK_SET) ||
+            fwrite(&buffer[0], BLOCK_SIZE, 1, f) != 1)
+            return false;
+
+        b.needsRead = false;
+    }
+
+    return true;
+}
+
 bool Backup::writeFileHeader(FILE *f)
 {
     /*
      * This is a basic header that describes the geometry of the flash device,
      * and identifies this file as something that Siftulator knows how to import
      * with the -F command line option.
+     *
+     * Blocks that no volume uses are left out of the file entirely, and
+     * listed in mc_erasedBlocks so Siftulator can erase them on import.
      */
 
-    struct Header {
-        uint64_t    magic;
-        uint32_t    version;
-        uint32_t    fileSize;
-        uint32_t    cube_count;
-        uint32_t    cube_nvmSize;
-        uint32_t    cube_extSize;
-        uint32_t    cube_sectorSize;
-        uint32_t    mc_pageSize;
-        uint32_t    mc_blockSize;
-        uint32_t    mc_capacity;
-        uint32_t    uniqueID;
-        uint32_t    reserved[52];
-    };
-
-    static const Header hdr = {
-        0x534c467974666953LLU,      // magic
-        1,                          // version
-        DEVICE_SIZE + PAGE_SIZE,    // fileSize
-        0, 0, 0, 0,                 // (no cubes)
-        PAGE_SIZE,                  // mc_pageSize
-        BLOCK_SIZE,                 // mc_blockSize,
-        DEVICE_SIZE,                // mc_capacity
-        -1,                         // uniqueID,
-    };
-
+    Header hdr;
     STATIC_ASSERT(sizeof hdr == PAGE_SIZE);
-    return fwrite(&hdr, sizeof hdr, 1, f) == 1;
+    memset(&hdr, 0, sizeof hdr);
+
+    hdr.magic = 0x534c467974666953LLU;
+    hdr.version = 1;
+    hdr.fileSize = DEVICE_SIZE + PAGE_SIZE;
+    hdr.mc_pageSize = PAGE_SIZE;
+    hdr.mc_blockSize = BLOCK_SIZE;
+    hdr.mc_capacity = DEVICE_SIZE;
+    hdr.uniqueID = -1;
+
+    for (unsigned i = 0; i < NUM_BLOCKS; ++i) {
+        if (!blocks[i].allocated)
+            hdr.mc_erasedBlocks[i / 32] |= 1 << (i % 32);
+    }
+
+    return fseek(f, 0, SEEK_SET) == 0 &&
+           fwrite(&hdr, sizeof hdr, 1, f) == 1;
 }
 
 bool Backup::sendRequest()
 {
-    unsigned offset = requestProgress;
-    if (offset >= DEVICE_SIZE)
+    if (readProgress >= readQueue.size())
         return false;
 
+    const ReadRequest &r = readQueue[readProgress++];
+
     USBProtocolMsg m(USBProtocol::Installer);
     m.header |= UsbVolumeManager::FlashDeviceRead;
     UsbVolumeManager::FlashDeviceReadRequest *req =
         m.zeroCopyAppend<UsbVolumeManager::FlashDeviceReadRequest>();
 
-    req->address = offset;
-    req->length = std::min(DEVICE_SIZE - offset,
-        USBProtocolMsg::MAX_LEN - USBProtocolMsg::HEADER_BYTES);
-
-    requestProgress = offset + req->length;
+    req->address = r.address;
+    req->length = r.length;
+    pendingReads.push_back(r);
 
     dev.writePacket(m.bytes, m.len);
 
@@ -142,23 +321,73 @@ bool Backup::writeReply(FILE *f)
     USBProtocolMsg m;
 
     dev.readPacket(m.bytes, m.MAX_LEN, m.len);
-    if ((m.header & 0xff) != UsbVolumeManager::FlashDeviceRead) {
+    if ((m.header & 0xff) != UsbVolumeManager::FlashDeviceRead || pendingReads.empty()) {
         fprintf(stderr, "\nunexpected response\n");
         return false;
     }
 
+    // Replies arrive in the same order as their requests
+    ReadRequest r = pendingReads.front();
+    pendingReads.pop_front();
+
     unsigned len = m.payloadLen();
+    if (len != r.length) {
+        fprintf(stderr, "\nshort read at 0x%06x\n", r.address);
+        return false;
+    }
+
     replyProgress += len;
 
+    long offset = PAGE_SIZE + r.address;
+    if (ftell(f) != offset && fseek(f, offset, SEEK_SET))
+        return false;
+
     return fwrite(m.castPayload<uint8_t>(), len, 1, f) == 1;
 }
 
 bool Backup::writeFlashContents(FILE *f)
 {
-    ScopedProgressBar pb(DEVICE_SIZE);
+    /*
+     * Read every block we still need, in packet-sized pieces.
+     */
+
+    const unsigned chunk = USBProtocolMsg::MAX_LEN - USBProtocolMsg::HEADER_BYTES;
+    unsigned total = 0;
+    unsigned numCopied = 0;
+    unsigned numErased = 0;
 
-    // Queue up the first few reads, respond as results arrive
-    for (unsigned i = 0; i < 3; ++i)
+    readQueue.clear();
+    pendingReads.clear();
+    readProgress = 0;
+    replyProgress = 0;
+
+    for (unsigned i = 0; i < NUM_BLOCKS; ++i) {
+        if (!blocks[i].allocated) {
+            numErased++;
+            continue;
+        }
+        if (!blocks[i].needsRead) {
+            numCopied++;
+            continue;
+        }
+
+        for (unsigned offset = 0; offset < BLOCK_SIZE; offset += chunk) {
+            ReadRequest r = { i * BLOCK_SIZE + offset, std::min(chunk, BLOCK_SIZE - offset) };
+            readQueue.push_back(r);
+            total += r.length;
+        }
+    }
+
+    printf("Reading %u blocks, %u unchanged, %u unused\n",
+        NUM_BLOCKS - numCopied - numErased, numCopied, numErased);
+
+    if (!total)
+        return true;
+
+    ScopedProgressBar pb(total);
+
+    // Keep a few reads queued up, respond as results arrive
+    for (unsigned i = 0; i < MAX_IN_FLIGHT; ++i)
         sendRequest();
 
     while (1) {
@@ -170,8 +399,26 @@ bool Backup::writeFlashContents(FILE *f)
 
             pb.update(replyProgress);
             sendRequest();
-            if (replyProgress == DEVICE_SIZE)
+            if (replyProgress == total)
                 return true;
         }
     }
 }
+
+uint32_t Backup::crc32(const uint8_t *bytes, unsigned count)
+{
+    /*
+     * Software version of the base's Crc32 engine: the standard CRC-32
+     * polynomial, not reflected, fed one little-endian word at a time.
+     */
+
+    uint32_t crc = 0xffffffff;
+
+    for (unsigned i = 0; i + 4 <= count; i += 4) {
+        crc ^= bytes[i] | (bytes[i+1] << 8) | (bytes[i+2] << 16) | ((uint32_t)bytes[i+3] << 24);
+        for (unsigned bit = 0; bit < 32; ++bit)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : (crc << 1);
+    }
+
+    return crc;
+}
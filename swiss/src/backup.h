@@ -30,6 +30,9 @@
 #include "usbvolumemanager.h"
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <stdio.h>
 
 class Backup
 {
@@ -38,23 +41,70 @@ public:
 
     static int run(int argc, char **argv, IODevice &_dev);
 
-    int backup(const char *path);
+    int backup(const char *path, const char *sincePath);
 
 private:
     IODevice &dev;
 
-    unsigned requestProgress;
-    unsigned replyProgress;
-
     static const unsigned DEVICE_SIZE = 16*1024*1024;
     static const unsigned PAGE_SIZE = 256;
     static const unsigned BLOCK_SIZE = 64*1024;
+    static const unsigned NUM_BLOCKS = DEVICE_SIZE / BLOCK_SIZE;
+    static const unsigned MAX_IN_FLIGHT = 8;
+
+    struct Header {
+        uint64_t    magic;
+        uint32_t    version;
+        uint32_t    fileSize;
+        uint32_t    cube_count;
+        uint32_t    cube_nvmSize;
+        uint32_t    cube_extSize;
+        uint32_t    cube_sectorSize;
+        uint32_t    mc_pageSize;
+        uint32_t    mc_blockSize;
+        uint32_t    mc_capacity;
+        uint32_t    uniqueID;
+        uint32_t    mc_erasedBlocks[NUM_BLOCKS / 32];
+        uint32_t    reserved[44];
+    };
+
+    struct BlockInfo {
+        bool allocated;
+        bool needsRead;
+        uint32_t crc;
+    };
+
+    struct ReadRequest {
+        unsigned address;
+        unsigned length;
+    };
+
+    BlockInfo blocks[NUM_BLOCKS];
+    std::deque<ReadRequest> pendingReads;
+    std::vector<ReadRequest> readQueue;
+    unsigned readProgress;
+    unsigned replyProgress;
+
+    FILE *since;
+    Header sinceHeader;
+
+    bool openSince(const char *path);
+    bool queryBlockInfo();
+    bool sendBlockInfoRequest(unsigned firstBlock);
+    bool readBlockInfoReply(bool &supported);
+    bool copyUnchangedBlocks(FILE *f);
 
     bool writeFileHeader(FILE *f);
     bool writeFlashContents(FILE *f);
 
     bool sendRequest();
     bool writeReply(FILE *f);
+
+    static bool isMarked(const uint32_t *bits, unsigned index) {
+        return (bits[index / 32] >> (index % 32)) & 1;
+    }
+
+    static uint32_t crc32(const uint8_t *bytes, unsigned count);
 };
 
 #endif // BACKUP_H
@@ -28,6 +28,7 @@
 
 #include "elfdefs.h"
 #include "mappedfile.h"
+#include "elfsymbolindex.h"
 
 #include <vector>
 #include <map>
@@ -54,9 +55,11 @@ private:
 
     sections_t sections;
     sectionMap_t sectionMap;
+    mutable ElfSymbolIndex symbolIndex;
 
     static void demangle(std::string &name);
     std::string readString(const Elf::SectionHeader *SI, uint32_t offset) const;
+    ElfSymbolIndex::Entry *lookupSymbol(uint32_t address) const;
 
     const Elf::FileHeader *getFileHeader() const;
     const Elf::SectionHeader *findSection(const std::string &name) const;
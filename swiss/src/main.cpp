@@ -47,7 +47,7 @@ static const Command commands[] = {
     {
         "backup",
         "create a full backup of a Sifteo Base filesystem",
-        "backup <filesystem.bin>",
+        "backup [--since <previous.bin>] <filesystem.bin>",
         Backup::run
     },
     {
@@ -69,6 +69,8 @@ for k,v in string.gmatch(os.getenv("TEST") or "", "[^%s]+") do
 end
 
 gx:init(os.getenv("USE_FRONTEND"))
+LuaUnit.result.clock = function() return gx.sys:clock() end
+LuaUnit.result.vclock = function() return gx.sys:vclock() end
 failures = LuaUnit:run(tests)
 gx:exit()
 
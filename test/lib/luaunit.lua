@@ -49,6 +49,15 @@ Changes between 1.1 and 1.0:
 - a dedicated class collects and displays the result, to provide easy
   customisation
 - two verbosity level, like in python unittest
+
+Sifteo changes:
+- if LUAUNIT_RESULTS names a file, one tab-separated line per test is
+  appended to it: name, "pass" or "fail", wall time, virtual time, and
+  the error message. Set LuaUnit.result.clock and LuaUnit.result.vclock
+  to functions returning seconds; by default only os.clock() is used.
+- if LUAUNIT_LIST names a file, the names of all tests that would run
+  are written to it, one per line, and nothing is run. This lets a test
+  driver split one suite across several processes.
 ]]--
 
 argv = arg
@@ -159,7 +168,11 @@ UnitResult = { -- class
     currentClassName = "",
     currentTestName = "",
     testHasFailure = false,
-    verbosity = 1
+    currentError = "",
+    verbosity = 1,
+    clock = os.clock,
+    vclock = nil,
+    resultFile = nil,
 }
     function UnitResult:displayClassName()
         print( '>>>>>>>>> '.. self.currentClassName )
@@ -227,11 +240,15 @@ UnitResult = { -- class
         self:displayTestName()
         self.testCount = self.testCount + 1
         self.testHasFailure = false
+        self.currentError = ""
+        self.startTime = self.clock()
+        self.startVTime = self.vclock and self.vclock() or 0
     end
 
     function UnitResult:addFailure( errorMsg )
         self.failureCount = self.failureCount + 1
         self.testHasFailure = true
+        self.currentError = errorMsg
         table.insert( self.errorList, { self.currentTestName, errorMsg } )
         self:displayFailure( errorMsg )
     end
@@ -240,6 +257,25 @@ UnitResult = { -- class
         if not self.testHasFailure then
             self:displaySuccess()
         end
+        self:writeResult()
+    end
+
+    function UnitResult:writeResult()
+        local path = os.getenv("LUAUNIT_RESULTS")
+        if not path or path == "" then return end
+
+        if not self.resultFile then
+            self.resultFile = assert(io.open(path, "a"))
+        end
+
+        local vtime = self.vclock and (self.vclock() - self.startVTime) or 0
+        local msg = string.gsub(string.gsub(self.currentError, "\\", "\\\\"), "[\t\n]",
+            { ["\t"] = " ", ["\n"] = "\\n" })
+
+        self.resultFile:write(string.format("%s\t%s\t%f\t%f\t%s\n",
+            self.currentTestName, self.testHasFailure and "fail" or "pass",
+            self.clock() - self.startTime, vtime, msg))
+        self.resultFile:flush()
     end
 
 -- class UnitResult end
@@ -358,6 +394,51 @@ LuaUnit = {
         print()
     end
 
+    function LuaUnit:listTests(args)
+        -- Write the full name of every test that run(args) would run
+        local names = {}
+
+        local function addClass(aClassName)
+            if string.find(aClassName, ':') then
+                table.insert(names, aClassName)
+                return
+            end
+            local classInstance = _G[aClassName]
+            if not classInstance then
+                error( "No such class: "..aClassName )
+            end
+            for methodName, method in orderedPairs(classInstance) do
+                if LuaUnit.isFunction(method) and string.sub(methodName, 1, 4) == "test" then
+                    table.insert(names, aClassName..':'..methodName)
+                end
+            end
+        end
+
+        if #args > 0 then
+            table.foreachi(args, function(i, v) addClass(v) end)
+        elseif argv and #argv > 0 then
+            table.foreachi(argv, function(i, v) addClass(v) end)
+        else
+            local testClassList = {}
+            for key, val in pairs(_G) do
+                if string.sub(key,1,4) == 'Test' then
+                    table.insert( testClassList, key )
+                end
+            end
+            for i, val in orderedPairs(testClassList) do
+                addClass(val)
+            end
+        end
+
+        table.sort(names)
+        local f = assert(io.open(os.getenv("LUAUNIT_LIST"), "w"))
+        for i, name in ipairs(names) do
+            f:write(name.."\n")
+        end
+        f:close()
+        return 0
+    end
+
     function LuaUnit:run(args)
         -- Run some specific test classes.
         -- If no arguments are passed, run the class names specified on the
@@ -367,6 +448,11 @@ LuaUnit = {
         -- If arguments are passed, they must be strings of the class names 
         -- that you want to run
 
+        local listPath = os.getenv("LUAUNIT_LIST")
+        if listPath and listPath ~= "" then
+            return LuaUnit:listTests(args)
+        end
+
         if #args > 0 then
             table.foreachi( args, LuaUnit.runTestClassByName )
         else 
@@ -0,0 +1,368 @@
+#!/usr/bin/env python
+
+#
+# Parallel driver for the unit tests in this directory.
+#
+# "make" in this directory runs each test suite in turn, and the Lua suites
+# run each of their test cases in turn inside one Siftulator process. This
+# script runs independent suites in parallel, and splits Lua suites that
+# support it (those with a "shard" make target) across several Siftulator
+# processes, each running a subset of the test cases.
+#
+# Each suite's inputs are fingerprinted. A suite that passed last time and
+# whose inputs haven't changed is skipped, unless --force is given. Only
+# files tracked by git, plus the SDK binaries, are fingerprinted.
+#
+# Results are written as JUnit XML, with per-test wall-clock time, and
+# virtual time as a test property where the suite reports it.
+#
+# Usage: runtests.py [-j JOBS] [--force] [--junit FILE] [suite ...]
+#
+
+import sys, os, re, subprocess, threading, hashlib, json, time, optparse
+from xml.sax.saxutils import quoteattr, escape
+
+try:
+    import Queue as queue
+except ImportError:
+    import queue
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+TC_DIR = os.path.dirname(TEST_DIR)
+SDK_DIR = os.path.join(TC_DIR, 'sdk')
+CACHE_FILE = os.path.join(TEST_DIR, '.runtests-cache.json')
+
+# Lines of output to show from each failing job
+LOG_TAIL_LINES = 40
+
+
+def testEnv(extra={}):
+    env = dict(os.environ)
+    env['PATH'] = os.pathsep.join([os.path.join(SDK_DIR, 'bin'),
+        '/bin', '/usr/bin', '/usr/local/bin'])
+    env['TC_DIR'] = TC_DIR
+    env['SDK_DIR'] = SDK_DIR
+    env.update(extra)
+    return env
+
+
+def listSuites():
+    out = subprocess.check_output(['make', '-s', '-C', TEST_DIR, 'list'])
+    return out.decode().split()
+
+
+def hasShardTarget(suite):
+    try:
+        f = open(os.path.join(TEST_DIR, suite, 'Makefile'))
+    except IOError:
+        return False
+    return re.search(r'^shard:', f.read(), re.M) is not None
+
+
+def tail(path, lines=LOG_TAIL_LINES):
+    try:
+        return ''.join(open(path).readlines()[-lines:])
+    except IOError:
+        return ''
+
+
+class Fingerprinter:
+    """Hashes the inputs of each test suite."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.cache = {}
+
+    def hashTree(self, path):
+        with self.lock:
+            if path in self.cache:
+                return self.cache[path]
+
+        h = hashlib.sha1()
+        names = subprocess.check_output(['git', 'ls-files', '--', path], cwd=TC_DIR)
+        for name in sorted(names.decode().split('\n')):
+            full = os.path.join(TC_DIR, name)
+            if name and os.path.isfile(full):
+                h.update(name.encode() + b'\0')
+                h.update(open(full, 'rb').read())
+
+        # Build products aren't tracked; hash the SDK binaries directly
+        if path == 'sdk':
+            bindir = os.path.join(SDK_DIR, 'bin')
+            if os.path.isdir(bindir):
+                for name in sorted(os.listdir(bindir)):
+                    full = os.path.join(bindir, name)
+                    if os.path.isfile(full):
+                        h.update(name.encode() + b'\0')
+                        h.update(open(full, 'rb').read())
+
+        digest = h.hexdigest()
+        with self.lock:
+            self.cache[path] = digest
+        return digest
+
+    def suite(self, suite):
+        inputs = [os.path.join('test', suite), 'test/lib', 'test/Makefile', 'sdk']
+        if suite.startswith('sdk/'):
+            inputs.append('test/sdk/Makefile.rules')
+        if suite.startswith('firmware/'):
+            inputs.append('firmware')
+
+        h = hashlib.sha1()
+        for path in inputs:
+            h.update(self.hashTree(path).encode())
+        return h.hexdigest()
+
+
+class TestCase:
+    def __init__(self, name, status='pass', wall=0.0, vtime=None, message=''):
+        self.name = name
+        self.status = status
+        self.wall = wall
+        self.vtime = vtime
+        self.message = message
+
+
+class Suite:
+    def __init__(self, name):
+        self.name = name
+        self.cases = []
+        self.wall = 0.0
+        self.skipped = False
+        self.lock = threading.Lock()
+
+    def failed(self):
+        return [c for c in self.cases if c.status != 'pass']
+
+    def add(self, cases, wall):
+        with self.lock:
+            self.cases.extend(cases)
+            self.wall += wall
+
+
+class Runner:
+    def __init__(self, options):
+        self.options = options
+        self.queue = queue.Queue()
+        self.printLock = threading.Lock()
+        self.suites = []
+
+        try:
+            self.cache = json.load(open(CACHE_FILE))
+        except (IOError, ValueError):
+            self.cache = {}
+        self.cache.setdefault('passed', {})
+        self.cache.setdefault('times', {})
+
+        if not os.path.isdir(options.results):
+            os.makedirs(options.results)
+
+    def log(self, msg):
+        with self.printLock:
+            sys.stdout.write(msg + '\n')
+            sys.stdout.flush()
+
+    def logPath(self, suite, label=''):
+        return os.path.join(self.options.results,
+            suite.name.replace('/', '-') + label + '.log')
+
+    def make(self, suite, target, logPath, env={}):
+        args = ['make', '-C', os.path.join(TEST_DIR, suite.name)]
+        if target:
+            args.append(target)
+        start = time.time()
+        status = subprocess.call(args, stdout=open(logPath, 'w'),
+            stderr=subprocess.STDOUT, env=testEnv(env))
+        return status, time.time() - start
+
+    def worker(self):
+        while True:
+            task = self.queue.get()
+            try:
+                task()
+            except Exception as e:
+                self.log('Internal error: %r' % e)
+            self.queue.task_done()
+
+    def run(self, names):
+        fp = Fingerprinter()
+
+        for name in names:
+            suite = Suite(name)
+            self.suites.append(suite)
+            suite.fingerprint = fp.suite(name)
+
+            if not self.options.force and self.cache['passed'].get(name) == suite.fingerprint:
+                suite.skipped = True
+                self.log('SKIP  %s (unchanged)' % name)
+            elif hasShardTarget(name):
+                self.queue.put(lambda s=suite: self.listCases(s))
+            else:
+                self.queue.put(lambda s=suite: self.runWhole(s))
+
+        for i in range(self.options.jobs):
+            t = threading.Thread(target=self.worker)
+            t.daemon = True
+            t.start()
+
+        self.queue.join()
+
+        for suite in self.suites:
+            if not suite.skipped and not suite.failed():
+                self.cache['passed'][suite.name] = suite.fingerprint
+            elif suite.name in self.cache['passed'] and not suite.skipped:
+                del self.cache['passed'][suite.name]
+            for case in suite.cases:
+                self.cache['times'][suite.name + ' ' + case.name] = case.wall
+        json.dump(self.cache, open(CACHE_FILE, 'w'), indent=1, sort_keys=True)
+
+    def report(self, suite, label, status, wall, logPath):
+        with self.printLock:
+            if status == 0:
+                sys.stdout.write('PASS  %s%s (%.1fs)\n' % (suite.name, label, wall))
+            else:
+                sys.stdout.write('FAIL  %s%s (%.1fs), log in %s\n%s\n' % (
+                    suite.name, label, wall, logPath, tail(logPath)))
+            sys.stdout.flush()
+
+    def runWhole(self, suite):
+        # Remove stamps, so make doesn't skip a suite we decided to run
+        for dirpath, dirnames, filenames in os.walk(os.path.join(TEST_DIR, suite.name)):
+            if 'tests.stamp' in filenames:
+                os.remove(os.path.join(dirpath, 'tests.stamp'))
+
+        logPath = self.logPath(suite)
+        status, wall = self.make(suite, None, logPath)
+        message = status and tail(logPath) or ''
+        suite.add([TestCase('all', status and 'fail' or 'pass', wall, None, message)], wall)
+        self.report(suite, '', status, wall, logPath)
+
+    def listCases(self, suite):
+        # This builds the suite's dependencies too, so shards don't race to do it
+        listPath = self.logPath(suite, '-cases') + '.txt'
+        logPath = self.logPath(suite, '-list')
+        status, wall = self.make(suite, 'shard', logPath, {'LUAUNIT_LIST': listPath})
+
+        try:
+            cases = [l.strip() for l in open(listPath) if l.strip()]
+        except IOError:
+            cases = []
+        if status or not cases:
+            suite.add([TestCase('list', 'fail', wall, None, tail(logPath))], wall)
+            self.report(suite, ' (listing tests)', status or 1, wall, logPath)
+            return
+
+        # Longest-processing-time-first, using last run's times
+        times = self.cache['times']
+        cases.sort(key=lambda c: -times.get(suite.name + ' ' + c, 1.0))
+        numShards = min(self.options.jobs, len(cases))
+        shards = [[] for i in range(numShards)]
+        load = [0.0] * numShards
+        for case in cases:
+            i = load.index(min(load))
+            shards[i].append(case)
+            load[i] += times.get(suite.name + ' ' + case, 1.0)
+
+        for i, shard in enumerate(shards):
+            self.queue.put(lambda s=suite, i=i, c=shard: self.runShard(s, i, c))
+
+    def runShard(self, suite, index, cases):
+        label = '-shard%d' % index
+        logPath = self.logPath(suite, label)
+        resultPath = logPath + '.results'
+        if os.path.exists(resultPath):
+            os.remove(resultPath)
+
+        status, wall = self.make(suite, 'shard', logPath, {
+            'TEST': ' '.join(cases), 'LUAUNIT_RESULTS': resultPath})
+
+        results = {}
+        try:
+            for line in open(resultPath):
+                fields = line.rstrip('\n').split('\t')
+                if len(fields) == 5:
+                    name, result, caseWall, vtime, message = fields
+                    message = message.replace('\\n', '\n').replace('\\\\', '\\')
+                    results[name] = TestCase(name, result, float(caseWall), float(vtime), message)
+        except IOError:
+            pass
+
+        # Anything without a result didn't finish, probably due to a crash
+        for name in cases:
+            if name not in results:
+                results[name] = TestCase(name, 'fail', 0.0, None,
+                    'No result, shard exited with status %d\n%s' % (status, tail(logPath)))
+
+        suite.add([results[name] for name in cases], wall)
+        failed = [c for c in results.values() if c.status != 'pass']
+        self.report(suite, ' shard %d, %d tests' % (index, len(cases)),
+            status or len(failed), wall, logPath)
+
+    def writeJUnit(self, path):
+        out = ['<?xml version="1.0" encoding="UTF-8"?>', '<testsuites>']
+
+        for suite in self.suites:
+            out.append('  <testsuite name=%s tests="%d" failures="%d" skipped="%d" time="%.3f">' % (
+                quoteattr(suite.name), max(1, len(suite.cases)), len(suite.failed()),
+                suite.skipped and 1 or 0, suite.wall))
+
+            if suite.skipped:
+                out.append('    <testcase classname=%s name="all" time="0">' % quoteattr(suite.name))
+                out.append('      <skipped message="inputs unchanged since last pass"/>')
+                out.append('    </testcase>')
+
+            for case in sorted(suite.cases, key=lambda c: c.name):
+                out.append('    <testcase classname=%s name=%s time="%.3f">' % (
+                    quoteattr(suite.name), quoteattr(case.name), case.wall))
+                if case.vtime is not None:
+                    out.append('      <properties>')
+                    out.append('        <property name="virtualTime" value="%.6f"/>' % case.vtime)
+                    out.append('      </properties>')
+                if case.status != 'pass':
+                    out.append('      <failure message="failed">%s</failure>' % escape(case.message))
+                out.append('    </testcase>')
+
+            out.append('  </testsuite>')
+
+        out.append('</testsuites>')
+        open(path, 'w').write('\n'.join(out) + '\n')
+
+
+def cpuCount():
+    try:
+        import multiprocessing
+        return multiprocessing.cpu_count()
+    except (ImportError, NotImplementedError):
+        return 1
+
+
+def main():
+    parser = optparse.OptionParser(usage='%prog [options] [suite ...]')
+    parser.add_option('-j', '--jobs', type='int', default=cpuCount(),
+        help='number of tests to run at once (default: number of CPUs)')
+    parser.add_option('-f', '--force', action='store_true',
+        help='run suites even if their inputs are unchanged')
+    parser.add_option('--results', default=os.path.join(TEST_DIR, 'results'),
+        help='directory for logs and results (default: test/results)')
+    parser.add_option('--junit', default=None,
+        help='JUnit XML output file (default: RESULTS/junit.xml)')
+    options, args = parser.parse_args()
+
+    options.jobs = max(1, options.jobs)
+    runner = Runner(options)
+    start = time.time()
+    runner.run(args or listSuites())
+    runner.writeJUnit(options.junit or os.path.join(options.results, 'junit.xml'))
+
+    failed = [s for s in runner.suites if s.failed()]
+    print('\n%d suites, %d failed, %d skipped, %.1fs' % (len(runner.suites), len(failed),
+        len([s for s in runner.suites if s.skipped]), time.time() - start))
+    for suite in failed:
+        for case in suite.failed():
+            print('  %s: %s' % (suite.name, case.name))
+
+    return failed and 1 or 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -388,6 +388,115 @@ void testEviction()
 }
 
 
+void testPrefetch()
+{
+    /*
+     * Prefetch a group in the background, then load it for real. The load
+     * should find the group already installed, with the same contents that
+     * a normal load would have given us.
+     */
+
+    LOG("================= Testing prefetch\n");
+
+    _SYS_asset_bindSlots(_SYS_fs_runningVolume(), 4);
+
+    Slot2.erase();
+    Slot3.erase();
+    ASSERT(Ball2Group.isInstalled(cubes) == false);
+    ASSERT(Ball3Group.isInstalled(cubes) == false);
+
+    {
+        AssetConfiguration<1> config;
+        ScopedAssetLoader loader;
+        config.append(Slot2, Ball2Group);
+        loader.prefetch(config, cubes);
+
+        // Prefetching is invisible to busyCubes, so poll the cache instead
+        for (unsigned frames = 0; !Ball2Group.isInstalled(cubes); ++frames) {
+            ASSERT(frames < 10000);
+            System::yield();
+        }
+
+        // Nothing left to send, and nothing was loaded twice
+        loader.start(config, cubes);
+        loader.finish();
+        ASSERT(Ball2Group.isInstalled(cubes) == true);
+        ASSERT(Slot2.tilesFree() == 4096 - roundTiles(Ball2Group.numTiles()));
+    }
+
+    // Same frames that testMultipleSlots() checked after a normal load
+    for (unsigned checks = 1; checks < 30; checks += 3) {
+        unsigned frame = (checks * 3) % Ball2.numFrames();
+
+        for (CubeID cube : cubes) {
+            vid[cube].initMode(BG0);
+            vid[cube].attach(cube);
+            vid[cube].bg0.image(vec(0,0), Ball2, frame);
+        }
+
+        System::paint();
+        System::finish();
+
+        for (CubeID cube : cubes)
+            SCRIPT_FMT(LUA, "util:assertScreenshot(Cube(%d), 'img-%P-frame-%d', 20000)",
+                int(cube), &Ball2, frame);
+    }
+
+    /*
+     * Cancel a prefetch partway through. Unlike a cancelled start(), this
+     * must never leave the slot indeterminate: the group in progress is
+     * either finished or was never begun.
+     */
+
+    {
+        AssetConfiguration<1> config;
+        ScopedAssetLoader loader;
+        config.append(Slot3, Ball3Group);
+        loader.prefetch(config, cubes);
+        for (unsigned frames = 0; frames < 4; ++frames)
+            System::yield();
+        loader.cancel();
+    }
+
+    if (Ball3Group.isInstalled(cubes))
+        ASSERT(Slot3.tilesFree() == 4096 - roundTiles(Ball3Group.numTiles()));
+    else
+        ASSERT(Slot3.tilesFree() == 4096);
+
+    // Either way, a normal load still works and fits alongside it
+    load(Ball3Group, Slot3, false);
+    ASSERT(Ball3Group.isInstalled(cubes) == true);
+    ASSERT(Slot3.tilesFree() == 4096 - roundTiles(Ball3Group.numTiles()));
+
+    // Cancelling before anything has been sent leaves nothing behind
+    Slot3.erase();
+    {
+        AssetConfiguration<1> config;
+        ScopedAssetLoader loader;
+        config.append(Slot3, Ball3Group);
+        loader.prefetch(config, cubes);
+        loader.cancel();
+    }
+    ASSERT(Ball3Group.isInstalled(cubes) == false);
+    ASSERT(Slot3.tilesFree() == 4096);
+
+    // A configuration that doesn't fit without an erase isn't prefetched at all
+    Slot0.erase();
+    {
+        AssetConfiguration<arraysize(NumberList)> config;
+        ScopedAssetLoader loader;
+        for (unsigned n = 0; n < arraysize(NumberList); n++)
+            config.append(Slot0, NumberList[n].assetGroup());
+        loader.prefetch(config, cubes);
+        for (unsigned frames = 0; frames < 100; ++frames)
+            System::yield();
+    }
+    for (unsigned n = 0; n < arraysize(NumberList); n++)
+        ASSERT(NumberList[n].assetGroup().isInstalled(cubes) == false);
+    ASSERT(Slot0.tilesFree() == 4096);
+}
+
+
 bool findVolumeInSysLFS(Volume v)
 {
     unsigned result = false;
@@ -466,6 +575,7 @@ void main()
     testEviction();
     testCancel();
     testFull();
+    testPrefetch();
     testVolumeCleanup();
     
     LOG("Success.\n");
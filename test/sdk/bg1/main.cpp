@@ -24,6 +24,37 @@ void testMaskedImage()
     }
 }
 
+void testAutoWindow()
+{
+    vid.initMode(BG0);
+    vid.bg0.erase(Background);
+    vid.setAutoWindow();
+
+    // Mode change; the first frame is always drawn in full
+    System::paint();
+    System::finish();
+    ASSERT(vid.sys.vbuf.vram.num_lines == LCD_height);
+
+    // Change one tile in the top row. Only those 8 lines are redrawn.
+    SCRIPT(LUA, before = cube:lcdHash());
+    vid.bg0.plot(vec(3,0), Animation.tile(cube, vec(8,8)));
+    System::paint();
+    System::finish();
+    ASSERT(vid.sys.vbuf.vram.num_lines == 8);
+    SCRIPT(LUA,
+        partial = cube:lcdHash()
+        assert(partial ~= before, "Partial frame should have changed the display")
+    );
+
+    // A full redraw of the same VRAM must match what the partial frame left
+    vid.setAutoWindow(false);
+    vid.touch();
+    System::paint();
+    System::finish();
+    ASSERT(vid.sys.vbuf.vram.num_lines == LCD_height);
+    SCRIPT(LUA, assert(cube:lcdHash() == partial, "Partial frame doesn't match a full redraw"));
+}
+
 void main()
 {
     // Bootstrapping that would normally be done by the Launcher
@@ -57,6 +88,7 @@ void main()
     System::finish();
 
     testMaskedImage();
+    testAutoWindow();
 
     LOG("Success.\n");
 }
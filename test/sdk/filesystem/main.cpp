@@ -226,6 +226,101 @@ void testFsInfo()
     ASSERT(info.selfElfUnits == fi.selfElfUnits());
 }
 
+void testWriteBehind()
+{
+    LOG("Testing write-behind buffering\n");
+
+    StoredObject key = StoredObject::allocate();
+    uint32_t value = 0;
+
+    // Buffered writes are visible to us right away, but not yet on flash
+    StoredObject::setWriteBehind(true);
+    value = 1;
+    ASSERT(key.write(value) == sizeof value);
+    value = 0;
+    ASSERT(key.read(value) == sizeof value && value == 1);
+    SCRIPT_FMT(LUA, "assertEquals(flashValue(%d), -1)", key.sys);
+
+    // Rewriting replaces the buffered copy, and flush() saves it
+    value = 2;
+    ASSERT(key.write(value) == sizeof value);
+    value = 0;
+    ASSERT(key.read(value) == sizeof value && value == 2);
+    SCRIPT_FMT(LUA, "assertEquals(flashValue(%d), -1)", key.sys);
+    ASSERT(StoredObject::flush() == 0);
+    SCRIPT_FMT(LUA, "assertEquals(flashValue(%d), 2)", key.sys);
+
+    // Flushing an empty buffer is harmless
+    ASSERT(StoredObject::flush() == 0);
+
+    // Disabling write-behind flushes the buffer
+    value = 3;
+    ASSERT(key.write(value) == sizeof value);
+    StoredObject::setWriteBehind(false);
+    SCRIPT_FMT(LUA, "assertEquals(flashValue(%d), 3)", key.sys);
+
+    // With it disabled, writes go straight to flash
+    value = 4;
+    ASSERT(key.write(value) == sizeof value);
+    SCRIPT_FMT(LUA, "assertEquals(flashValue(%d), 4)", key.sys);
+    value = 0;
+    ASSERT(key.read(value) == sizeof value && value == 4);
+
+    ASSERT(key.erase() == 0);
+}
+
+void testIncrementalGC()
+{
+    /*
+     * Overwrite a few large objects until they span several object volumes,
+     * nearly all of it obsolete. Then leave the system idle, and let the
+     * incremental collector reclaim that space without losing anything.
+     */
+
+    LOG("Testing incremental garbage collection\n");
+
+    StoredObject keys[] = {
+        StoredObject::allocate(),
+        StoredObject::allocate(),
+        StoredObject::allocate(),
+        StoredObject::allocate(),
+    };
+    const unsigned numWrites = 100;
+
+    for (unsigned i = 0; i < numWrites; i++) {
+        for (unsigned k = 0; k < arraysize(keys); k++) {
+            objBuffer.value = i * arraysize(keys) + k;
+            ASSERT(keys[k].write(objBuffer) == sizeof objBuffer);
+        }
+        System::keepAwake();
+    }
+
+    FilesystemInfo before;
+    before.gather();
+    LOG_INT(before.selfObjUnits());
+    ASSERT(before.selfObjUnits() > 2);
+
+    // The collector takes one bounded step per second of idle time
+    FilesystemInfo after;
+    SystemTime start = SystemTime::now();
+    do {
+        System::yield();
+        after.gather();
+    } while (after.selfObjUnits() >= before.selfObjUnits()
+             && SystemTime::now() - start < 60.f);
+
+    LOG_INT(after.selfObjUnits());
+    ASSERT(after.selfObjUnits() < before.selfObjUnits());
+
+    // Only obsolete versions were thrown away
+    for (unsigned k = 0; k < arraysize(keys); k++) {
+        objBuffer.value = -1;
+        ASSERT(keys[k].read(objBuffer) == sizeof objBuffer);
+        ASSERT(objBuffer.value == int((numWrites - 1) * arraysize(keys) + k));
+        ASSERT(keys[k].erase() == 0);
+    }
+}
+
 void main()
 {
     // Initialization
@@ -237,6 +332,12 @@ void main()
     // Do some tests on our own binary
     checkSelf();
 
+    // Exercise write-behind before the object store fills up
+    testWriteBehind();
+
+    // Leave obsolete objects behind, and check that idle time cleans them up
+    testIncrementalGC();
+
     // Now start flooding the FS with object writes
     createObjects();
 
@@ -357,6 +357,27 @@ function testStoredObjects()
     end
 end
 
+function launcherVolume()
+    for i, vol in ipairs(fs:listVolumes()) do
+        if fs:volumeType(vol) == 0x4e4c then
+            return vol
+        end
+    end
+end
+
+function flashValue(key)
+    -- Read the first word of one of our stored objects, bypassing any
+    -- write-behind buffering. Returns -1 if the object isn't on flash yet.
+
+    local data = fs:readObject(launcherVolume(), key)
+    if not data or #data < 4 then
+        return -1
+    end
+
+    local b1, b2, b3, b4 = string.byte(data, 1, 4)
+    return b1 + b2 * 0x100 + b3 * 0x10000 + b4 * 0x1000000
+end
+
 function testFilesystem()
     -- Dump the volumes that existed on entry
     dumpFilesystem()
@@ -0,0 +1,98 @@
+/*
+ * Benchmark for worst-case flash stalls per frame.
+ *
+ * Runs a few flash-heavy workloads under each of the simulated flash
+ * timing models in test-flashstall.lua, ending every frame with a script
+ * call so that Lua can measure how long that frame spent blocked on flash.
+ */
+
+#include <sifteo.h>
+using namespace Sifteo;
+
+static Metadata M = Metadata::Metadata()
+    .title("Flash Stall Benchmark");
+
+static const unsigned numKeys = 8;
+
+// Small saved-game record, like a game might write every level
+static struct {
+    unsigned frame;
+    uint8_t pad[60];
+} saveData;
+
+// Large object, to fill the filesystem and force garbage collection
+static struct {
+    unsigned frame;
+    uint8_t pad[1020];
+} bulkData;
+
+
+static void endFrame()
+{
+    System::paint();
+    SCRIPT(LUA, endFrame());
+}
+
+static void saveWorkload()
+{
+    // One small save every few frames
+    SCRIPT(LUA, beginWorkload("save"));
+
+    for (unsigned frame = 0; frame < 240; ++frame) {
+        if (frame % 4 == 0) {
+            saveData.frame = frame;
+            StoredObject(frame % numKeys).write(saveData);
+        }
+        endFrame();
+    }
+
+    SCRIPT(LUA, endWorkload());
+}
+
+static void gcWorkload()
+{
+    // Large writes on every frame, until we've been through the LFS a few times
+    SCRIPT(LUA, beginWorkload("gc"));
+
+    for (unsigned frame = 0; frame < 1200; ++frame) {
+        bulkData.frame = frame;
+        StoredObject(frame % numKeys).write(bulkData);
+        endFrame();
+    }
+
+    SCRIPT(LUA, endWorkload());
+}
+
+static void installWorkload()
+{
+    // Lua writes one volume per frame, like the launcher would during an install
+    SCRIPT(LUA, beginWorkload("install"));
+
+    for (unsigned frame = 0; frame < 16; ++frame) {
+        SCRIPT(LUA, installStep());
+        endFrame();
+    }
+
+    SCRIPT(LUA, endWorkload());
+}
+
+void main()
+{
+    SCRIPT(LUA,
+        package.path = package.path .. ";../../lib/?.lua"
+        require('test-flashstall')
+    );
+
+    // Must match the list of models in test-flashstall.lua
+    const unsigned numModels = 3;
+
+    for (unsigned model = 0; model < numModels; ++model) {
+        SCRIPT_FMT(LUA, "useModel(%d)", model + 1);
+        saveWorkload();
+        gcWorkload();
+        installWorkload();
+    }
+
+    SCRIPT(LUA, printResults());
+    LOG("Success.\n");
+}
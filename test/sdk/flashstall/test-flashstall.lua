@@ -0,0 +1,83 @@
+--[[
+    Lua code specific to the "flashstall" SDK test.
+
+    The game runs each workload once per flash timing model. We sample
+    Filesystem():flashStalls() at the end of every frame, and report the
+    worst and average time per frame that the Base spent blocked on flash.
+]]--
+
+require('siftulator')
+
+System():setOptions{ turbo=true, numCubes=0 }
+fs = Filesystem()
+
+TEST_VOL_TYPE = 0x8765
+INSTALL_SIZE = 48 * 1024
+
+MODELS = {
+    { name="typical", params={} },
+    { name="async", params={ async=true, variation=true, seed=1234 } },
+    { name="suspend", params={ async=true, eraseSuspend=true, variation=true, seed=1234 } },
+}
+
+results = {}
+installed = {}
+
+
+function useModel(index)
+    model = MODELS[index]
+    fs:setFlashTiming(model.params)
+end
+
+
+function beginWorkload(name)
+    workload = { model=model.name, name=name, frames=0, worst=0, total=0, ops=0 }
+
+    -- Discard anything left over from before this workload
+    fs:flashStalls()
+end
+
+
+function endFrame()
+    local s = fs:flashStalls()
+
+    assert(s.total >= s.longest)
+    assert(s.count > 0 or s.total == 0)
+
+    workload.frames = workload.frames + 1
+    workload.total = workload.total + s.total
+    workload.ops = workload.ops + s.count
+    workload.worst = math.max(workload.worst, s.total)
+end
+
+
+function endWorkload()
+    assert(workload.frames > 0)
+    table.insert(results, workload)
+
+    for i, vol in ipairs(installed) do
+        fs:deleteVolume(vol)
+    end
+    installed = {}
+end
+
+
+function installStep()
+    local vol = fs:newVolume(TEST_VOL_TYPE, string.rep(string.char(#installed), INSTALL_SIZE))
+    assert(vol)
+    table.insert(installed, vol)
+end
+
+
+function printResults()
+    print("")
+    print(" Model      Workload   Frames   Stalls   Worst/frame    Mean/frame")
+    print("---------------------------------------------------------------------")
+
+    for i, r in ipairs(results) do
+        print(string.format(" %-10s %-10s %6d %8d %10.3f ms %10.3f ms",
+            r.model, r.name, r.frames, r.ops, r.worst * 1e3, r.total * 1e3 / r.frames))
+    end
+
+    print("")
+end
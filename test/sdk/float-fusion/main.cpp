@@ -0,0 +1,109 @@
+/*
+ * Test for slinky's float expression fusion.
+ *
+ * This program is linked twice, with and without -disable-float-fusion.
+ * Each expression below is written once as plain C++, which slinky fuses
+ * into a single _SYS_fexprf() call, and once with every operation kept
+ * apart. Both builds must produce identical results, including for
+ * NaN, infinite, and denormal inputs.
+ */
+
+#include <sifteo.h>
+using namespace Sifteo;
+
+static Metadata M = Metadata::Metadata()
+    .title("Float fusion test");
+
+// Optimization barrier
+template <typename T> T b(T x) {
+    volatile T y = x;
+    return y;
+}
+
+// Single float operations. Storing each result keeps them from being fused.
+float fadd(float x, float y) { return b(x + y); }
+float fsub(float x, float y) { return b(x - y); }
+float fmul(float x, float y) { return b(x * y); }
+float fdiv(float x, float y) { return b(x / y); }
+
+// Bit-exact float comparison. Any two NaNs are considered equal.
+bool same(float x, float y)
+{
+    if (isunordered(x) || isunordered(y))
+        return isunordered(x) && isunordered(y);
+    return reinterpret_cast<uint32_t&>(x) == reinterpret_cast<uint32_t&>(y);
+}
+
+// Interesting inputs, including denormals, infinities, and NaN
+float specialValue(unsigned i)
+{
+    switch (i % 12) {
+        default:
+        case 0:     return b(0.f);
+        case 1:     return b(-0.f);
+        case 2:     return b(1.f);
+        case 3:     return b(-2.5f);
+        case 4:     return b(3.14159f);
+        case 5:     return b(1e-40f);           // Denormal
+        case 6:     return b(-1.5e-42f);        // Denormal
+        case 7:     return b(1e30f);            // Products overflow
+        case 8:     return b(-7e-20f);          // Products underflow
+        case 9:     return b(50.f) / b(0.f);    // +Infinity
+        case 10:    return b(-50.f) / b(0.f);   // -Infinity
+        case 11:    return b(NAN);
+    }
+}
+
+void testExpressions(float a, float c, float d, float x)
+{
+    // Mixed operators
+    ASSERT(same((a + c) * (d - x) / c,
+                fdiv(fmul(fadd(a, c), fsub(d, x)), c)));
+
+    // Quadratic, with repeated inputs
+    ASSERT(same(a * x * x + c * x + d,
+                fadd(fadd(fmul(fmul(a, x), x), fmul(c, x)), d)));
+
+    // Operand order matters for rounding; this must not be reassociated
+    ASSERT(same(a + (c + (d + x)),
+                fadd(a, fadd(c, fadd(d, x)))));
+
+    // An intermediate with two uses is computed once, outside the tree
+    float t = a * c - d;
+    ASSERT(same(t * t + t / x,
+                fadd(fmul(fsub(fmul(a, c), d), fsub(fmul(a, c), d)),
+                     fdiv(fsub(fmul(a, c), d), x))));
+
+    // A long chain, close to the register limit
+    float s = (a * c + d) * x;
+    s = ((s + a) * c + d) * x;
+    s = ((s + a) * c + d) * x;
+    s = ((s + a) * c + d) * x;
+    s = ((s + a) * c + d) * x;
+
+    float r = fmul(fadd(fmul(a, c), d), x);
+    for (unsigned i = 0; i < 4; ++i)
+        r = fmul(fadd(fmul(fadd(r, a), c), d), x);
+    ASSERT(same(s, r));
+}
+
+void main()
+{
+    uint32_t checksum = 0;
+
+    for (unsigned i = 0; i < 12 * 12 * 12; ++i) {
+        float a = specialValue(i);
+        float c = specialValue(i / 12);
+        float d = specialValue(i / 144);
+        float x = specialValue(i * 5 + 7);
+
+        testExpressions(a, c, d, x);
+
+        float r = (a - c) * (d + x) + a / x;
+        checksum = (checksum << 1 | checksum >> 31) ^ reinterpret_cast<uint32_t&>(r);
+    }
+
+    // Printed for comparison between the two builds
+    LOG("Float fusion checksum: %08x\n", checksum);
+    LOG("Success.\n");
+}
@@ -0,0 +1,115 @@
+#include <sifteo.h>
+using namespace Sifteo;
+
+/*
+ * Check FBDrawable's masked writes and bitmap blits against a simple
+ * reference that draws one pixel at a time into a plain byte array.
+ */
+
+static VideoBuffer vid;
+static uint8_t reference[_SYS_VRAM_BYTES];
+static Random rng(1234);
+
+// Some arbitrary source data in flash, for bitmaps
+static const uint8_t flashBitmap[] = {
+    0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0, 0x0f, 0xed, 0xcb, 0xa9,
+    0x87, 0x65, 0x43, 0x21, 0xff, 0x00, 0xaa, 0x55, 0x01, 0x80, 0x7e, 0xe7,
+    0x3c, 0xc3, 0x99, 0x66, 0x10, 0x20, 0x40, 0x80, 0x11, 0x22, 0x44, 0x88,
+    0xa5, 0x5a, 0x0f, 0xf0, 0x33, 0xcc, 0x69, 0x96, 0x13, 0x57, 0x9b, 0xdf,
+};
+
+template <typename T>
+void refPlot(T &fb, unsigned x, unsigned y, unsigned color)
+{
+    unsigned bit = fb.bitAddr(vec(x, y));
+    unsigned mask = ((1 << fb.bitsPerPixel()) - 1) << (bit & 7);
+    uint8_t &byte = reference[bit >> 3];
+    byte = (byte & ~mask) | ((color << (bit & 7)) & mask);
+}
+
+template <typename T>
+unsigned refSourcePixel(T &fb, const uint8_t *data, unsigned x)
+{
+    unsigned bit = x * fb.bitsPerPixel();
+    return (data[bit >> 3] >> (bit & 7)) & ((1 << fb.bitsPerPixel()) - 1);
+}
+
+template <typename T>
+void check(T &fb)
+{
+    for (unsigned i = 0; i < fb.sizeInBytes(); ++i)
+        ASSERT(_SYS_vbuf_peekb(vid, i) == reference[i]);
+}
+
+template <typename T>
+void testDrawable(T &fb)
+{
+    const unsigned w = fb.width();
+    const unsigned h = fb.height();
+
+    vid.erase();
+    memset8(reference, 0, sizeof reference);
+
+    // Single pixels
+    for (unsigned i = 0; i < 500; ++i) {
+        unsigned x = rng.randrange(w), y = rng.randrange(h);
+        unsigned color = rng.randrange(fb.numColors());
+        fb.plot(vec(x, y), color);
+        refPlot(fb, x, y, color);
+    }
+    check(fb);
+
+    // Horizontal spans
+    for (unsigned i = 0; i < 200; ++i) {
+        unsigned x = rng.randrange(w), y = rng.randrange(h);
+        unsigned width = rng.randrange(w - x + 1);
+        unsigned color = rng.randrange(fb.numColors());
+        fb.span(vec(x, y), width, color);
+        for (unsigned j = 0; j < width; ++j)
+            refPlot(fb, x + j, y, color);
+    }
+    check(fb);
+
+    // Bitmaps at every alignment, from both RAM and flash
+    uint8_t ramBitmap[sizeof flashBitmap];
+    for (unsigned i = 0; i < sizeof ramBitmap; ++i)
+        ramBitmap[i] = rng.raw();
+
+    for (unsigned i = 0; i < 200; ++i) {
+        const uint8_t *data = (i & 1) ? ramBitmap : flashBitmap;
+        unsigned stride = 1 + rng.randrange(8u);
+        unsigned maxWidth = stride * 8 / fb.bitsPerPixel();
+        unsigned x = rng.randrange(w), y = rng.randrange(h);
+        unsigned width = rng.randrange(MIN(maxWidth, w - x) + 1);
+        unsigned height = rng.randrange(MIN(h - y, sizeof flashBitmap / stride) + 1);
+
+        if (i & 2) {
+            fb.bitmap(vec(x, y), vec(width, height), data, stride);
+        } else {
+            height = MIN(height, 1u);
+            if (height)
+                fb.bitmapSpan(vec(x, y), width, data);
+        }
+
+        for (unsigned row = 0; row < height; ++row)
+            for (unsigned j = 0; j < width; ++j)
+                refPlot(fb, x + j, y + row, refSourcePixel(fb, data + row * stride, j));
+    }
+    check(fb);
+}
+
+void main()
+{
+    _SYS_vbuf_init(vid);
+
+    testDrawable(vid.fb32);
+    testDrawable(vid.fb64);
+    testDrawable(vid.fb128);
+    testDrawable(vid.stamp.getFB<16, 24>());
+
+    // STAMP lines needn't be a whole number of 16-bit words
+    testDrawable(vid.stamp.getFB<6, 20>());
+    testDrawable(vid.stamp.getFB<10, 12>());
+
+    LOG("Success.\n");
+}
@@ -1,4 +1,5 @@
 #include <sifteo/math.h>
+#include <sifteo/fixed.h>
 using namespace Sifteo;
 
 // Optimization barrier
@@ -260,6 +261,301 @@ void testTrigTables()
     }
 }
 
+/*
+ * Single float operations, one system call each. Storing every result
+ * through b() keeps slinky from fusing these into _SYS_fexprf(), so they
+ * are a reference for the batched syscalls.
+ */
+float fadd(float x, float y) { return b(x + y); }
+float fsub(float x, float y) { return b(x - y); }
+float fmul(float x, float y) { return b(x * y); }
+float fdiv(float x, float y) { return b(x / y); }
+
+// Bit-exact float comparison. Any two NaNs are considered equal.
+bool same(float x, float y)
+{
+    if (isunordered(x) || isunordered(y))
+        return isunordered(x) && isunordered(y);
+    return reinterpret_cast<uint32_t&>(x) == reinterpret_cast<uint32_t&>(y);
+}
+
+bool same(Float2 u, Float2 v)
+{
+    return same(u.x, v.x) && same(u.y, v.y);
+}
+
+bool same(Float3 u, Float3 v)
+{
+    return same(u.x, v.x) && same(u.y, v.y) && same(u.z, v.z);
+}
+
+// Interesting inputs, including denormals, infinities, and NaN
+float specialValue(unsigned i)
+{
+    switch (i % 12) {
+        default:
+        case 0:     return b(0.f);
+        case 1:     return b(-0.f);
+        case 2:     return b(1.f);
+        case 3:     return b(-2.5f);
+        case 4:     return b(3.14159f);
+        case 5:     return b(1e-40f);           // Denormal
+        case 6:     return b(-1.5e-42f);        // Denormal
+        case 7:     return b(1e30f);            // Products overflow
+        case 8:     return b(-7e-20f);          // Products underflow
+        case 9:     return b(50.f) / b(0.f);    // +Infinity
+        case 10:    return b(-50.f) / b(0.f);   // -Infinity
+        case 11:    return b(NAN);
+    }
+}
+
+void testVecMath()
+{
+    /*
+     * The batched vector math syscalls must match the same formulas
+     * evaluated one operation at a time, bit for bit.
+     */
+
+    for (unsigned i = 0; i < 12 * 12 * 12; ++i) {
+        float ax = specialValue(i);
+        float ay = specialValue(i / 12);
+        float az = specialValue(i / 144);
+        float bx = specialValue(i * 7 + 3);
+        float by = specialValue(i * 5 + 1);
+        float bz = specialValue(i / 12 + i);
+
+        Float2 a2 = vec(ax, ay), b2 = vec(bx, by);
+        Float3 a3 = vec(ax, ay, az), b3 = vec(bx, by, bz);
+
+        // Dot products
+        ASSERT(same(dot(a2, b2), fadd(fmul(ax, bx), fmul(ay, by))));
+        ASSERT(same(dot(a3, b3), fadd(fadd(fmul(ax, bx), fmul(ay, by)), fmul(az, bz))));
+
+        // Cross product
+        ASSERT(same(cross(a3, b3), vec(fsub(fmul(ay, bz), fmul(az, by)),
+                                       fsub(fmul(az, bx), fmul(ax, bz)),
+                                       fsub(fmul(ax, by), fmul(ay, bx)))));
+
+        // Normalization
+        float len2 = sqrt(fadd(fmul(ax, ax), fmul(ay, ay)));
+        ASSERT(same(a2.normalize(), vec(fdiv(ax, len2), fdiv(ay, len2))));
+
+        float len3 = sqrt(fadd(fadd(fmul(ax, ax), fmul(ay, ay)), fmul(az, az)));
+        ASSERT(same(a3.normalize(), vec(fdiv(ax, len3), fdiv(ay, len3), fdiv(az, len3))));
+
+        // Affine transform
+        AffineMatrix m(ax, ay, az,
+                       bx, by, bz);
+        Float2 p = vec(specialValue(i + 5), specialValue(i * 3));
+        ASSERT(same(m.transform(p), vec(fadd(fadd(fmul(ax, p.x), fmul(ay, p.y)), az),
+                                        fadd(fadd(fmul(bx, p.x), fmul(by, p.y)), bz))));
+
+        // Polynomials, with up to 6 coefficients
+        const float coeff[] = { ax, ay, az, bx, by, bz };
+        float x = specialValue(i * 11 + 4);
+        unsigned count = 1 + i % arraysize(coeff);
+        float r = coeff[count - 1];
+        for (unsigned j = count - 1; j--;)
+            r = fadd(fmul(r, x), coeff[j]);
+        ASSERT(same(poly(x, coeff, count), r));
+    }
+}
+
+void testFExpr()
+{
+    /*
+     * Hand-assembled _SYS_fexprf() programs, compared against the same
+     * operations performed one at a time.
+     */
+
+    // (r0 + r1) * (r2 - r3) / r1
+    static const uint8_t program[] = {
+        _SYS_FEXPR_ADD, 0, 1,       // r4 = r0 + r1
+        _SYS_FEXPR_SUB, 2, 3,       // r5 = r2 - r3
+        _SYS_FEXPR_MUL, 4, 5,       // r6 = r4 * r5
+        _SYS_FEXPR_DIV, 6, 1,       // r7 = r6 / r1
+    };
+
+    for (unsigned i = 0; i < 12 * 12 * 12; ++i) {
+        float in[4] = {
+            specialValue(i),
+            specialValue(i / 12),
+            specialValue(i / 144),
+            specialValue(i * 7 + 2),
+        };
+
+        uint32_t bits = _SYS_fexprf(program, sizeof program, in, arraysize(in));
+        float expected = fdiv(fmul(fadd(in[0], in[1]), fsub(in[2], in[3])), in[1]);
+        ASSERT(same(reinterpret_cast<float&>(bits), expected));
+    }
+}
+
+void testFixedConversion()
+{
+    ASSERT(Fix16(b(3)).raw == 0x30000);
+    ASSERT(Fix16(b(-2)).raw == -0x20000);
+    ASSERT(Fix16(b(0.5f)).raw == 0x8000);
+    ASSERT(Fix16(b(-0.25f)).raw == -0x4000);
+    ASSERT(Fix16(b(1.0 / 3.0)).raw == 0x5555);
+    ASSERT(Fix16(b(2.75f)).toFloat() == 2.75f);
+    ASSERT(Fix8(b(1.5f)).raw == 0x180);
+
+    ASSERT(Fix16::fromRatio(b(1), b(3)).raw == 0x5555);
+    ASSERT(Fix16::fromRatio(b(-7), b(2)).raw == -0x38000);
+
+    // toInt() rounds down, round() rounds halfway cases up
+    ASSERT(Fix16::fromRaw(b(0x18000)).toInt() == 1);
+    ASSERT(Fix16::fromRaw(b(-0x18000)).toInt() == -2);
+    ASSERT(Fix16::fromRaw(b(0x18000)).round() == 2);
+    ASSERT(Fix16::fromRaw(b(0x17fff)).round() == 1);
+    ASSERT(Fix16::fromRaw(b(-0x18000)).round() == -1);
+
+    ASSERT((Fix16(b(1.5f)).convert<int16_t, 8, false>().raw == 0x180));
+    ASSERT((Fix8::fromRaw(b(0x181)).convert<int32_t, 16, false>().raw == 0x18100));
+}
+
+void testFixedArithmetic()
+{
+    Fix16 a = b(2.5f);
+    Fix16 c = b(-0.75f);
+
+    ASSERT((a + c).raw == 0x1c000);
+    ASSERT((a - c).raw == 0x34000);
+    ASSERT((a * c).raw == -0x1e000);
+    ASSERT((a / c).raw == -0x35555);
+    ASSERT((-a).raw == -0x28000);
+
+    ASSERT((a * 3).raw == 0x78000);
+    ASSERT((3 * a).raw == 0x78000);
+    ASSERT((a / 2).raw == 0x14000);
+    ASSERT((a * 0.5f).raw == 0x14000);
+    ASSERT((a / 0.5f).raw == 0x50000);
+    ASSERT((a << 2).raw == 0xa0000);
+    ASSERT((a >> 1).raw == 0x14000);
+
+    Fix16 d = a;
+    d += c;
+    d -= c;
+    ASSERT(d == a);
+    d *= c;
+    ASSERT(d == a * c);
+    d /= c;
+    ASSERT(d == a);
+
+    ASSERT(c < a && a > c && a >= a && c <= c && a != c);
+
+    // Products round toward negative infinity, like a wide multiply
+    ASSERT((Fix16::fromRaw(b(1)) * Fix16::fromRaw(b(-1))).raw == -1);
+
+    // The 32-bit partial product multiply must match the 64-bit one
+    uint32_t seed = 1;
+    for (unsigned i = 0; i < 1000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        int32_t x = int32_t(seed) >> 9;
+        seed = seed * 1103515245 + 12345;
+        int32_t y = int32_t(seed) >> 9;
+
+        ASSERT((Fix16::fromRaw(x) * Fix16::fromRaw(y)).raw ==
+               (SatFix16::fromRaw(x) * SatFix16::fromRaw(y)).raw);
+    }
+}
+
+void testFixedOverflow()
+{
+    // Plain types wrap around
+    ASSERT(Fix16::maximum() + Fix16::fromRaw(b(1)) == Fix16::minimum());
+    ASSERT((Fix8(b(100)) * 2).raw == -14336);
+
+    // Saturating types clamp
+    ASSERT(SatFix16::maximum() + SatFix16::fromRaw(b(1)) == SatFix16::maximum());
+    ASSERT(SatFix16::minimum() - SatFix16::fromRaw(b(1)) == SatFix16::minimum());
+    ASSERT(-SatFix16::minimum() == SatFix16::maximum());
+    ASSERT(SatFix16(b(30000)) * SatFix16(b(3)) == SatFix16::maximum());
+    ASSERT(SatFix16(b(-30000)) * 3 == SatFix16::minimum());
+    ASSERT(SatFix16(b(1)) / SatFix16::fromRaw(b(1)) == SatFix16::maximum());
+    ASSERT(SatFix16(b(40000)) == SatFix16::maximum());
+    ASSERT(SatFix16(b(-40000)) == SatFix16::minimum());
+    ASSERT(SatFix16(b(1e6f)) == SatFix16::maximum());
+    ASSERT(SatFix8(b(100)) * 2 == SatFix8::maximum());
+    ASSERT(SatFix8(b(-100)) * 2 == SatFix8::minimum());
+}
+
+void testFixedSqrt()
+{
+    ASSERT(sqrt(Fix16(b(4))) == Fix16(2));
+    ASSERT(sqrt(Fix16(b(2))).raw == 92681);
+    ASSERT(sqrt(Fix16::fromRaw(b(1))).raw == 256);
+    ASSERT(sqrt(Fix16(b(0))).raw == 0);
+    ASSERT(sqrt(Fix16(b(-1))).raw == 0);
+    ASSERT(sqrt(Fix8(b(9))) == Fix8(3));
+
+    for (unsigned i = 0; i < 1000; ++i) {
+        Fix16 x = Fix16::fromRaw(b(i * 2147483U));
+        ASSERT(almostEqual(sqrt(x).toFloat(), sqrt(x.toFloat()), 1e-4f));
+    }
+}
+
+void testFixedTrig()
+{
+    ASSERT(tsin(Fix16(b(0))).raw == 0);
+    ASSERT(tcos(Fix16(b(0))) == Fix16(1));
+    ASSERT(tcos(Fix8(b(0))) == Fix8(1));
+
+    for (int i = -1000; i < 1000; ++i) {
+        Fix16 r16 = Fix16::fromRatio(i, 100);
+        ASSERT(almostEqual(tsin(r16).toFloat(), sin(r16.toFloat()), 2e-3f));
+        ASSERT(almostEqual(tcos(r16).toFloat(), cos(r16.toFloat()), 2e-3f));
+
+        Fix8 r8 = Fix8::fromRatio(i, 100);
+        ASSERT(almostEqual(tsin(r8).toFloat(), sin(r8.toFloat()), 1e-2f));
+        ASSERT(almostEqual(tcos(r8).toFloat(), cos(r8.toFloat()), 1e-2f));
+    }
+}
+
+void testFixedVectors()
+{
+    Fix16Vec2 v = vec(Fix16(b(3)), Fix16(b(-4)));
+
+    ASSERT(v.len() == Fix16(5));
+    ASSERT(v.normalize() == vec(Fix16::fromRaw(39321), Fix16::fromRaw(-52428)));
+
+    ASSERT(v * Fix16(b(0.5f)) == vec(Fix16(1.5f), Fix16(-2)));
+    ASSERT(Fix16(b(2)) * v == vec(Fix16(6), Fix16(-8)));
+    ASSERT(v / Fix16(b(0.5f)) == vec(Fix16(6), Fix16(-8)));
+    ASSERT(v * b(2) == vec(Fix16(6), Fix16(-8)));
+    ASSERT(b(2) * v == vec(Fix16(6), Fix16(-8)));
+    ASSERT(v / b(2) == vec(Fix16(1.5f), Fix16(-2)));
+
+    Fix16Vec2 w = v;
+    w *= Fix16(b(2));
+    ASSERT(w == vec(Fix16(6), Fix16(-8)));
+    w *= b(-1);
+    ASSERT(w == vec(Fix16(-6), Fix16(8)));
+
+    ASSERT(toFloat(v) == vec(3.f, -4.f));
+    ASSERT(toInt(vec(Fix16(b(1.5f)), Fix16(b(-1.5f)))) == vec(1, -2));
+
+    Fix16Vec3 u = vec(Fix16(b(1)), Fix16(b(2)), Fix16(b(2)));
+
+    ASSERT(u.len() == Fix16(3));
+    ASSERT(u * Fix16(b(0.5f)) == vec(Fix16(0.5f), Fix16(1), Fix16(1)));
+    ASSERT(Fix16(b(3)) * u == vec(Fix16(3), Fix16(6), Fix16(6)));
+    ASSERT(u / Fix16(b(2)) == vec(Fix16(0.5f), Fix16(1), Fix16(1)));
+    ASSERT(u * b(2) == vec(Fix16(2), Fix16(4), Fix16(4)));
+    ASSERT(b(2) * u == vec(Fix16(2), Fix16(4), Fix16(4)));
+    ASSERT(u / b(2) == vec(Fix16(0.5f), Fix16(1), Fix16(1)));
+
+    Fix16Vec3 t = u;
+    t *= Fix16(b(-1));
+    t *= b(2);
+    ASSERT(t == vec(Fix16(-2), Fix16(-4), Fix16(-4)));
+
+    Fix8Vec2 s = vec(Fix8(b(6)), Fix8(b(8)));
+    ASSERT(s.len() == Fix8(10));
+    ASSERT(s * Fix8(b(0.25f)) == vec(Fix8(1.5f), Fix8(2)));
+    ASSERT(s / b(4) == vec(Fix8(1.5f), Fix8(2)));
+}
+
 void main()
 {
     testClamp();
@@ -272,6 +568,14 @@ void main()
     testBits();
     testTrig();
     testTrigTables();
+    testVecMath();
+    testFExpr();
+    testFixedConversion();
+    testFixedArithmetic();
+    testFixedOverflow();
+    testFixedSqrt();
+    testFixedTrig();
+    testFixedVectors();
 
     LOG("Success.\n");
 }
\ No newline at end of file
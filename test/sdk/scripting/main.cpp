@@ -13,6 +13,29 @@ void luaSetInteger(const char *varName, int value)
     SCRIPT_FMT(LUA, "%s = %d", varName, value);
 }
 
+void testSyscallStats()
+{
+    SCRIPT(LUA,
+        System():setOptions{ svmSyscallStats = true }
+        Runtime():resetSyscallStats()
+    );
+
+    // Pure computation, which is only charged the fixed per-call overhead
+    volatile float x = 2.0f;
+    for (unsigned i = 0; i < 10; ++i)
+        x = sqrt(x);
+
+    SCRIPT(LUA, stats = Runtime():syscallStats()._SYS_sqrtf);
+    ASSERT(luaGetInteger("stats.calls") == 10);
+    ASSERT(luaGetInteger("stats.busyTicks") > 0);
+    ASSERT(luaGetInteger("stats.ticks") >= luaGetInteger("stats.busyTicks"));
+
+    SCRIPT(LUA, Runtime():resetSyscallStats());
+    ASSERT(luaGetInteger("Runtime():syscallStats()._SYS_sqrtf == nil and 1 or 0") == 1);
+
+    SCRIPT(LUA, System():setOptions{ svmSyscallStats = false });
+}
+
 void main()
 {
     SCRIPT(LUA,
@@ -33,5 +56,7 @@ void main()
     SCRIPT(LUA, System():setOptions{ svmTrace = true });
     SCRIPT(LUA, System():setOptions{ svmTrace = false });
 
+    testSyscallStats();
+
     LOG("Success.\n");
 }
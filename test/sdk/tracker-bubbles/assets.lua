@@ -1 +1,2 @@
 TestSound = tracker{ "bubbles.xm" }
+TestSoundUnpacked = tracker{ "bubbles.xm", unpacked=true }
@@ -4,7 +4,19 @@ using namespace Sifteo;
 
 void main()
 {
-    AudioTracker::play(TestSound);
+    // The Makefile runs this twice, the second time with the same song
+    // stored unpacked. Both must produce exactly the same audio.
+
+    int unpacked;
+    SCRIPT_FMT(LUA, "Runtime():poke(%p, os.getenv('TRACKER_UNPACKED') and 1 or 0)", &unpacked);
+
+    if (unpacked) {
+        ASSERT(TestSoundUnpacked.song.flags & _SYS_XM_UNPACKED);
+        AudioTracker::play(TestSoundUnpacked);
+    } else {
+        ASSERT(!(TestSound.song.flags & _SYS_XM_UNPACKED));
+        AudioTracker::play(TestSound);
+    }
 
     // Play for a fixed and deterministic duration.
 
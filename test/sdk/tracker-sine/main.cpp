@@ -4,8 +4,16 @@ using namespace Sifteo;
 
 void main()
 {
+    SCRIPT(LUA,
+        package.path = package.path .. ";../../lib/?.lua"
+        require('test-digest')
+        startDigest()
+    );
+
     AudioTracker::play(TestSound);
 
     while (SystemTime::now().uptimeMS() < 5000)
         System::yield();
+
+    SCRIPT(LUA, checkDigest());
 }
@@ -0,0 +1,66 @@
+--[[
+    Audio digest checks for the "tracker-sine" SDK test.
+
+    The Makefile runs this test three times. The first run saves a digest
+    of the song, and the others must reproduce it exactly, both with and
+    without --waveout. Headless audio is mixed on a clock derived from
+    virtual time, so nothing about the host should leak into the result.
+]]--
+
+require('siftulator')
+require('luaunit')
+
+DIGEST_FILE = "digest.txt"
+DIGEST_WINDOW = 0.25
+
+
+function startDigest()
+    System():startAudioDigest(DIGEST_WINDOW)
+end
+
+
+function checkDigest()
+    local digest = System():audioDigest()
+    assert(#digest >= 8, "Audio digest is too short")
+
+    -- A digest must always detect a change, and say where it happened
+    local altered = {}
+    for i, hash in ipairs(digest) do
+        altered[i] = hash
+    end
+    altered[4] = "0000000000000000"
+
+    local index, seconds = System():compareAudioDigest(altered)
+    assertEquals(index, 4)
+    assertEquals(seconds, 3 * DIGEST_WINDOW)
+
+    -- Missing windows are a mismatch too, right where the shorter one ends
+    index, seconds = System():compareAudioDigest({ digest[1], digest[2] })
+    assertEquals(index, 3)
+    assertEquals(seconds, 2 * DIGEST_WINDOW)
+
+    index, seconds = System():compareAudioDigest({})
+    assertEquals(index, 1)
+    assertEquals(seconds, 0)
+
+    local f = io.open(DIGEST_FILE, "r")
+    if not f then
+        -- First run, save the reference
+        f = io.open(DIGEST_FILE, "w")
+        f:write(table.concat(digest, "\n"), "\n")
+        f:close()
+        return
+    end
+
+    local reference = {}
+    for line in f:lines() do
+        table.insert(reference, line)
+    end
+    f:close()
+
+    index, seconds = System():compareAudioDigest(reference)
+    if index then
+        error(string.format("Audio digest differs from the first run at window %d (%.2f sec)",
+            index, seconds))
+    end
+end
@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+
+#
+# Benchmark for Siftulator's GDB server. This is a small scripted GDB
+# remote protocol client, so it doesn't depend on any particular GDB build.
+# Start a headless Siftulator with a debug server, then run this against it:
+#
+#   siftulator --headless -P 2345 game.elf &
+#   python gdb-bench.py --port 2345
+#
+# We measure two things that make interactive debugging feel slow:
+#
+#   - Memory dump rate, reading all of userspace RAM. The first pass after
+#     a stop has to fetch from the target, later passes can be served from
+#     the server's snapshot.
+#
+#   - Per-step latency, for a single step followed by the register and
+#     stack reads that an IDE would do to refresh its views.
+#
+# Use --compat to stick to the packets an older stub supported (small 'm'
+# reads, 's', and acknowledgements), for comparison.
+#
+
+import socket, sys, time
+from optparse import OptionParser
+
+RAM_BASE = 0x10000
+RAM_SIZE = 32 * 1024
+REG_SP = 13
+
+class RemoteError(Exception):
+    pass
+
+class Remote:
+    def __init__(self, port):
+        self.sock = socket.create_connection(('localhost', port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.rx = bytearray()
+        self.ack = True
+        self.packetSize = 256
+        self.binaryUpload = False
+
+    def send(self, payload):
+        data = bytearray(payload.encode('latin-1') if isinstance(payload, str) else payload)
+        frame = bytearray(b'$') + data + bytearray(('#%02x' % (sum(data) & 0xff)).encode('ascii'))
+        self.sock.sendall(bytes(frame))
+
+    def recvPacket(self):
+        while True:
+            start = self.rx.find(b'$')
+            end = self.rx.find(b'#', start)
+            if start >= 0 and end >= 0 and len(self.rx) >= end + 3:
+                payload = self.rx[start + 1:end]
+                del self.rx[:end + 3]
+                if self.ack:
+                    self.sock.sendall(b'+')
+                return payload
+
+            data = self.sock.recv(65536)
+            if not data:
+                raise RemoteError("connection closed")
+            self.rx.extend(bytearray(data))
+
+    def command(self, payload):
+        self.send(payload)
+        return self.recvPacket()
+
+    def connect(self, compat):
+        features = self.command('qSupported:multiprocess+;swbreak+').decode('latin-1')
+        for feature in features.split(';'):
+            if feature.startswith('PacketSize='):
+                self.packetSize = int(feature[11:], 16)
+            if feature == 'binary-upload+':
+                self.binaryUpload = not compat
+            if feature == 'QStartNoAckMode+' and not compat:
+                if self.command('QStartNoAckMode') == b'OK':
+                    self.ack = False
+        if compat:
+            self.packetSize = 256
+        return self.command('?')
+
+    def readMemory(self, addr, size):
+        if self.binaryUpload:
+            reply = self.command('x%x,%x' % (addr, size))
+            if not reply.startswith(b'b'):
+                raise RemoteError("x packet failed: %r" % bytes(reply))
+            return unescape(reply[1:])
+
+        reply = self.command('m%x,%x' % (addr, size))
+        if len(reply) != size * 2:
+            raise RemoteError("m packet failed: %r" % bytes(reply[:16]))
+        return bytearray.fromhex(reply.decode('ascii'))
+
+    def dump(self, addr, size):
+        # Largest read that fits in one reply, assuming worst-case encoding
+        chunk = (self.packetSize - 8) // 2
+        data = bytearray()
+        while len(data) < size:
+            n = min(chunk, size - len(data))
+            data.extend(self.readMemory(addr + len(data), n))
+        return data
+
+    def step(self, compat):
+        reply = self.command('s' if compat else 'vCont;s')
+        if not reply[:1] in (b'S', b'T'):
+            raise RemoteError("unexpected stop reply: %r" % bytes(reply))
+
+    def registers(self):
+        reply = self.command('g')
+        words = bytearray.fromhex(reply.decode('ascii'))
+        return [words[i] | words[i+1] << 8 | words[i+2] << 16 | words[i+3] << 24
+                for i in range(0, len(words), 4)]
+
+
+def unescape(data):
+    out = bytearray()
+    escape = False
+    for b in bytearray(data):
+        if escape:
+            out.append(b ^ 0x20)
+            escape = False
+        elif b == 0x7d:
+            escape = True
+        else:
+            out.append(b)
+    return out
+
+
+def main():
+    parser = OptionParser()
+    parser.add_option('--port', type='int', default=2345,
+        help="TCP port of Siftulator's GDB server")
+    parser.add_option('--dumps', type='int', default=5,
+        help="Number of full RAM dumps to time")
+    parser.add_option('--steps', type='int', default=200,
+        help="Number of single steps to time")
+    parser.add_option('--compat', action='store_true',
+        help="Only use packets that older stubs supported")
+    (opts, args) = parser.parse_args()
+
+    remote = Remote(opts.port)
+    remote.connect(opts.compat)
+    print("packet size %d, binary reads %s, acks %s" % (
+        remote.packetSize, remote.binaryUpload and "on" or "off", remote.ack and "on" or "off"))
+
+    # Memory dumps. Stepping once first gives us a fresh stop, so the
+    # first dump can't be served from an old snapshot.
+    remote.step(opts.compat)
+    for i in range(opts.dumps):
+        start = time.time()
+        remote.dump(RAM_BASE, RAM_SIZE)
+        elapsed = time.time() - start
+        print("RAM dump %d: %.1f KB/s" % (i + 1, RAM_SIZE / 1024.0 / elapsed))
+
+    # Step latency, refreshing registers and the top of the stack each time
+    start = time.time()
+    for i in range(opts.steps):
+        remote.step(opts.compat)
+        regs = remote.registers()
+        sp = regs[REG_SP]
+        if RAM_BASE <= sp < RAM_BASE + RAM_SIZE - 256:
+            remote.dump(sp, 256)
+    elapsed = time.time() - start
+    print("step + registers + stack: %.3f ms per step" % (elapsed * 1000.0 / opts.steps))
+
+    remote.send('D')
+    remote.recvPacket()
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except (RemoteError, socket.error) as e:
+        sys.stderr.write("gdb-bench: %s\n" % e)
+        sys.exit(1)
@@ -0,0 +1,275 @@
+/* -*- mode: C; c-basic-offset: 4; intent-tabs-mode: nil -*-
+ *
+ * Sifteo VM (SVM) Target for LLVM
+ *
+ * Copyright <c> 2012 Sifteo, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * SVM has no floating point instructions, so every float add, subtract,
+ * multiply, or divide becomes its own system call. This pass finds trees
+ * of single-precision arithmetic within a basic block, and replaces each
+ * one with a single _SYS_fexprf() call that evaluates a small register
+ * program in the firmware.
+ *
+ * Every operation is evaluated exactly as written, with the same operands
+ * in the same order, so the results are bit-identical to the unfused code.
+ * We only fuse values that have a single use, so nothing is computed twice.
+ *
+ * Inputs are passed through one stack array per function, sized for the
+ * largest tree. Each tree's stores and call are adjacent, so the trees
+ * can safely share it.
+ */
+
+#include "Target/SVMRuntime.inc"
+#include "llvm/Pass.h"
+#include "llvm/Module.h"
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/Instructions.h"
+#include "llvm/Support/IRBuilder.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include <sifteo/abi.h>
+#include <algorithm>
+using namespace llvm;
+
+namespace llvm {
+    FunctionPass *createFloatFusionPass();
+}
+
+namespace {
+    class FloatFusionPass : public FunctionPass {
+    public:
+        static char ID;
+        FloatFusionPass()
+            : FunctionPass(ID) {}
+
+        virtual bool runOnFunction (Function &F);
+
+        virtual const char *getPassName() const {
+            return "Floating point expression fusion pass";
+        }
+
+    private:
+        // Smaller trees aren't worth the cost of storing their inputs
+        static const unsigned MIN_OPS = 3;
+
+        struct Tree {
+            SmallVector<Value*, _SYS_FEXPR_MAX_REGS> Leaves;
+            SmallVector<BinaryOperator*, _SYS_FEXPR_MAX_REGS> Ops;
+            DenseMap<Value*, unsigned> Regs;
+        };
+
+        static BinaryOperator *getFusable(Value *V);
+        static bool isRoot(BinaryOperator *I);
+        static bool isWorthFusing(const Tree &T);
+        static void findRoots(BasicBlock *BB, SmallVectorImpl<BinaryOperator*> &Roots);
+        static void collect(Value *V, BasicBlock *BB, Tree &T);
+        static void collectOperands(BinaryOperator *I, BasicBlock *BB, Tree &T);
+        static void fuse(BinaryOperator *Root, Tree &T, AllocaInst *Inputs);
+    };
+}
+
+char FloatFusionPass::ID = 0;
+
+FunctionPass *llvm::createFloatFusionPass()
+{
+    return new FloatFusionPass();
+}
+
+BinaryOperator *FloatFusionPass::getFusable(Value *V)
+{
+    BinaryOperator *I = dyn_cast<BinaryOperator>(V);
+    if (!I || !I->getType()->isFloatTy())
+        return 0;
+
+    switch (I->getOpcode()) {
+    case Instruction::FAdd:
+    case Instruction::FSub:
+    case Instruction::FMul:
+    case Instruction::FDiv:
+        return I;
+    default:
+        return 0;
+    }
+}
+
+bool FloatFusionPass::isRoot(BinaryOperator *I)
+{
+    // A tree is rooted at any fusable instruction which isn't itself
+    // the sole input to another fusable instruction in the same block.
+
+    if (!I->hasOneUse())
+        return true;
+
+    Instruction *User = dyn_cast<Instruction>(I->use_back());
+    return !User || !getFusable(User) || User->getParent() != I->getParent();
+}
+
+bool FloatFusionPass::isWorthFusing(const Tree &T)
+{
+    return T.Ops.size() >= MIN_OPS &&
+           T.Ops.size() + T.Leaves.size() <= _SYS_FEXPR_MAX_REGS;
+}
+
+void FloatFusionPass::findRoots(BasicBlock *BB, SmallVectorImpl<BinaryOperator*> &Roots)
+{
+    for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I) {
+        BinaryOperator *BO = getFusable(I);
+        if (BO && isRoot(BO))
+            Roots.push_back(BO);
+    }
+}
+
+void FloatFusionPass::collect(Value *V, BasicBlock *BB, Tree &T)
+{
+    BinaryOperator *I = getFusable(V);
+
+    if (I && I->getParent() == BB && !isRoot(I)) {
+        collectOperands(I, BB, T);
+        return;
+    }
+
+    // Anything else is an input. Inputs may repeat, but only get one register.
+    if (T.Regs.find(V) == T.Regs.end()) {
+        T.Regs[V] = T.Leaves.size();
+        T.Leaves.push_back(V);
+    }
+}
+
+void FloatFusionPass::collectOperands(BinaryOperator *I, BasicBlock *BB, Tree &T)
+{
+    // Post-order, so operands always come before the ops that use them
+    collect(I->getOperand(0), BB, T);
+    collect(I->getOperand(1), BB, T);
+    T.Ops.push_back(I);
+}
+
+void FloatFusionPass::fuse(BinaryOperator *Root, Tree &T, AllocaInst *Inputs)
+{
+    LLVMContext &Ctx = Root->getContext();
+    Module *M = Root->getParent()->getParent()->getParent();
+    Type *i8 = Type::getInt8Ty(Ctx);
+    Type *i32 = Type::getInt32Ty(Ctx);
+    Type *f32 = Type::getFloatTy(Ctx);
+    unsigned NumLeaves = T.Leaves.size();
+    unsigned NumOps = T.Ops.size();
+
+    // Ops are numbered after all of the inputs
+    for (unsigned i = 0; i != NumOps; ++i)
+        T.Regs[T.Ops[i]] = NumLeaves + i;
+
+    // Assemble the program as a constant byte array
+    std::vector<Constant*> Code;
+    for (unsigned i = 0; i != NumOps; ++i) {
+        BinaryOperator *I = T.Ops[i];
+        unsigned Op;
+
+        switch (I->getOpcode()) {
+        default:
+        case Instruction::FAdd: Op = _SYS_FEXPR_ADD; break;
+        case Instruction::FSub: Op = _SYS_FEXPR_SUB; break;
+        case Instruction::FMul: Op = _SYS_FEXPR_MUL; break;
+        case Instruction::FDiv: Op = _SYS_FEXPR_DIV; break;
+        }
+
+        Code.push_back(ConstantInt::get(i8, Op));
+        Code.push_back(ConstantInt::get(i8, T.Regs[I->getOperand(0)]));
+        Code.push_back(ConstantInt::get(i8, T.Regs[I->getOperand(1)]));
+    }
+
+    Constant *CodeConstant = ConstantArray::get(ArrayType::get(i8, Code.size()), Code);
+    GlobalVariable *GV = new GlobalVariable(*M, CodeConstant->getType(),
+                                            true, GlobalValue::PrivateLinkage,
+                                            CodeConstant, "fexpr", 0, false);
+    GV->setAlignment(1);
+
+    IRBuilder<> Builder(Root);
+    for (unsigned i = 0; i != NumLeaves; ++i)
+        Builder.CreateStore(T.Leaves[i], Builder.CreateConstGEP2_32(Inputs, 0, i));
+
+    std::vector<Type*> ArgTys;
+    ArgTys.push_back(PointerType::getUnqual(i8));
+    ArgTys.push_back(i32);
+    ArgTys.push_back(PointerType::getUnqual(f32));
+    ArgTys.push_back(i32);
+    Constant *FExprFn = M->getOrInsertFunction(SVMRT_fexprf,
+        FunctionType::get(i32, ArgTys, false));
+
+    Value *Result = Builder.CreateCall4(FExprFn,
+        Builder.CreateConstGEP2_32(GV, 0, 0),
+        ConstantInt::get(i32, Code.size()),
+        Builder.CreateConstGEP2_32(Inputs, 0, 0),
+        ConstantInt::get(i32, NumLeaves));
+
+    Root->replaceAllUsesWith(Builder.CreateBitCast(Result, f32));
+
+    // Erase in reverse, so each op's only user is already gone
+    while (!T.Ops.empty())
+        T.Ops.pop_back_val()->eraseFromParent();
+}
+
+bool FloatFusionPass::runOnFunction (Function &F)
+{
+    /*
+     * First pass, size the shared input array. Fusing a tree replaces
+     * its root with exactly one new value, so the trees we find here are
+     * the same ones we'll fuse below.
+     */
+
+    unsigned MaxLeaves = 0;
+
+    for (Function::iterator BB = F.begin(), EB = F.end(); BB != EB; ++BB) {
+        SmallVector<BinaryOperator*, 16> Roots;
+        findRoots(BB, Roots);
+
+        for (unsigned i = 0, e = Roots.size(); i != e; ++i) {
+            Tree T;
+            collectOperands(Roots[i], BB, T);
+            if (isWorthFusing(T))
+                MaxLeaves = std::max<unsigned>(MaxLeaves, T.Leaves.size());
+        }
+    }
+
+    if (!MaxLeaves)
+        return false;
+
+    AllocaInst *Inputs = new AllocaInst(
+        ArrayType::get(Type::getFloatTy(F.getContext()), MaxLeaves),
+        "fexpr.in", F.getEntryBlock().begin());
+
+    // Second pass, fuse in order so each tree sees the roots fused before it
+    for (Function::iterator BB = F.begin(), EB = F.end(); BB != EB; ++BB) {
+        SmallVector<BinaryOperator*, 16> Roots;
+        findRoots(BB, Roots);
+
+        for (unsigned i = 0, e = Roots.size(); i != e; ++i) {
+            Tree T;
+            collectOperands(Roots[i], BB, T);
+            if (isWorthFusing(T))
+                fuse(Roots[i], T, Inputs);
+        }
+    }
+
+    return true;
+}
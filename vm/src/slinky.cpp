@@ -79,6 +79,7 @@ namespace llvm {
     BasicBlockPass *createEarlyLTIPass();
     BasicBlockPass *createLateLTIPass();
     BasicBlockPass *createMisalignStackPass();
+    FunctionPass *createFloatFusionPass();
     FunctionPass *createStaticAllocaPass();
 }
 
@@ -167,6 +168,10 @@ cl::opt<bool> AsmOutput("asm",
 cl::opt<bool> NoVerify("disable-verify", cl::Hidden,
     cl::desc("Do not verify input module"));
 
+static cl::opt<bool>
+DisableFloatFusion("disable-float-fusion",
+    cl::desc("Do not combine floating point arithmetic into fused system calls"));
+
 
 static void PrepareModule(LLVMContext& Context, Module *M)
 {
@@ -334,6 +339,12 @@ static void AddPasses(PassManagerBase &PM,
     // Final optimization pass
     AddOptimizationPasses(PM, FPM, OLvl);
 
+    // Combine trees of float arithmetic into single system calls. This
+    // must come after the last optimization pass, since it hides the
+    // arithmetic from LLVM.
+    if (!DisableFloatFusion)
+        PM.add(createFloatFusionPass());
+
     // Just before code generation, make all stack allocations static.
     PM.add(createStaticAllocaPass());
 }